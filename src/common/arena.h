@@ -0,0 +1,152 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/20.
+//
+
+#ifndef WSDB_ARENA_H
+#define WSDB_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "config.h"
+#include "../../common/micro.h"
+
+namespace wsdb {
+
+/**
+ * Bump allocator for memory that lives exactly as long as a statement, e.g. records and values produced by the
+ * executor tree. Allocation only moves a cursor, individual allocations are never freed, the whole arena is released
+ * at once by Reset() or the destructor. Not thread-safe, each thread installs its own arena with ArenaScope.
+ * Since nothing is freed before the statement ends, operators keep per-row temporaries out of the arena, either by
+ * reusing a buffer for every row or by allocating them under ArenaScope(nullptr), so that the arena grows with what
+ * a plan keeps and not with the rows it streams.
+ */
+class Arena
+{
+public:
+  explicit Arena(size_t block_size = ARENA_BLOCK_SIZE) : block_size_(block_size) {}
+
+  ~Arena() = default;
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(Arena)
+
+  /**
+   * Allocate size bytes aligned to align, requests larger than a block get a block of their own
+   * @param size
+   * @param align must be a power of 2
+   * @return uninitialized memory valid until the arena is reset or destroyed
+   */
+  auto Allocate(size_t size, size_t align = alignof(std::max_align_t)) -> char *
+  {
+    auto cursor = (cursor_ + align - 1) & ~(align - 1);
+    if (blocks_.empty() || cursor + size > blocks_.back().second) {
+      auto block_size = std::max(size, block_size_);
+      blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(block_size), block_size);
+      cursor = 0;
+    }
+    cursor_ = cursor + size;
+    allocated_ += size;
+    return blocks_.back().first.get() + cursor;
+  }
+
+  /// release everything allocated so far, the first block is kept for the next statement
+  void Reset()
+  {
+    if (!blocks_.empty()) {
+      auto keep = blocks_.front().second == block_size_ ? 1 : 0;
+      blocks_.erase(blocks_.begin() + keep, blocks_.end());
+    }
+    cursor_    = 0;
+    allocated_ = 0;
+  }
+
+  /// bytes handed out since the last reset
+  [[nodiscard]] auto GetAllocatedBytes() const -> size_t { return allocated_; }
+
+  /// the arena installed on the calling thread, nullptr if allocations should go to the heap
+  static auto Current() -> Arena * { return current_; }
+
+private:
+  friend class ArenaScope;
+
+  static inline thread_local Arena *current_ = nullptr;
+
+  size_t                                                  block_size_;
+  std::vector<std::pair<std::unique_ptr<char[]>, size_t>> blocks_;
+  size_t                                                  cursor_{0};
+  size_t                                                  allocated_{0};
+};
+
+/**
+ * Install an arena on the calling thread for the lifetime of the scope, the previous one is restored afterwards.
+ * Objects allocated from the arena must be destroyed before it is reset. Installing nullptr sends allocations to the
+ * heap for the scope.
+ */
+class ArenaScope
+{
+public:
+  explicit ArenaScope(Arena *arena) : prev_(Arena::current_) { Arena::current_ = arena; }
+
+  ~ArenaScope() { Arena::current_ = prev_; }
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(ArenaScope)
+
+private:
+  Arena *prev_;
+};
+
+/**
+ * Standard allocator over an arena, deallocation is a no-op, used with std::allocate_shared to put values and their
+ * control blocks into the arena
+ */
+template <typename T>
+class ArenaAllocator
+{
+  template <typename U>
+  friend class ArenaAllocator;
+
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena *arena) : arena_(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_)  // NOLINT: rebinding must be implicit
+  {}
+
+  auto allocate(size_t n) -> T * { return reinterpret_cast<T *>(arena_->Allocate(n * sizeof(T), alignof(T))); }
+
+  void deallocate(T *, size_t) {}
+
+  template <typename U>
+  auto operator==(const ArenaAllocator<U> &other) const -> bool
+  {
+    return arena_ == other.arena_;
+  }
+
+private:
+  Arena *arena_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_ARENA_H
@@ -25,6 +25,7 @@
 #include <utility>
 
 #include "value.h"
+#include "scalar.h"
 #include "types.h"
 #include "meta.h"
 
@@ -62,7 +63,12 @@ public:
 
   Condition(CompOp op, RTField l_col, ValueSptr &r_val)
       : rval_type_(kValue), l_col_(std::move(l_col)), r_val_(r_val), op_(op)
-  {}
+  {
+    // r_scalar_ references r_val_, which is shared by all copies of this condition
+    if (r_val_ != nullptr && r_val_->GetType() != FieldType::TYPE_ARRAY) {
+      r_scalar_ = Scalar::FromValue(*r_val_);
+    }
+  }
 
   Condition(CompOp op, RTField l_col, RTField r_col)
       : rval_type_(kColumn), l_col_(std::move(l_col)), r_col_(std::move(r_col)), op_(op)
@@ -90,6 +96,13 @@ public:
     return r_val_;
   }
 
+  /// rhs value as a scalar for evaluation, not available for IN lists
+  [[nodiscard]] auto GetRScalar() const -> const Scalar &
+  {
+    WSDB_ASSERT(rval_type_ == kValue, fmt::format("should be: {}", CondRvalTypeToString(rval_type_)));
+    return r_scalar_;
+  }
+
   [[nodiscard]] auto GetOp() const -> CompOp { return op_; }
 
   [[nodiscard]] auto GetSubqueryId() const -> int32_t
@@ -116,6 +129,7 @@ private:
   RTField      l_col_{};
   RTField      r_col_{};
   ValueSptr    r_val_{nullptr};
+  Scalar       r_scalar_{};
   CompOp       op_{};
   int32_t      subquery_id_{-1};
 };
@@ -30,14 +30,45 @@ const std::string REPLACER         = "LRUReplacer";
 const size_t REPLACER_LRU_K = 10;
 /// system
 constexpr size_t MAX_REC_SIZE = 1024;
+// number of latches the slots of the pages of a table are claimed under, pages share them by page id
+constexpr size_t TABLE_PAGE_LATCH_NUM = 64;
+// number of places inserters start searching the free space map from, shared by the threads of equal id hash
+constexpr size_t FSM_HINT_NUM = 16;
 /// executor
-// 64MB, used for sort executor's buffer
+// 64MB, memory budget of a sort, larger inputs are sorted in runs of this size and merged, the fan-in of the merge
+// is the number of SPILL_BLOCK_SIZE blocks that fit in it
 constexpr size_t SORT_BUFFER_SIZE = 64 * 1024 * 1024;
-// 10-way merge sort, max tmp file to use in merge sort
-constexpr size_t SORT_WAY_NUM = 10;
+// number of workers a sort sorts the rows in its buffer with, 0 takes the workers of a query in the WorkerPool
+constexpr size_t SORT_THREAD_NUM = 0;
+// 64KB, block size of the per-statement arena holding records and values of the executor tree
+constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+// max number of rows in a batch passed between vectorized executors
+constexpr size_t BATCH_SIZE = 1024;
+// 64MB, memory budget of a hash join, partitions of the build side beyond it are spilled to temp files
+constexpr size_t HASH_JOIN_BUFFER_SIZE = 64 * 1024 * 1024;
+// number of partitions a hash join splits its inputs into, both in memory and on disk
+constexpr size_t HASH_JOIN_PARTITION_NUM = 16;
+// levels of repartitioning before a partition that still does not fit, e.g. rows of a few keys, is joined in memory
+constexpr size_t HASH_JOIN_MAX_DEPTH = 4;
+// 256KB, block size of the reads and writes of temp files executors spill rows to
+constexpr size_t SPILL_BLOCK_SIZE = 256 * 1024;
+// max number of workers running the parallel parts of a query, 0 takes one per hardware thread
+constexpr size_t MAX_WORKERS_PER_QUERY = 0;
+// number of pages in a morsel, the unit of work the workers of a parallel scan take at a time
+constexpr size_t MORSEL_PAGE_NUM = 16;
+// number of batches an exchange buffers ahead of its consumer per worker
+constexpr size_t EXCHANGE_BUFFER_BATCHES = 4;
+// 64MB, memory budget of a hash aggregation, the groups beyond it are spilled to temp files as partial aggregates
+constexpr size_t AGG_BUFFER_SIZE = 64 * 1024 * 1024;
+// number of partitions the groups of an aggregation are split into, to be merged by the workers of a parallel
+// aggregation, or spilled and aggregated one at a time
+constexpr size_t AGG_PARTITION_NUM = 16;
+// levels of repartitioning before a spilled partition that still does not fit is aggregated in memory
+constexpr size_t AGG_MAX_DEPTH = 4;
 
 const std::string DB_SUFFIX  = ".db";
 const std::string TAB_SUFFIX = ".tab";
+const std::string FSM_SUFFIX = ".fsm";
 const std::string IDX_SUFFIX = ".idx";
 const std::string TMP_SUFFIX = ".tmp";
 
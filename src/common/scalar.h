@@ -0,0 +1,230 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/21.
+//
+
+#ifndef WSDB_SCALAR_H
+#define WSDB_SCALAR_H
+
+#include <cstring>
+#include <string_view>
+#include "value.h"
+
+namespace wsdb {
+
+/**
+ * Compact by-value counterpart of Value for the expression and comparison hot paths, no allocation, no virtual call
+ * and no dynamic cast. Ints, floats and bools are stored inline, strings are views into memory owned by someone else,
+ * e.g. a record or a StringValue, so a Scalar must not outlive the memory it was built from. Convert from and to
+ * ValueSptr only at API boundaries.
+ */
+class Scalar
+{
+public:
+  Scalar() = default;
+
+  static auto Null(FieldType type) -> Scalar
+  {
+    Scalar s;
+    s.type_    = type;
+    s.is_null_ = true;
+    return s;
+  }
+
+  static auto Int(int32_t value) -> Scalar
+  {
+    Scalar s;
+    s.type_     = FieldType::TYPE_INT;
+    s.val_.int_ = value;
+    return s;
+  }
+
+  static auto Float(float value) -> Scalar
+  {
+    Scalar s;
+    s.type_       = FieldType::TYPE_FLOAT;
+    s.val_.float_ = value;
+    return s;
+  }
+
+  static auto Bool(bool value) -> Scalar
+  {
+    Scalar s;
+    s.type_      = FieldType::TYPE_BOOL;
+    s.val_.bool_ = value;
+    return s;
+  }
+
+  static auto String(std::string_view value) -> Scalar
+  {
+    Scalar s;
+    s.type_           = FieldType::TYPE_STRING;
+    s.val_.str_.data_ = value.data();
+    s.val_.str_.size_ = value.size();
+    return s;
+  }
+
+  /**
+   * Read a scalar from raw field memory, strings are viewed in place and cut at the first '\0' like StringValue
+   * @param type
+   * @param mem
+   * @param size field size, only used by strings
+   */
+  static auto FromMem(FieldType type, const char *mem, size_t size) -> Scalar
+  {
+    switch (type) {
+      case FieldType::TYPE_BOOL: return Bool(*reinterpret_cast<const bool *>(mem));
+      case FieldType::TYPE_INT: return Int(*reinterpret_cast<const int32_t *>(mem));
+      case FieldType::TYPE_FLOAT: return Float(*reinterpret_cast<const float *>(mem));
+      case FieldType::TYPE_STRING: return String({mem, strnlen(mem, size)});
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+  /// view a Value as a scalar, a string scalar references the string inside value
+  static auto FromValue(const Value &value) -> Scalar
+  {
+    if (value.IsNull()) {
+      return Null(value.GetType());
+    }
+    // the type tag tells the dynamic type, no need to pay for dynamic_cast
+    switch (value.GetType()) {
+      case FieldType::TYPE_BOOL: return Bool(static_cast<const BoolValue &>(value).Get());
+      case FieldType::TYPE_INT: return Int(static_cast<const IntValue &>(value).Get());
+      case FieldType::TYPE_FLOAT: return Float(static_cast<const FloatValue &>(value).Get());
+      case FieldType::TYPE_STRING: return String(static_cast<const StringValue &>(value).Get());
+      default: WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(value.GetType()));
+    }
+  }
+
+  [[nodiscard]] auto ToValue() const -> ValueSptr
+  {
+    if (is_null_) {
+      return ValueFactory::CreateNullValue(type_);
+    }
+    switch (type_) {
+      case FieldType::TYPE_BOOL: return ValueFactory::CreateBoolValue(val_.bool_);
+      case FieldType::TYPE_INT: return ValueFactory::CreateIntValue(val_.int_);
+      case FieldType::TYPE_FLOAT: return ValueFactory::CreateFloatValue(val_.float_);
+      case FieldType::TYPE_STRING: return ValueFactory::CreateStringValue(val_.str_.data_, val_.str_.size_);
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+  [[nodiscard]] auto GetType() const -> FieldType { return type_; }
+
+  [[nodiscard]] auto IsNull() const -> bool { return is_null_; }
+
+  [[nodiscard]] auto GetInt() const -> int32_t { return val_.int_; }
+
+  [[nodiscard]] auto GetFloat() const -> float { return val_.float_; }
+
+  [[nodiscard]] auto GetBool() const -> bool { return val_.bool_; }
+
+  [[nodiscard]] auto GetString() const -> std::string_view { return {val_.str_.data_, val_.str_.size_}; }
+
+  /**
+   * Three-way comparison of two non-null scalars, int and float are compared as float like ValueFactory::AlignTypes,
+   * other type mismatches throw WSDB_TYPE_MISSMATCH
+   * @return negative, 0 or positive as lhs is less than, equal to or greater than rhs
+   */
+  static auto Compare(const Scalar &lhs, const Scalar &rhs) -> int
+  {
+    if (lhs.type_ == rhs.type_) {
+      switch (lhs.type_) {
+        case FieldType::TYPE_BOOL: return static_cast<int>(lhs.val_.bool_) - static_cast<int>(rhs.val_.bool_);
+        case FieldType::TYPE_INT: return (lhs.val_.int_ > rhs.val_.int_) - (lhs.val_.int_ < rhs.val_.int_);
+        case FieldType::TYPE_FLOAT: return (lhs.val_.float_ > rhs.val_.float_) - (lhs.val_.float_ < rhs.val_.float_);
+        case FieldType::TYPE_STRING: return lhs.GetString().compare(rhs.GetString());
+        default: WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(lhs.type_));
+      }
+    }
+    if ((lhs.type_ == FieldType::TYPE_INT && rhs.type_ == FieldType::TYPE_FLOAT) ||
+        (lhs.type_ == FieldType::TYPE_FLOAT && rhs.type_ == FieldType::TYPE_INT)) {
+      auto l = lhs.type_ == FieldType::TYPE_INT ? static_cast<float>(lhs.val_.int_) : lhs.val_.float_;
+      auto r = rhs.type_ == FieldType::TYPE_INT ? static_cast<float>(rhs.val_.int_) : rhs.val_.float_;
+      return (l > r) - (l < r);
+    }
+    WSDB_THROW(WSDB_TYPE_MISSMATCH,
+        fmt::format("Type mismatch: {} != {}", FieldTypeToString(lhs.type_), FieldTypeToString(rhs.type_)));
+  }
+
+  /**
+   * Evaluate lhs op rhs with the null semantics of Value: two nulls are equal, any other comparison involving a null
+   * is false (except !=)
+   */
+  static auto Eval(CompOp op, const Scalar &lhs, const Scalar &rhs) -> bool
+  {
+    if (lhs.is_null_ || rhs.is_null_) {
+      auto both_null = lhs.is_null_ && rhs.is_null_;
+      switch (op) {
+        case OP_EQ: return both_null;
+        case OP_NE: return !both_null;
+        case OP_LT:
+        case OP_LE:
+        case OP_GT:
+        case OP_GE: return false;
+        default: WSDB_FETAL(CompOpToString(op));
+      }
+    }
+    auto cmp = Compare(lhs, rhs);
+    switch (op) {
+      case OP_EQ: return cmp == 0;
+      case OP_NE: return cmp != 0;
+      case OP_LT: return cmp < 0;
+      case OP_LE: return cmp <= 0;
+      case OP_GT: return cmp > 0;
+      case OP_GE: return cmp >= 0;
+      default: WSDB_FETAL(CompOpToString(op));
+    }
+  }
+
+  [[nodiscard]] auto ToString() const -> std::string
+  {
+    if (is_null_) {
+      return "(null)";
+    }
+    switch (type_) {
+      case FieldType::TYPE_BOOL: return std::to_string(val_.bool_);
+      case FieldType::TYPE_INT: return std::to_string(val_.int_);
+      case FieldType::TYPE_FLOAT: return std::to_string(val_.float_);
+      case FieldType::TYPE_STRING: return std::string(GetString());
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+private:
+  FieldType type_{FieldType::TYPE_NULL};
+  bool      is_null_{false};
+  union
+  {
+    int32_t int_;
+    float   float_;
+    bool    bool_;
+    struct
+    {
+      const char *data_;
+      size_t      size_;
+    } str_;
+  } val_{};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_SCALAR_H
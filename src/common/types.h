@@ -109,7 +109,8 @@ ENUM_TO_STRING_BODY(JoinType)
 
 #define ENUM_ENTITIES \
   ENUM(NESTED_LOOP)   \
-  ENUM(SORT_MERGE)
+  ENUM(SORT_MERGE)    \
+  ENUM(HASH)
 #define ENUM(ent) ENUMENTRY(ent)
 DECLARE_ENUM(JoinStrategy)
 #undef ENUM
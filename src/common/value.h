@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <string>
 #include <vector>
+#include "arena.h"
 #include "types.h"
 #include "../../common/error.h"
 #include "../../common/micro.h"
@@ -345,8 +346,7 @@ class StringValue : public Value
 public:
   StringValue() = delete;
   StringValue(const char *value, size_t size, bool is_null)
-      : Value(FieldType::TYPE_STRING, std::min(size, strlen(value)), is_null),
-        value_(value, std::min(size, strlen(value)))
+      : Value(FieldType::TYPE_STRING, strnlen(value, size), is_null), value_(value, strnlen(value, size))
   {
     // resize the string to prune out '\0' characters
     // the given size is larger than the actual string size, so we need to resize it
@@ -546,26 +546,30 @@ private:
   std::vector<ValueSptr> values_;
 };
 
+/**
+ * Values created while an arena is installed on the calling thread (see ArenaScope) are allocated from that arena,
+ * they must not outlive it
+ */
 class ValueFactory
 {
 public:
-  static auto CreateIntValue(int value) -> IntValueSptr { return std::make_shared<IntValue>(value, false); }
+  static auto CreateIntValue(int value) -> IntValueSptr { return MakeValue<IntValue>(value, false); }
 
-  static auto CreateFloatValue(float value) -> FloatValueSptr { return std::make_shared<FloatValue>(value, false); }
+  static auto CreateFloatValue(float value) -> FloatValueSptr { return MakeValue<FloatValue>(value, false); }
 
-  static auto CreateBoolValue(bool value) -> BoolValueSptr { return std::make_shared<BoolValue>(value, false); }
+  static auto CreateBoolValue(bool value) -> BoolValueSptr { return MakeValue<BoolValue>(value, false); }
 
   static auto CreateStringValue(const char *value, size_t size) -> StringValueSptr
   {
-    return std::make_shared<StringValue>(value, size, false);
+    return MakeValue<StringValue>(value, size, false);
   }
 
   static auto CreateArrayValue(const std::vector<ValueSptr> &values) -> ArrayValueSptr
   {
-    return std::make_shared<ArrayValue>(values, false);
+    return MakeValue<ArrayValue>(values, false);
   }
 
-  static auto CreateArrayValue() -> ArrayValueSptr { return std::make_shared<ArrayValue>(); }
+  static auto CreateArrayValue() -> ArrayValueSptr { return MakeValue<ArrayValue>(); }
 
   static auto CreateValue(FieldType type, const char *data, size_t size = -1) -> ValueSptr
   {
@@ -581,11 +585,11 @@ public:
   static auto CreateNullValue(FieldType type) -> ValueSptr
   {
     switch (type) {
-      case FieldType::TYPE_INT: return std::make_shared<IntValue>(0, true);
-      case FieldType::TYPE_FLOAT: return std::make_shared<FloatValue>(0.0f, true);
-      case FieldType::TYPE_BOOL: return std::make_shared<BoolValue>(false, true);
-      case FieldType::TYPE_STRING: return std::make_shared<StringValue>("", 0, true);
-      case FieldType::TYPE_ARRAY: return std::make_shared<ArrayValue>(std::vector<ValueSptr>(), true);
+      case FieldType::TYPE_INT: return MakeValue<IntValue>(0, true);
+      case FieldType::TYPE_FLOAT: return MakeValue<FloatValue>(0.0f, true);
+      case FieldType::TYPE_BOOL: return MakeValue<BoolValue>(false, true);
+      case FieldType::TYPE_STRING: return MakeValue<StringValue>("", 0, true);
+      case FieldType::TYPE_ARRAY: return MakeValue<ArrayValue>(std::vector<ValueSptr>(), true);
       default: WSDB_FETAL("Unknown FieldType");
     }
   }
@@ -633,6 +637,16 @@ public:
           fmt::format("Type mismatch {} != {}", FieldTypeToString(value->GetType()), FieldTypeToString(type)));
     }
   }
+
+private:
+  template <typename T, typename... Args>
+  static auto MakeValue(Args &&...args) -> std::shared_ptr<T>
+  {
+    if (auto *arena = Arena::Current(); arena != nullptr) {
+      return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+    }
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  }
 };
 
 }  // namespace wsdb
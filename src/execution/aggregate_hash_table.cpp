@@ -0,0 +1,466 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/4.
+//
+
+#include "aggregate_hash_table.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace wsdb {
+
+namespace {
+
+constexpr size_t AGG_INIT_SLOT_NUM = 1024;
+
+template <typename T>
+inline auto LoadField(const char *mem) -> T
+{
+  T val;
+  memcpy(&val, mem, sizeof(T));
+  return val;
+}
+
+template <typename T>
+inline auto LoadField(const RecordView &row, size_t off) -> T
+{
+  return LoadField<T>(row.GetData() + off);
+}
+
+/// count(*)
+void UpdateCountStar(int64_t *cnt, const uint32_t *gids, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    cnt[gids[i]]++;
+  }
+}
+
+/// count(field)
+void UpdateCount(int64_t *cnt, const uint32_t *gids, const RecordBatch &batch, size_t idx)
+{
+  for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+    cnt[gids[i]] += !batch.GetRow(i).IsNull(idx);
+  }
+}
+
+/// sum and avg, nulls add 0 and are not counted
+template <typename T, typename Acc>
+void UpdateSum(Acc *sum, int64_t *cnt, const uint32_t *gids, const RecordBatch &batch, size_t idx, size_t off)
+{
+  for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+    const auto &row   = batch.GetRow(i);
+    auto        valid = !row.IsNull(idx);
+    sum[gids[i]] += valid ? static_cast<Acc>(LoadField<T>(row, off)) : Acc{0};
+    cnt[gids[i]] += valid;
+  }
+}
+
+/// min and max of numeric fields, accumulators start from the largest (min) or smallest (max) value
+template <typename T, typename Acc, bool is_min>
+void UpdateMinMax(Acc *acc, int64_t *cnt, const uint32_t *gids, const RecordBatch &batch, size_t idx, size_t off)
+{
+  for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+    const auto &row = batch.GetRow(i);
+    if (row.IsNull(idx)) {
+      continue;
+    }
+    auto  val = static_cast<Acc>(LoadField<T>(row, off));
+    auto &cur = acc[gids[i]];
+    cur       = is_min ? std::min(cur, val) : std::max(cur, val);
+    cnt[gids[i]]++;
+  }
+}
+
+template <bool is_min>
+void UpdateMinMaxString(
+    char *acc, int64_t *cnt, const uint32_t *gids, const RecordBatch &batch, size_t idx, size_t off, size_t size)
+{
+  for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+    const auto &row = batch.GetRow(i);
+    if (row.IsNull(idx)) {
+      continue;
+    }
+    auto val = row.GetData() + off;
+    auto cur = acc + gids[i] * size;
+    auto cmp = detail::CompareString(val, size, cur, size);
+    if (cnt[gids[i]] == 0 || (is_min ? cmp < 0 : cmp > 0)) {
+      memcpy(cur, val, size);
+    }
+    cnt[gids[i]]++;
+  }
+}
+
+}  // namespace
+
+AggregateHashTable::AggregateHashTable(
+    const RecordSchema *child_schema, const RecordSchema *agg_schema, const RecordSchema *group_schema)
+    : group_schema_(group_schema),
+      hasher_(group_schema, child_schema),
+      key_cmp_(group_schema, child_schema, group_schema, group_schema),
+      key_key_cmp_(group_schema, group_schema),
+      key_size_(BITMAP_SIZE(group_schema->GetFieldCount()) + group_schema->GetRecordLength()),
+      batch_hash_(BATCH_SIZE),
+      batch_gid_(BATCH_SIZE)
+{
+  for (const auto &field : group_schema_->GetFields()) {
+    key_src_idx_.push_back(child_schema->GetRTFieldIndex(field));
+  }
+  for (const auto &field : agg_schema->GetFields()) {
+    Accumulator acc{field.agg_type_, field.field_.field_type_, 0, 0, field.field_.field_size_, {}, {}, {}, {}, 0, 0};
+    if (field.agg_type_ != AGG_COUNT_STAR) {
+      acc.src_idx_ = child_schema->GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+      WSDB_ASSERT(acc.src_idx_ < child_schema->GetFieldCount(),
+          fmt::format("field {} not found in child", field.field_.field_name_));
+      acc.src_off_ = child_schema->GetFieldOffset(acc.src_idx_);
+    }
+    auto numeric = acc.type_ == TYPE_INT || acc.type_ == TYPE_FLOAT;
+    if ((field.agg_type_ == AGG_SUM || field.agg_type_ == AGG_AVG) && !numeric) {
+      WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(acc.type_));
+    }
+    if ((field.agg_type_ == AGG_MIN || field.agg_type_ == AGG_MAX) && !numeric && acc.type_ != TYPE_STRING) {
+      WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(acc.type_));
+    }
+    accs_.push_back(std::move(acc));
+  }
+  // the state of an aggregate is its count followed by its summary, count(*) and count(field) have no summary
+  size_t state_size = sizeof(size_t) + sizeof(uint64_t);
+  group_size_       = key_size_ + sizeof(size_t) + sizeof(uint64_t);
+  for (auto &acc : accs_) {
+    acc.summary_size_ = 0;
+    if (acc.agg_type_ != AGG_COUNT && acc.agg_type_ != AGG_COUNT_STAR) {
+      acc.summary_size_ = acc.type_ == TYPE_STRING ? acc.size_
+                          : acc.type_ == TYPE_INT  ? sizeof(int64_t)
+                                                   : sizeof(float);
+    }
+    acc.state_off_ = state_size;
+    state_size += sizeof(int64_t) + acc.summary_size_;
+    group_size_ += sizeof(int64_t) + sizeof(int64_t) + sizeof(float) + (acc.type_ == TYPE_STRING ? acc.size_ : 0);
+  }
+  // the group fields come first and keep their offsets, so that a row of the state schema can be read as a key
+  auto    state_fields = group_schema_->GetFields();
+  RTField state_field;
+  state_field.field_.field_name_ = "agg_state";
+  state_field.field_.field_type_ = TYPE_STRING;
+  state_field.field_.field_size_ = state_size;
+  state_fields.push_back(state_field);
+  state_schema_ = std::make_unique<RecordSchema>(state_fields);
+  state_off_    = state_schema_->GetFieldOffset(state_fields.size() - 1);
+  Clear();
+}
+
+auto AggregateHashTable::IsSupported(const RecordSchema *agg_schema) -> bool
+{
+  return std::all_of(agg_schema->GetFields().begin(), agg_schema->GetFields().end(), [](const RTField &field) {
+    auto type    = field.field_.field_type_;
+    auto numeric = type == TYPE_INT || type == TYPE_FLOAT;
+    switch (field.agg_type_) {
+      case AGG_COUNT:
+      case AGG_COUNT_STAR: return true;
+      case AGG_SUM:
+      case AGG_AVG: return numeric;
+      case AGG_MIN:
+      case AGG_MAX: return numeric || type == TYPE_STRING;
+      default: return false;
+    }
+  });
+}
+
+void AggregateHashTable::Clear()
+{
+  keys_.clear();
+  hashes_.clear();
+  first_pos_.clear();
+  slots_.assign(AGG_INIT_SLOT_NUM, 0);
+  for (auto &acc : accs_) {
+    acc.cnt_.clear();
+    acc.int_.clear();
+    acc.float_.clear();
+    acc.str_.clear();
+  }
+  group_num_ = 0;
+}
+
+void AggregateHashTable::Update(const RecordBatch &batch, uint64_t pos)
+{
+  auto n = batch.GetSelSize();
+  for (size_t i = 0; i < n; ++i) {
+    batch_hash_[i] = hasher_.Hash(batch.GetRow(i));
+  }
+  for (size_t i = 0; i < n; ++i) {
+    batch_gid_[i] = FindOrAddGroup(batch.GetRow(i), false, batch_hash_[i], pos + i);
+  }
+  for (auto &acc : accs_) {
+    Update(acc, batch);
+  }
+}
+
+void AggregateHashTable::AddEmptyGroup() { AddGroup(nullptr, false, 0, 0); }
+
+void AggregateHashTable::Merge(const AggregateHashTable &other, size_t gid)
+{
+  auto dst        = FindOrAddGroup(other.GetKeyView(gid), true, other.hashes_[gid], other.first_pos_[gid]);
+  first_pos_[dst] = std::min(first_pos_[dst], other.first_pos_[gid]);
+  for (size_t i = 0; i < accs_.size(); ++i) {
+    Combine(accs_[i], dst, other.accs_[i].cnt_[gid], GetSummary(other.accs_[i], gid));
+  }
+}
+
+void AggregateHashTable::WriteState(size_t gid, char *slot) const
+{
+  auto nullmap_size = BITMAP_SIZE(state_schema_->GetFieldCount());
+  auto key          = GetKeyView(gid);
+  auto state        = slot + nullmap_size + state_off_;
+  memset(slot, 0, nullmap_size);
+  memcpy(slot, key.GetNullMap(), BITMAP_SIZE(group_schema_->GetFieldCount()));
+  memcpy(slot + nullmap_size, key.GetData(), group_schema_->GetRecordLength());
+  memcpy(state, &hashes_[gid], sizeof(size_t));
+  memcpy(state + sizeof(size_t), &first_pos_[gid], sizeof(uint64_t));
+  for (const auto &acc : accs_) {
+    memcpy(state + acc.state_off_, &acc.cnt_[gid], sizeof(int64_t));
+    if (acc.summary_size_ != 0) {
+      memcpy(state + acc.state_off_ + sizeof(int64_t), GetSummary(acc, gid), acc.summary_size_);
+    }
+  }
+}
+
+void AggregateHashTable::MergeState(const RecordView &state)
+{
+  auto     data = state.GetData() + state_off_;
+  size_t   hash;
+  uint64_t first_pos;
+  memcpy(&hash, data, sizeof(size_t));
+  memcpy(&first_pos, data + sizeof(size_t), sizeof(uint64_t));
+  auto dst        = FindOrAddGroup(state, true, hash, first_pos);
+  first_pos_[dst] = std::min(first_pos_[dst], first_pos);
+  for (auto &acc : accs_) {
+    int64_t cnt;
+    memcpy(&cnt, data + acc.state_off_, sizeof(int64_t));
+    Combine(acc, dst, cnt, data + acc.state_off_ + sizeof(int64_t));
+  }
+}
+
+auto AggregateHashTable::GetMemSize() const -> size_t
+{
+  return group_num_ * group_size_ + slots_.size() * sizeof(uint32_t);
+}
+
+auto AggregateHashTable::AddGroup(const RecordView *row, bool is_key, size_t hash, uint64_t first_pos) -> uint32_t
+{
+  auto gid = static_cast<uint32_t>(group_num_++);
+  keys_.resize(group_num_ * key_size_);
+  auto key          = keys_.data() + gid * key_size_;
+  auto nullmap_size = BITMAP_SIZE(group_schema_->GetFieldCount());
+  if (row != nullptr && is_key) {
+    memcpy(key, row->GetNullMap(), nullmap_size);
+    memcpy(key + nullmap_size, row->GetData(), group_schema_->GetRecordLength());
+  } else {
+    memset(key, 0, key_size_);
+    for (size_t i = 0; i < key_src_idx_.size(); ++i) {
+      if (row == nullptr || row->IsNull(key_src_idx_[i])) {
+        BitMap::SetBit(key, i, true);
+      } else {
+        memcpy(key + nullmap_size + group_schema_->GetFieldOffset(i),
+            row->GetFieldData(key_src_idx_[i]),
+            group_schema_->GetFieldAt(i).field_.field_size_);
+      }
+    }
+  }
+  hashes_.push_back(hash);
+  first_pos_.push_back(first_pos);
+  for (auto &acc : accs_) {
+    acc.cnt_.push_back(0);
+    switch (acc.agg_type_) {
+      case AGG_SUM:
+      case AGG_AVG:
+        acc.int_.push_back(0);
+        acc.float_.push_back(0);
+        break;
+      case AGG_MIN:
+        acc.int_.push_back(std::numeric_limits<int64_t>::max());
+        acc.float_.push_back(std::numeric_limits<float>::infinity());
+        acc.str_.resize(acc.str_.size() + acc.size_);
+        break;
+      case AGG_MAX:
+        acc.int_.push_back(std::numeric_limits<int64_t>::min());
+        acc.float_.push_back(-std::numeric_limits<float>::infinity());
+        acc.str_.resize(acc.str_.size() + acc.size_);
+        break;
+      default: break;
+    }
+  }
+  return gid;
+}
+
+auto AggregateHashTable::FindOrAddGroup(
+    const RecordView &row, bool is_key, size_t hash, uint64_t first_pos) -> uint32_t
+{
+  const auto &cmp  = is_key ? key_key_cmp_ : key_cmp_;
+  auto        mask = slots_.size() - 1;
+  for (auto pos = hash & mask;; pos = (pos + 1) & mask) {
+    auto slot = slots_[pos];
+    if (slot == 0) {
+      auto gid    = AddGroup(&row, is_key, hash, first_pos);
+      slots_[pos] = gid + 1;
+      // keep the table at most half full
+      if (group_num_ * 2 > slots_.size()) {
+        Grow();
+      }
+      return gid;
+    }
+    if (hashes_[slot - 1] == hash && cmp.Equal(row, GetKeyView(slot - 1))) {
+      return slot - 1;
+    }
+  }
+}
+
+void AggregateHashTable::Grow()
+{
+  slots_.assign(slots_.size() * 2, 0);
+  auto mask = slots_.size() - 1;
+  for (size_t gid = 0; gid < group_num_; ++gid) {
+    auto pos = hashes_[gid] & mask;
+    while (slots_[pos] != 0) {
+      pos = (pos + 1) & mask;
+    }
+    slots_[pos] = static_cast<uint32_t>(gid + 1);
+  }
+}
+
+void AggregateHashTable::Update(Accumulator &acc, const RecordBatch &batch) const
+{
+  auto gids = batch_gid_.data();
+  auto cnt  = acc.cnt_.data();
+  auto idx  = acc.src_idx_;
+  auto off  = acc.src_off_;
+  auto is_int = acc.type_ == TYPE_INT;
+  switch (acc.agg_type_) {
+    case AGG_COUNT_STAR: return UpdateCountStar(cnt, gids, batch.GetSelSize());
+    case AGG_COUNT: return UpdateCount(cnt, gids, batch, idx);
+    case AGG_SUM:
+    case AGG_AVG:
+      return is_int ? UpdateSum<int32_t>(acc.int_.data(), cnt, gids, batch, idx, off)
+                    : UpdateSum<float>(acc.float_.data(), cnt, gids, batch, idx, off);
+    case AGG_MIN:
+      if (acc.type_ == TYPE_STRING) {
+        return UpdateMinMaxString<true>(acc.str_.data(), cnt, gids, batch, idx, off, acc.size_);
+      }
+      return is_int ? UpdateMinMax<int32_t, int64_t, true>(acc.int_.data(), cnt, gids, batch, idx, off)
+                    : UpdateMinMax<float, float, true>(acc.float_.data(), cnt, gids, batch, idx, off);
+    case AGG_MAX:
+      if (acc.type_ == TYPE_STRING) {
+        return UpdateMinMaxString<false>(acc.str_.data(), cnt, gids, batch, idx, off, acc.size_);
+      }
+      return is_int ? UpdateMinMax<int32_t, int64_t, false>(acc.int_.data(), cnt, gids, batch, idx, off)
+                    : UpdateMinMax<float, float, false>(acc.float_.data(), cnt, gids, batch, idx, off);
+    default: WSDB_FETAL("Unknown aggregate type");
+  }
+}
+
+void AggregateHashTable::Combine(Accumulator &acc, size_t gid, int64_t cnt, const char *val) const
+{
+  if (cnt == 0) {
+    return;
+  }
+  auto is_min = acc.agg_type_ == AGG_MIN;
+  switch (acc.agg_type_) {
+    case AGG_COUNT_STAR:
+    case AGG_COUNT: break;
+    case AGG_SUM:
+    case AGG_AVG:
+      if (acc.type_ == TYPE_INT) {
+        acc.int_[gid] += LoadField<int64_t>(val);
+      } else {
+        acc.float_[gid] += LoadField<float>(val);
+      }
+      break;
+    case AGG_MIN:
+    case AGG_MAX:
+      if (acc.type_ == TYPE_STRING) {
+        auto cur = acc.str_.data() + gid * acc.size_;
+        auto cmp = detail::CompareString(val, acc.size_, cur, acc.size_);
+        if (acc.cnt_[gid] == 0 || (is_min ? cmp < 0 : cmp > 0)) {
+          memcpy(cur, val, acc.size_);
+        }
+      } else if (acc.type_ == TYPE_INT) {
+        auto other    = LoadField<int64_t>(val);
+        acc.int_[gid] = is_min ? std::min(acc.int_[gid], other) : std::max(acc.int_[gid], other);
+      } else {
+        auto other      = LoadField<float>(val);
+        acc.float_[gid] = is_min ? std::min(acc.float_[gid], other) : std::max(acc.float_[gid], other);
+      }
+      break;
+    default: WSDB_FETAL("Unknown aggregate type");
+  }
+  acc.cnt_[gid] += cnt;
+}
+
+auto AggregateHashTable::GetSummary(const Accumulator &acc, size_t gid) -> const char *
+{
+  if (acc.summary_size_ == 0) {
+    return nullptr;
+  }
+  if (acc.type_ == TYPE_STRING) {
+    return acc.str_.data() + gid * acc.size_;
+  }
+  return acc.type_ == TYPE_INT ? reinterpret_cast<const char *>(&acc.int_[gid])
+                               : reinterpret_cast<const char *>(&acc.float_[gid]);
+}
+
+void AggregateHashTable::WriteGroup(size_t gid, const RecordSchema *out_schema, char *slot) const
+{
+  auto nullmap_size = BITMAP_SIZE(out_schema->GetFieldCount());
+  auto data         = slot + nullmap_size;
+  auto key          = GetKeyView(gid);
+  auto key_cnt      = group_schema_->GetFieldCount();
+  // group fields come first and keep their offsets
+  memset(slot, 0, nullmap_size);
+  memcpy(data, key.GetData(), group_schema_->GetRecordLength());
+  for (size_t i = 0; i < key_cnt; ++i) {
+    if (key.IsNull(i)) {
+      BitMap::SetBit(slot, i, true);
+    }
+  }
+  for (size_t i = 0; i < accs_.size(); ++i) {
+    const auto &acc = accs_[i];
+    auto        out = data + out_schema->GetFieldOffset(key_cnt + i);
+    auto        cnt = acc.cnt_[gid];
+    if (acc.agg_type_ == AGG_COUNT || acc.agg_type_ == AGG_COUNT_STAR) {
+      auto val = static_cast<int32_t>(cnt);
+      memcpy(out, &val, sizeof(val));
+      continue;
+    }
+    if (cnt == 0) {
+      BitMap::SetBit(slot, key_cnt + i, true);
+      memset(out, 0, acc.size_);
+      continue;
+    }
+    if (acc.type_ == TYPE_STRING) {
+      memcpy(out, acc.str_.data() + gid * acc.size_, acc.size_);
+    } else if (acc.type_ == TYPE_INT) {
+      auto val = static_cast<int32_t>(acc.agg_type_ == AGG_AVG ? acc.int_[gid] / cnt : acc.int_[gid]);
+      memcpy(out, &val, sizeof(val));
+    } else {
+      auto val = acc.agg_type_ == AGG_AVG ? acc.float_[gid] / static_cast<float>(cnt) : acc.float_[gid];
+      memcpy(out, &val, sizeof(val));
+    }
+  }
+}
+
+}  // namespace wsdb
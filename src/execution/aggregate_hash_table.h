@@ -0,0 +1,172 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/4.
+//
+
+/**
+ * @brief Groups of a hash aggregation and the states of their aggregates
+ * 1. the group keys of a batch are hashed in one pass
+ * 2. each row is looked up in an open addressing table of group ids, new groups copy their key into keys_
+ * 3. each aggregate updates its typed accumulator arrays for the whole batch, in a loop chosen once for its function
+ *    and input type
+ * The states are partial until the result rows are written, so the groups of two tables over the same schemas can be
+ * merged, e.g. tables filled by different workers from different parts of the input, or written out as rows of the
+ * state schema, e.g. to be spilled, and merged from those rows later. Group ids follow the order in which groups are
+ * added, and every group keeps the position of its first row so that the merged groups can be put back in that order.
+ */
+
+#ifndef WSDB_AGGREGATE_HASH_TABLE_H
+#define WSDB_AGGREGATE_HASH_TABLE_H
+
+#include "record_batch.h"
+#include "system/handle/record_comparator.h"
+
+namespace wsdb {
+
+class AggregateHashTable
+{
+public:
+  /**
+   * @param child_schema schema of the rows aggregated
+   * @param agg_schema aggregates of the rows, their inputs are fields of child_schema
+   * @param group_schema fields of child_schema the rows are grouped by
+   */
+  AggregateHashTable(
+      const RecordSchema *child_schema, const RecordSchema *agg_schema, const RecordSchema *group_schema);
+
+  /// whether the aggregates of agg_schema have typed accumulators, those are counts, sums and averages of numbers, and
+  /// mins and maxes of numbers and strings
+  static auto IsSupported(const RecordSchema *agg_schema) -> bool;
+
+  /// drop all groups
+  void Clear();
+
+  /// aggregate the selected rows of batch, the i-th of which is at position pos + i of the input
+  void Update(const RecordBatch &batch, uint64_t pos);
+
+  /// add the group of aggregation without group by, whose key is a row of nulls
+  void AddEmptyGroup();
+
+  /// combine the states of group gid of other, a table over the same schemas, with those of the same group here
+  void Merge(const AggregateHashTable &other, size_t gid);
+
+  /// write the key and the states of group gid to slot, laid out as a record of the state schema
+  void WriteState(size_t gid, char *slot) const;
+
+  /// combine the states of a row written by WriteState of a table over the same schemas with those of its group here
+  void MergeState(const RecordView &state);
+
+  /// schema of the rows written by WriteState, the group fields followed by a field holding the states as raw bytes
+  [[nodiscard]] auto GetStateSchema() const -> const RecordSchema * { return state_schema_.get(); }
+
+  /// bytes taken by the groups and the slots of the table
+  [[nodiscard]] auto GetMemSize() const -> size_t;
+
+  /// write the result row of group gid to slot, laid out as a record of out_schema, the group fields followed by the
+  /// aggregates
+  void WriteGroup(size_t gid, const RecordSchema *out_schema, char *slot) const;
+
+  [[nodiscard]] auto GetGroupNum() const -> size_t { return group_num_; }
+
+  [[nodiscard]] auto GetHash(size_t gid) const -> size_t { return hashes_[gid]; }
+
+  /// position in the input of the first row of group gid
+  [[nodiscard]] auto GetFirstPos(size_t gid) const -> uint64_t { return first_pos_[gid]; }
+
+private:
+  /// state of an aggregate for all groups, indexed by group id
+  struct Accumulator
+  {
+    AggType   agg_type_;
+    FieldType type_;
+    // input field in the child's records, unused for count(*)
+    size_t src_idx_;
+    size_t src_off_;
+    size_t size_;
+    // number of non-null inputs, or rows for count(*)
+    std::vector<int64_t> cnt_;
+    // sum, min or max of int inputs
+    std::vector<int64_t> int_;
+    // sum, min or max of float inputs
+    std::vector<float> float_;
+    // min or max of string inputs, size_ bytes per group
+    std::vector<char> str_;
+    // offset of the state in the state field of WriteState, the count followed by the int, float or string summary
+    size_t state_off_;
+    size_t summary_size_;
+  };
+
+  /// add a group whose key is read from row, a row of the child or a key if is_key, or a row of nulls if row is nullptr
+  auto AddGroup(const RecordView *row, bool is_key, size_t hash, uint64_t first_pos) -> uint32_t;
+
+  auto FindOrAddGroup(const RecordView &row, bool is_key, size_t hash, uint64_t first_pos) -> uint32_t;
+
+  /// double the slots of the table and reinsert the groups
+  void Grow();
+
+  /// update acc with the selected rows of batch, group ids of the rows are in batch_gid_
+  void Update(Accumulator &acc, const RecordBatch &batch) const;
+
+  /// combine a partial state of acc, cnt non-null inputs summarized by the int64_t, float or string at val, with the
+  /// state of group gid
+  void Combine(Accumulator &acc, size_t gid, int64_t cnt, const char *val) const;
+
+  /// the summary of acc for group gid, as read by Combine
+  [[nodiscard]] static auto GetSummary(const Accumulator &acc, size_t gid) -> const char *;
+
+  [[nodiscard]] auto GetKeyView(size_t gid) const -> RecordView
+  {
+    auto key = keys_.data() + gid * key_size_;
+    return {group_schema_, key, key + BITMAP_SIZE(group_schema_->GetFieldCount()), INVALID_RID};
+  }
+
+private:
+  const RecordSchema *group_schema_;
+  // hashes the group key of the child's records, or of the keys of another table
+  RecordHasher hasher_;
+  // compares the group key of a child's record (lhs) with a stored key (rhs)
+  RecordComparator key_cmp_;
+  // compares a key of another table (lhs) with a stored key (rhs)
+  RecordComparator key_key_cmp_;
+  // index in the child's schema of each group field
+  std::vector<size_t> key_src_idx_;
+  // group keys are stored as records of group_schema_, null map followed by data
+  size_t                key_size_;
+  std::vector<char>     keys_;
+  std::vector<size_t>   hashes_;
+  std::vector<uint64_t> first_pos_;
+  // open addressing table with linear probing, a slot holds group id + 1, 0 if empty, the size is a power of 2
+  std::vector<uint32_t>    slots_;
+  std::vector<Accumulator> accs_;
+  size_t                   group_num_{0};
+  // bytes a group takes in keys_, hashes_, first_pos_ and the accumulators
+  size_t           group_size_;
+  RecordSchemaUptr state_schema_;
+  // offset of the state field in the rows of the state schema
+  size_t state_off_;
+  // per batch hashes and group ids of the selected rows
+  std::vector<size_t>   batch_hash_;
+  std::vector<uint32_t> batch_gid_;
+};
+
+DEFINE_UNIQUE_PTR(AggregateHashTable);
+
+}  // namespace wsdb
+
+#endif  // WSDB_AGGREGATE_HASH_TABLE_H
@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/6.
+//
+
+#include "aggregate_spill.h"
+
+namespace wsdb {
+
+AggregateSpill::AggregateSpill(size_t mem_budget) : mem_budget_(mem_budget) {}
+
+void AggregateSpill::Clear()
+{
+  parts_.clear();
+  queue_.clear();
+  is_spilled_ = false;
+}
+
+void AggregateSpill::Spill(AggregateHashTable &table)
+{
+  Spill(table, 0, parts_);
+  is_spilled_ = true;
+}
+
+void AggregateSpill::Absorb(AggregateSpill &other)
+{
+  if (!other.is_spilled_) {
+    return;
+  }
+  parts_.resize(other.parts_.size());
+  for (size_t i = 0; i < parts_.size(); ++i) {
+    parts_[i].level_ = 0;
+    for (auto &file : other.parts_[i].files_) {
+      parts_[i].files_.push_back(std::move(file));
+    }
+  }
+  other.Clear();
+  is_spilled_ = true;
+}
+
+auto AggregateSpill::Next(AggregateHashTable &table) -> bool
+{
+  // the partitions of level 0 are complete once the input is read
+  for (auto &part : parts_) {
+    queue_.push_back(std::move(part));
+  }
+  parts_.clear();
+  while (!queue_.empty()) {
+    auto part = std::move(queue_.back());
+    queue_.pop_back();
+    table.Clear();
+    std::vector<Partition> children;
+    for (auto &file : part.files_) {
+      file->Rewind();
+      RecordBatch batch(file->GetSchema());
+      while (file->Read(batch)) {
+        for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+          table.MergeState(batch.GetRow(i));
+        }
+        // a partition that still does not fit is split again by the next level
+        if (IsFull(table) && part.level_ + 1 < AGG_MAX_DEPTH) {
+          Spill(table, part.level_ + 1, children);
+        }
+      }
+      // the file is read only once
+      file.reset();
+    }
+    if (!children.empty()) {
+      Spill(table, part.level_ + 1, children);
+      for (auto &child : children) {
+        queue_.push_back(std::move(child));
+      }
+      continue;
+    }
+    if (table.GetGroupNum() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AggregateSpill::Spill(AggregateHashTable &table, size_t level, std::vector<Partition> &parts)
+{
+  auto schema = table.GetStateSchema();
+  if (parts.empty()) {
+    parts.resize(AGG_PARTITION_NUM);
+    for (auto &part : parts) {
+      part.level_ = level;
+      part.files_.push_back(std::make_unique<SpillFile>(schema));
+    }
+  }
+  auto nullmap_size = BITMAP_SIZE(schema->GetFieldCount());
+  auto buf          = std::vector<char>(nullmap_size + schema->GetRecordLength());
+  auto state        = RecordView(schema, buf.data(), buf.data() + nullmap_size, INVALID_RID);
+  for (size_t gid = 0; gid < table.GetGroupNum(); ++gid) {
+    table.WriteState(gid, buf.data());
+    parts[PartitionOf(table.GetHash(gid), level)].files_.front()->Append(state);
+  }
+  table.Clear();
+}
+
+auto AggregateSpill::PartitionOf(size_t hash, size_t level) -> size_t
+{
+  // slots of the tables are indexed by the low bits of the hash, so the hash is remixed before it picks a partition,
+  // and remixed differently at every level so that a partition that does not fit splits again at the next one
+  uint64_t h = hash ^ ((level + 1) * 0x9e3779b97f4a7c15ULL);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h % AGG_PARTITION_NUM;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/6.
+//
+
+/**
+ * @brief Partial groups of a hash aggregation spilled to temp files when its table exceeds the memory budget
+ * The groups of a full table are written as rows of its state schema to the files of AGG_PARTITION_NUM partitions by
+ * their hashes, and the table is cleared to aggregate the rest of the input. Once the input is read, the partitions
+ * are aggregated into the table one at a time by merging the states in their files. A partition that still does not
+ * fit is split again by other bits of the hashes, up to AGG_MAX_DEPTH levels, beyond which it is aggregated in memory
+ * whatever its size, e.g. when the budget is below the size of a few groups.
+ */
+
+#ifndef WSDB_AGGREGATE_SPILL_H
+#define WSDB_AGGREGATE_SPILL_H
+
+#include "aggregate_hash_table.h"
+#include "spill_file.h"
+
+namespace wsdb {
+
+class AggregateSpill
+{
+public:
+  /// @param mem_budget bytes a table may take before its groups are spilled
+  explicit AggregateSpill(size_t mem_budget);
+
+  /// remove the files
+  void Clear();
+
+  /// whether the groups of table should be spilled, a table of one group is never spilled as it can not be split
+  [[nodiscard]] auto IsFull(const AggregateHashTable &table) const -> bool
+  {
+    return table.GetMemSize() > mem_budget_ && table.GetGroupNum() > 1;
+  }
+
+  /// write the groups of table to the partitions and clear it, should not be called after Next
+  void Spill(AggregateHashTable &table);
+
+  /// take over the partitions of other, which hold the groups of another part of the same input
+  void Absorb(AggregateSpill &other);
+
+  [[nodiscard]] auto IsSpilled() const -> bool { return is_spilled_; }
+
+  /// aggregate the next partition into table, which is cleared first, returns false when there is none left
+  auto Next(AggregateHashTable &table) -> bool;
+
+private:
+  /// files of the groups of a partition, the partition was split from its parent by the hashes at level_
+  struct Partition
+  {
+    size_t                     level_;
+    std::vector<SpillFileUptr> files_;
+  };
+
+  /// write the groups of table to the partitions split by the hashes at level and clear it, the partitions are created
+  /// if parts is empty
+  static void Spill(AggregateHashTable &table, size_t level, std::vector<Partition> &parts);
+
+  [[nodiscard]] static auto PartitionOf(size_t hash, size_t level) -> size_t;
+
+private:
+  size_t mem_budget_;
+  bool   is_spilled_{false};
+  // partitions of level 0 being written by Spill
+  std::vector<Partition> parts_;
+  // partitions waiting to be aggregated by Next
+  std::vector<Partition> queue_;
+};
+
+DEFINE_UNIQUE_PTR(AggregateSpill);
+
+}  // namespace wsdb
+
+#endif  // WSDB_AGGREGATE_SPILL_H
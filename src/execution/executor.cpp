@@ -23,11 +23,13 @@
 #include "executor_defs.h"
 
 #include "expr/condition_expr.h"
+#include "expr/predicate.h"
 
 namespace wsdb {
 
 // translate the plan to executor
-auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr
+auto Executor::Translate(
+    const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, PipelineContext *pipeline) -> AbstractExecutorUptr
 {
   if (db == nullptr) {
     WSDB_THROW(WSDB_DB_NOT_OPEN, "");
@@ -46,9 +48,12 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     if (db->GetTable(insert->table_name_) == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, insert->table_name_);
     }
-    auto                    tab = db->GetTable(insert->table_name_);
-    std::vector<RecordUptr> inserts;
-    inserts.emplace_back(std::make_unique<Record>(&tab->GetSchema(), insert->values_, INVALID_RID));
+    auto                tab = db->GetTable(insert->table_name_);
+    std::vector<Record> inserts;
+    inserts.reserve(insert->values_.size());
+    for (const auto &values : insert->values_) {
+      inserts.emplace_back(&tab->GetSchema(), values, INVALID_RID);
+    }
     return std::make_unique<InsertExecutor>(tab, db->GetIndexes(insert->table_name_), std::move(inserts));
   } else if (const auto update = std::dynamic_pointer_cast<UpdatePlan>(plan)) {
     auto tab = db->GetTable(update->table_name_);
@@ -64,16 +69,21 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     }
     return std::make_unique<DeleteExecutor>(Translate(del->child_, db), tab, db->GetIndexes(del->table_name_));
   } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
-    std::function<bool(const Record &)> filter_func = [filter](const Record &record) {
-      return ConditionExpr::Eval(filter->conds_, record);
-    };
-    return std::make_unique<FilterExecutor>(Translate(filter->child_, db), std::move(filter_func));
+    auto child = Translate(filter->child_, db, pipeline);
+    // bind the conditions to the child's schema once, instead of looking up fields for every record
+    auto predicate = Predicate(filter->conds_, child->GetOutSchema());
+    return std::make_unique<FilterExecutor>(std::move(child), std::move(predicate));
   } else if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
     auto tab = db->GetTable(scan->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, scan->table_name_);
     }
-    return std::make_unique<SeqScanExecutor>(tab);
+    return std::make_unique<SeqScanExecutor>(
+        tab, scan->conds_, scan->fields_, pipeline == nullptr ? nullptr : pipeline->range_);
+  } else if (const auto mat = std::dynamic_pointer_cast<MaterializePlan>(plan)) {
+    return std::make_unique<MaterializeExecutor>(Translate(mat->child_, db, pipeline),
+        db->GetTable(mat->table_name_),
+        std::make_unique<RecordSchema>(mat->fields_));
   } else if (const auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
     return std::make_unique<IdxScanExecutor>(db->GetTable(idx_scan->table_name_),
         db->GetIndex(idx_scan->idx_id_),
@@ -82,8 +92,25 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
   } else if (const auto sort_plan = std::dynamic_pointer_cast<SortPlan>(plan)) {
     return std::make_unique<SortExecutor>(
         Translate(sort_plan->child_, db), std::move(sort_plan->key_schema_), sort_plan->is_desc_);
+  } else if (const auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    auto child    = Translate(top_n->child_, db);
+    auto schema   = child->GetOutSchema();
+    auto key_size = KeyNormalizer(top_n->key_schema_.get(), schema, top_n->is_desc_).GetKeySize();
+    auto row_size = BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength() + key_size;
+    // a heap that does not fit in the memory budget of a sort is left to a sort that can spill
+    if (top_n->limit_ > SORT_BUFFER_SIZE / row_size) {
+      return std::make_unique<LimitExecutor>(
+          std::make_unique<SortExecutor>(std::move(child), std::move(top_n->key_schema_), top_n->is_desc_),
+          static_cast<int>(top_n->limit_));
+    }
+    return std::make_unique<TopNExecutor>(
+        std::move(child), std::move(top_n->key_schema_), top_n->is_desc_, top_n->limit_);
   } else if (const auto proj_plan = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
-    return std::make_unique<ProjectionExecutor>(Translate(proj_plan->child_, db), std::move(proj_plan->schema_));
+    // copied, as every pipeline under an exchange translates the projection
+    return std::make_unique<ProjectionExecutor>(Translate(proj_plan->child_, db, pipeline),
+        std::make_unique<RecordSchema>(proj_plan->schema_->GetFields()));
+  } else if (const auto exchange = std::dynamic_pointer_cast<ExchangePlan>(plan)) {
+    return std::make_unique<ExchangeExecutor>(db->GetTable(exchange->table_name_), TranslatePipelines(exchange, db));
   } else if (const auto join_plan = std::dynamic_pointer_cast<JoinPlan>(plan)) {
     if (join_plan->strategy_ == NESTED_LOOP) {
       return std::make_unique<NestedLoopJoinExecutor>(
@@ -94,11 +121,44 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
           Translate(join_plan->right_, db),
           std::move(join_plan->left_key_schema_),
           std::move(join_plan->right_key_schema_));
+    } else if (join_plan->strategy_ == HASH) {
+      // in a pipeline, the probe side reads the morsels of the worker and the table is shared by all the workers
+      std::shared_ptr<HashJoinExecutor::SharedTable> table;
+      if (pipeline != nullptr) {
+        auto &shared = (*pipeline->join_tables_)[join_plan.get()];
+        if (shared == nullptr) {
+          shared = HashJoinExecutor::MakeSharedTable();
+        }
+        table = shared;
+      }
+      // key schemas are copied, as every pipeline translates the join
+      return std::make_unique<HashJoinExecutor>(join_plan->type_,
+          Translate(join_plan->left_, db, join_plan->build_left_ ? nullptr : pipeline),
+          Translate(join_plan->right_, db, join_plan->build_left_ ? pipeline : nullptr),
+          std::make_unique<RecordSchema>(join_plan->left_key_schema_->GetFields()),
+          std::make_unique<RecordSchema>(join_plan->right_key_schema_->GetFields()),
+          join_plan->build_left_,
+          HASH_JOIN_BUFFER_SIZE,
+          std::move(table));
     }
   } else if (const auto agg_plan = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
     auto agg_schema   = std::make_unique<RecordSchema>(agg_plan->agg_fields);
     auto group_schema = std::make_unique<RecordSchema>(agg_plan->group_fields_);
-    return std::make_unique<AggregateExecutor>(
+    // aggregates without typed accumulators, e.g. min of a bool, are left to AggregateExecutor
+    if (!AggregateHashTable::IsSupported(agg_schema.get())) {
+      return std::make_unique<AggregateExecutor>(
+          Translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
+    }
+    // over an exchange, the workers aggregate the rows of their pipelines themselves and merge the groups
+    if (const auto exchange = std::dynamic_pointer_cast<ExchangePlan>(agg_plan->child_)) {
+      return std::make_unique<ParallelAggregateExecutor>(db->GetTable(exchange->table_name_),
+          TranslatePipelines(exchange, db),
+          std::move(agg_schema),
+          std::move(group_schema));
+    }
+    // hash aggregation over batches even when the child produces rows, as it spills the groups beyond its budget while
+    // AggregateExecutor keeps all of them in memory
+    return std::make_unique<AggregateExecutorVec>(
         Translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
   } else if (const auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
     return std::make_unique<LimitExecutor>(Translate(lim->child_, db), lim->limit_);
@@ -108,6 +168,20 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
   }
   return nullptr;
 }
+
+auto Executor::TranslatePipelines(
+    const std::shared_ptr<ExchangePlan> &exchange, DatabaseHandle *db) -> std::vector<ExchangePipeline>
+{
+  auto pipelines   = std::vector<ExchangePipeline>(exchange->worker_num_);
+  auto join_tables = std::unordered_map<const AbstractPlan *, std::shared_ptr<HashJoinExecutor::SharedTable>>{};
+  for (auto &pipeline : pipelines) {
+    pipeline.range_ = std::make_unique<PageRange>();
+    auto context    = PipelineContext{pipeline.range_.get(), &join_tables};
+    pipeline.root_  = Translate(exchange->child_, db, &context);
+  }
+  return pipelines;
+}
+
 void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
 {
   if (executor->GetType() == TXN) {
@@ -119,7 +193,7 @@ void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
     ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, header);
     auto rec = executor->GetRecord();
     if (rec != nullptr) {
-      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec.get());
+      ctx->nt_ctl_->SendRec(ctx->client_fd_, *rec);
     }
     while (!executor->IsEnd()) {
       executor->Next();
@@ -128,16 +202,27 @@ void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
       }
       rec = executor->GetRecord();
       WSDB_ASSERT(rec != nullptr, "");
-      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec.get());
+      ctx->nt_ctl_->SendRec(ctx->client_fd_, *rec);
+    }
+    ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
+  } else if (executor->IsVectorized()) {
+    // every executor in the tree produces batches natively, drive the root batch at a time
+    auto header = executor->GetOutSchema();
+    ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, header);
+    auto batch = RecordBatch(header);
+    for (executor->Init(); executor->NextBatch(batch);) {
+      for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+        ctx->nt_ctl_->SendRec(ctx->client_fd_, batch.GetRow(i));
+      }
     }
     ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
   } else {
     auto header = executor->GetOutSchema();
     ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, header);
     for (executor->Init(); !executor->IsEnd(); executor->Next()) {
-      auto rec = executor->GetRecord();
-      WSDB_ASSERT(rec != nullptr, "");
-      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec.get());
+      auto rec = executor->GetRecordView();
+      WSDB_ASSERT(rec.IsValid(), "");
+      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec);
     }
     ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
   }
@@ -22,19 +22,45 @@
 #ifndef WSDB_EXECUTOR_H
 #define WSDB_EXECUTOR_H
 
+#include <unordered_map>
 #include "plan/plan.h"
 #include "executor_abstract.h"
+#include "executor_exchange.h"
+#include "executor_join_hash.h"
+#include "morsel.h"
 #include "system/context.h"
 
 namespace wsdb {
+
+/// the pipeline of a worker under an exchange being translated
+struct PipelineContext
+{
+  // pages the scan of the pipeline reads
+  const PageRange *range_;
+  // tables of the hash joins in the pipelines, shared by all of them
+  std::unordered_map<const AbstractPlan *, std::shared_ptr<HashJoinExecutor::SharedTable>> *join_tables_;
+};
+
 class Executor
 {
 public:
   Executor() = default;
 
-  static auto Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr;
+  /**
+   * @param plan
+   * @param db
+   * @param pipeline set when plan is the pipeline of a worker under an exchange
+   * @return
+   */
+  static auto Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db,
+      PipelineContext *pipeline = nullptr) -> AbstractExecutorUptr;
 
   static void Execute(const AbstractExecutorUptr &executor, Context *ctx);
+
+private:
+  /// the pipelines of the workers under exchange
+  static auto TranslatePipelines(
+      const std::shared_ptr<ExchangePlan> &exchange, DatabaseHandle *db) -> std::vector<ExchangePipeline>;
 };
 }  // namespace wsdb
 
@@ -25,6 +25,7 @@
 #include "../../common/error.h"
 #include "../../common/micro.h"
 #include "system/handle/record_handle.h"
+#include "record_batch.h"
 
 namespace wsdb {
 
@@ -63,14 +64,52 @@ public:
 
   [[nodiscard]] auto GetType() const -> ExecutorType { return type_; }
 
-  [[nodiscard]] auto GetRecord() -> RecordUptr
+  /**
+   * Get a view of the current record without copying it, the view is only valid until the next call to Next(),
+   * executors that can expose records in place (e.g. inside a pinned page) should override this
+   */
+  [[nodiscard]] virtual auto GetRecordView() const -> RecordView
   {
     if (record_ == nullptr) {
+      return {};
+    }
+    return *record_;
+  }
+
+  /**
+   * Get a copy of the current record, only use it when the record should outlive the next call to Next()
+   * the copy is taken from the heap, as callers usually drop it after a row, long before the statement arena is reset
+   */
+  [[nodiscard]] auto GetRecord() -> RecordUptr
+  {
+    auto view = GetRecordView();
+    if (!view.IsValid()) {
       return nullptr;
     }
-    return std::make_unique<Record>(*record_);
+    ArenaScope heap(nullptr);
+    return std::make_unique<Record>(view);
   };
 
+  /**
+   * Fill batch with the next rows, starting from the current row of the row interface, rows in the batch stay valid
+   * until the next call. After Init(), a consumer either drives the executor with Next()/IsEnd() or with NextBatch(),
+   * the two should not be mixed. The default implementation adapts the row interface by copying every record into
+   * the batch, executors that can produce batches natively should override it together with IsVectorized()
+   * @param batch a batch with the out schema of this executor, it is reset before filled
+   * @return false if there are no more rows, in which case the batch is empty, otherwise at least one row is selected
+   */
+  virtual auto NextBatch(RecordBatch &batch) -> bool
+  {
+    batch.Reset();
+    for (; !IsEnd() && !batch.IsFull(); Next()) {
+      batch.AppendCopy(GetRecordView());
+    }
+    return batch.GetSelSize() > 0;
+  }
+
+  /// whether this executor and all executors below it produce batches natively
+  [[nodiscard]] virtual auto IsVectorized() const -> bool { return false; }
+
 protected:
   RecordSchemaUptr out_schema_;
   RecordUptr       record_;
@@ -23,26 +23,89 @@
 
 namespace wsdb {
 
-AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema) : schema_(schema) { WSDB_STUDENT_TODO(l3, t3); }
-AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema, const Record &record)
+AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema) : schema_(schema)
 {
-  WSDB_STUDENT_TODO(l3, t3);
+  // counts start from 0, the others are null until a non-null value is seen
+  for (const auto &field : schema_->GetFields()) {
+    if (field.agg_type_ == AGG_COUNT || field.agg_type_ == AGG_COUNT_STAR) {
+      values_.push_back(ValueFactory::CreateIntValue(0));
+    } else {
+      values_.push_back(ValueFactory::CreateNullValue(field.field_.field_type_));
+    }
+  }
+}
+
+AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema, const Record &record) : schema_(schema)
+{
+  auto rec_schema = record.GetSchema();
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    const auto &field = schema_->GetFieldAt(i);
+    if (field.agg_type_ == AGG_COUNT_STAR) {
+      values_.push_back(ValueFactory::CreateIntValue(1));
+      continue;
+    }
+    auto value = record.GetValueAt(rec_schema->GetFieldIndex(field.field_.table_id_, field.field_.field_name_));
+    if (field.agg_type_ == AGG_COUNT) {
+      values_.push_back(ValueFactory::CreateIntValue(value->IsNull() ? 0 : 1));
+    } else {
+      if (field.agg_type_ == AGG_AVG) {
+        avg_count_map_[i] = value->IsNull() ? 0 : 1;
+      }
+      values_.push_back(value);
+    }
+  }
 }
+
 void AggregateExecutor::AggregateValue::CombineWith(const AggregateExecutor::AggregateValue &other)
 {
-  WSDB_STUDENT_TODO(l3, t3);
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    const auto &other_val = other.values_[i];
+    if (other_val->IsNull()) {
+      continue;
+    }
+    switch (schema_->GetFieldAt(i).agg_type_) {
+      case AGG_AVG: avg_count_map_[i] += other.avg_count_map_.at(i); [[fallthrough]];
+      case AGG_COUNT:
+      case AGG_COUNT_STAR:
+      case AGG_SUM: *values_[i] += *other_val; break;
+      case AGG_MAX:
+        if (values_[i]->IsNull() || *other_val > *values_[i]) {
+          values_[i] = other_val;
+        }
+        break;
+      case AGG_MIN:
+        if (values_[i]->IsNull() || *other_val < *values_[i]) {
+          values_[i] = other_val;
+        }
+        break;
+      default: WSDB_FETAL("Unknown aggregate type");
+    }
+  }
 }
 
 auto AggregateExecutor::AggregateValue::Values() const -> const std::vector<ValueSptr> & { return values_; }
 
-void AggregateExecutor::AggregateValue::Finalize() { WSDB_STUDENT_TODO(l3, t3); }
+void AggregateExecutor::AggregateValue::Finalize()
+{
+  if (summarized_) {
+    return;
+  }
+  for (const auto &[idx, cnt] : avg_count_map_) {
+    if (cnt != 0) {
+      *values_[idx] /= cnt;
+    }
+  }
+  summarized_ = true;
+}
 
 AggregateExecutor::AggregateExecutor(
     AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema)
     : AbstractExecutor(Basic),
       child_(std::move(child)),
       agg_schema_(std::move(agg_schema)),
-      group_schema_(std::move(group_schema))
+      group_schema_(std::move(group_schema)),
+      group_map_(0, RecordHasher(group_schema_.get(), group_schema_.get()),
+          RecordEqual(RecordComparator(group_schema_.get(), group_schema_.get())))
 {
   std::vector<RTField> fields;
   for (const auto &field : group_schema_->GetFields()) {
@@ -54,10 +117,54 @@ AggregateExecutor::AggregateExecutor(
   out_schema_ = std::make_unique<RecordSchema>(fields);
 }
 
-void AggregateExecutor::Init() { WSDB_STUDENT_TODO(l3, t3); }
+void AggregateExecutor::Init()
+{
+  // the values built for every child row are dropped right away, they go to the heap instead of the statement arena
+  ArenaScope heap(nullptr);
+  group_map_.clear();
+  for (child_->Init(); !child_->IsEnd(); child_->Next()) {
+    auto record = child_->GetRecord();
+    auto key    = Record(group_schema_.get(), *record);
+    auto value  = AggregateValue(agg_schema_.get(), *record);
+    if (auto iter = group_map_.find(key); iter != group_map_.end()) {
+      iter->second.CombineWith(value);
+    } else {
+      group_map_.emplace(std::move(key), std::move(value));
+    }
+  }
+  // aggregation without group by always returns a row, e.g. count(*) of an empty table is 0
+  if (group_map_.empty() && group_schema_->GetFieldCount() == 0) {
+    group_map_.emplace(Record(group_schema_.get()), AggregateValue(agg_schema_.get()));
+  }
+  for (auto &[key, value] : group_map_) {
+    value.Finalize();
+  }
+  group_iter_ = group_map_.begin();
+  LoadRecord();
+}
 
-void AggregateExecutor::Next() { WSDB_STUDENT_TODO(l3, t3); }
+void AggregateExecutor::Next()
+{
+  ++group_iter_;
+  LoadRecord();
+}
 
-auto AggregateExecutor::IsEnd() const -> bool { WSDB_STUDENT_TODO(l3, t3); }
+auto AggregateExecutor::IsEnd() const -> bool { return group_iter_ == group_map_.end(); }
+
+void AggregateExecutor::LoadRecord()
+{
+  if (IsEnd()) {
+    record_ = nullptr;
+    return;
+  }
+  ArenaScope             heap(nullptr);
+  std::vector<ValueSptr> values;
+  for (size_t i = 0; i < group_schema_->GetFieldCount(); ++i) {
+    values.push_back(group_iter_->first.GetValueAt(i));
+  }
+  const auto &agg_values = group_iter_->second.Values();
+  values.insert(values.end(), agg_values.begin(), agg_values.end());
+  record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+}
 
 }  // namespace wsdb
\ No newline at end of file
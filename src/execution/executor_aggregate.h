@@ -23,6 +23,7 @@
 #define WSDB_EXECUTOR_AGGREGATE_H
 #include <unordered_map>
 #include "executor_abstract.h"
+#include "system/handle/record_comparator.h"
 
 namespace wsdb {
 
@@ -38,6 +39,9 @@ public:
   [[nodiscard]] auto IsEnd() const -> bool override;
 
 private:
+  /// build record_ from the group group_iter_ points to
+  void LoadRecord();
+
   // aggregate value behaves like a writable record
   class AggregateValue
   {
@@ -75,11 +79,14 @@ private:
   };
 
 private:
-  AbstractExecutorUptr                                 child_;
-  RecordSchemaUptr                                     agg_schema_;
-  RecordSchemaUptr                                     group_schema_;
-  std::unordered_map<Record, AggregateValue>           group_map_;
-  std::unordered_map<Record, AggregateValue>::iterator group_iter_;
+  using GroupMap = std::unordered_map<Record, AggregateValue, RecordHasher, RecordEqual>;
+
+  AbstractExecutorUptr child_;
+  RecordSchemaUptr     agg_schema_;
+  RecordSchemaUptr     group_schema_;
+  // keys are group key records, hashed and compared on raw bytes by functors compiled for group_schema_
+  GroupMap           group_map_;
+  GroupMap::iterator group_iter_;
 };
 
 }  // namespace wsdb
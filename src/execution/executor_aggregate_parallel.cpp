@@ -0,0 +1,205 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/4.
+//
+
+#include "executor_aggregate_parallel.h"
+#include <algorithm>
+#include <numeric>
+#include "worker_pool.h"
+
+namespace wsdb {
+
+ParallelAggregateExecutor::ParallelAggregateExecutor(TableHandle *tab, std::vector<ExchangePipeline> pipelines,
+    RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema, size_t morsel_pages, size_t mem_budget)
+    : AbstractExecutor(Basic),
+      exchange_(tab, std::move(pipelines), morsel_pages),
+      agg_schema_(std::move(agg_schema)),
+      group_schema_(std::move(group_schema)),
+      locals_(exchange_.GetPipelineNum()),
+      parts_(AGG_PARTITION_NUM),
+      spill_(mem_budget)
+{
+  auto child_schema = exchange_.GetOutSchema();
+  for (auto &local : locals_) {
+    local.table_ = std::make_unique<AggregateHashTable>(child_schema, agg_schema_.get(), group_schema_.get());
+    // the other half of the budget is left to the merged partitions
+    local.spill_ = std::make_unique<AggregateSpill>(mem_budget / 2 / locals_.size());
+  }
+  for (auto &part : parts_) {
+    part = std::make_unique<AggregateHashTable>(child_schema, agg_schema_.get(), group_schema_.get());
+  }
+  std::vector<RTField> fields;
+  for (const auto &field : group_schema_->GetFields()) {
+    fields.push_back(field);
+  }
+  for (const auto &field : agg_schema_->GetFields()) {
+    fields.push_back(field);
+  }
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+  out_buf_    = std::make_unique<char[]>(BITMAP_SIZE(out_schema_->GetFieldCount()) + out_schema_->GetRecordLength());
+}
+
+void ParallelAggregateExecutor::Init()
+{
+  spill_.Clear();
+  for (auto &local : locals_) {
+    local.table_->Clear();
+    local.spill_->Clear();
+  }
+  exchange_.Drain([this](size_t idx, size_t /*morsel*/, const RecordBatch &batch) { Aggregate(idx, batch); });
+  auto &pool       = WorkerPool::GetInstance();
+  auto  worker_num = locals_.size();
+  pool.ParallelFor(locals_.size(), worker_num, [this](size_t idx) { Partition(idx); });
+  if (std::any_of(locals_.begin(), locals_.end(), [](const auto &local) { return local.spill_->IsSpilled(); })) {
+    // a group left in the table of a worker may have partial states in the files of the others
+    pool.ParallelFor(locals_.size(), worker_num, [this](size_t idx) {
+      if (locals_[idx].table_->GetGroupNum() > 0) {
+        locals_[idx].spill_->Spill(*locals_[idx].table_);
+      }
+    });
+    for (auto &local : locals_) {
+      spill_.Absorb(*local.spill_);
+    }
+    LoadSpilled();
+  } else {
+    pool.ParallelFor(parts_.size(), worker_num, [this](size_t part) { Merge(part); });
+    groups_.clear();
+    for (uint32_t part = 0; part < parts_.size(); ++part) {
+      for (uint32_t gid = 0; gid < parts_[part]->GetGroupNum(); ++gid) {
+        groups_.emplace_back(part, gid);
+      }
+    }
+  }
+  // aggregation without group by always returns a row, e.g. count(*) of an empty table is 0
+  if (groups_.empty() && group_schema_->GetFieldCount() == 0) {
+    parts_.front()->AddEmptyGroup();
+    groups_.emplace_back(0, 0);
+  }
+  cursor_ = 0;
+  if (!IsEnd()) {
+    WriteGroup(cursor_, out_buf_.get());
+  }
+}
+
+void ParallelAggregateExecutor::Next()
+{
+  if (Advance()) {
+    WriteGroup(cursor_, out_buf_.get());
+  }
+}
+
+auto ParallelAggregateExecutor::IsEnd() const -> bool { return cursor_ >= groups_.size(); }
+
+auto ParallelAggregateExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  auto nullmap_size = BITMAP_SIZE(out_schema_->GetFieldCount());
+  return {out_schema_.get(), out_buf_.get(), out_buf_.get() + nullmap_size, INVALID_RID};
+}
+
+auto ParallelAggregateExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  for (; !IsEnd() && !batch.IsFull(); Advance()) {
+    WriteGroup(cursor_, batch.AppendSlot(INVALID_RID));
+  }
+  return batch.GetSelSize() > 0;
+}
+
+auto ParallelAggregateExecutor::Advance() -> bool
+{
+  if (++cursor_ < groups_.size()) {
+    return true;
+  }
+  if (spill_.IsSpilled() && LoadSpilled()) {
+    cursor_ = 0;
+    return true;
+  }
+  return false;
+}
+
+void ParallelAggregateExecutor::Aggregate(size_t idx, const RecordBatch &batch)
+{
+  auto &local = locals_[idx];
+  // the positions of the rows only order the groups, which is left unspecified
+  local.table_->Update(batch, 0);
+  if (local.spill_->IsFull(*local.table_)) {
+    local.spill_->Spill(*local.table_);
+  }
+}
+
+void ParallelAggregateExecutor::Partition(size_t idx)
+{
+  auto &local = locals_[idx];
+  // counting sort of the group ids by partition
+  auto                group_num = local.table_->GetGroupNum();
+  std::vector<size_t> part_of(group_num);
+  local.part_begin_.assign(AGG_PARTITION_NUM + 1, 0);
+  for (size_t gid = 0; gid < group_num; ++gid) {
+    part_of[gid] = PartitionOf(local.table_->GetHash(gid));
+    local.part_begin_[part_of[gid] + 1]++;
+  }
+  std::partial_sum(local.part_begin_.begin(), local.part_begin_.end(), local.part_begin_.begin());
+  auto next = local.part_begin_;
+  local.part_gids_.resize(group_num);
+  for (size_t gid = 0; gid < group_num; ++gid) {
+    local.part_gids_[next[part_of[gid]]++] = static_cast<uint32_t>(gid);
+  }
+}
+
+void ParallelAggregateExecutor::Merge(size_t part)
+{
+  auto &merged = *parts_[part];
+  merged.Clear();
+  for (const auto &local : locals_) {
+    for (auto i = local.part_begin_[part]; i < local.part_begin_[part + 1]; ++i) {
+      merged.Merge(*local.table_, local.part_gids_[i]);
+    }
+  }
+}
+
+auto ParallelAggregateExecutor::LoadSpilled() -> bool
+{
+  groups_.clear();
+  auto &table = *parts_.front();
+  if (!spill_.Next(table)) {
+    return false;
+  }
+  for (uint32_t gid = 0; gid < table.GetGroupNum(); ++gid) {
+    groups_.emplace_back(0, gid);
+  }
+  return true;
+}
+
+void ParallelAggregateExecutor::WriteGroup(size_t idx, char *slot) const
+{
+  auto [part, gid] = groups_[idx];
+  parts_[part]->WriteGroup(gid, out_schema_.get(), slot);
+}
+
+auto ParallelAggregateExecutor::PartitionOf(size_t hash) -> size_t
+{
+  // slots of the tables are indexed by the low bits of the hash, the partition is taken from the high bits of a remix
+  return ((hash * 0x9e3779b97f4a7c15ULL) >> 32) % AGG_PARTITION_NUM;
+}
+
+}  // namespace wsdb
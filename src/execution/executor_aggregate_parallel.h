@@ -0,0 +1,120 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/4.
+//
+
+/**
+ * @brief Two-phase hash aggregation of the rows of pipelines run in parallel, the pipelines are driven by an exchange
+ * 1. the exchange runs every pipeline over the morsels its worker takes and the worker aggregates the batches into a
+ *    table of its own, no state is shared while rows are aggregated. The groups of the tables are then radix
+ *    partitioned on their hashes
+ * 2. every partition is merged by a worker, which combines the partial states of its groups from all the tables
+ * The rows are those of AggregateExecutorVec over an exchange, but the order of the groups is unspecified, they are
+ * returned one partition at a time whether they were spilled or not.
+ * Merging copies the groups while the tables of the workers are still alive, so the tables of the workers have half of
+ * the memory budget, shared equally, and the merged partitions, which hold no more groups, the other half. When the
+ * table of a worker exceeds its share, its groups are spilled as partial aggregates, and if any worker spilled, the
+ * groups of all of them are spilled instead of merged in memory. The partitions of all the workers are then aggregated
+ * one at a time by AggregateSpill as the rows are returned.
+ */
+
+#ifndef WSDB_EXECUTOR_AGGREGATE_PARALLEL_H
+#define WSDB_EXECUTOR_AGGREGATE_PARALLEL_H
+
+#include "aggregate_hash_table.h"
+#include "aggregate_spill.h"
+#include "executor_exchange.h"
+
+namespace wsdb {
+
+class ParallelAggregateExecutor : public AbstractExecutor
+{
+public:
+  /**
+   * @param tab table whose pages are split into morsels
+   * @param pipelines one per worker, as under an exchange
+   * @param agg_schema aggregates of the rows of the pipelines
+   * @param group_schema fields the rows are grouped by
+   * @param morsel_pages pages in a morsel
+   * @param mem_budget bytes of groups kept in memory by all the workers and the merged partitions
+   */
+  ParallelAggregateExecutor(TableHandle *tab, std::vector<ExchangePipeline> pipelines, RecordSchemaUptr agg_schema,
+      RecordSchemaUptr group_schema, size_t morsel_pages = MORSEL_PAGE_NUM, size_t mem_budget = AGG_BUFFER_SIZE);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return true; }
+
+private:
+  /// groups a worker aggregated from its pipeline
+  struct LocalGroups
+  {
+    AggregateHashTableUptr table_;
+    AggregateSpillUptr     spill_;
+    // group ids of the table by partition, those of partition p are in [part_begin_[p], part_begin_[p + 1])
+    std::vector<uint32_t> part_gids_;
+    std::vector<size_t>   part_begin_;
+  };
+
+  /// phase 1, aggregate a batch of pipeline idx
+  void Aggregate(size_t idx, const RecordBatch &batch);
+
+  /// end of phase 1 of pipeline idx, partition the groups of its table
+  void Partition(size_t idx);
+
+  /// phase 2 of partition part
+  void Merge(size_t part);
+
+  /// aggregate the next spilled partition into the table of the first partition, returns false if there is none
+  auto LoadSpilled() -> bool;
+
+  /// move to the next group, loading the next spilled partition at the end of the groups, returns false at the end
+  auto Advance() -> bool;
+
+  void WriteGroup(size_t idx, char *slot) const;
+
+  static auto PartitionOf(size_t hash) -> size_t;
+
+private:
+  ExchangeExecutor         exchange_;
+  RecordSchemaUptr         agg_schema_;
+  RecordSchemaUptr         group_schema_;
+  std::vector<LocalGroups> locals_;
+  // groups of every partition merged from all workers
+  std::vector<AggregateHashTableUptr> parts_;
+  // the partitions spilled by all the workers
+  AggregateSpill spill_;
+  // partition and group id of the groups in the output
+  std::vector<std::pair<uint32_t, uint32_t>> groups_;
+  // index of the current group in the output
+  size_t                  cursor_{0};
+  std::unique_ptr<char[]> out_buf_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_AGGREGATE_PARALLEL_H
@@ -21,4 +21,92 @@
 
 #include "executor_aggregate_vec.h"
 
-namespace wsdb {}  // namespace wsdb
\ No newline at end of file
+namespace wsdb {
+
+AggregateExecutorVec::AggregateExecutorVec(
+    AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema, size_t mem_budget)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      agg_schema_(std::move(agg_schema)),
+      group_schema_(std::move(group_schema)),
+      table_(std::make_unique<AggregateHashTable>(child_->GetOutSchema(), agg_schema_.get(), group_schema_.get())),
+      spill_(mem_budget)
+{
+  std::vector<RTField> fields;
+  for (const auto &field : group_schema_->GetFields()) {
+    fields.push_back(field);
+  }
+  for (const auto &field : agg_schema_->GetFields()) {
+    fields.push_back(field);
+  }
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+  out_buf_    = std::make_unique<char[]>(BITMAP_SIZE(out_schema_->GetFieldCount()) + out_schema_->GetRecordLength());
+}
+
+void AggregateExecutorVec::Init()
+{
+  table_->Clear();
+  spill_.Clear();
+  auto     batch = RecordBatch(child_->GetOutSchema());
+  uint64_t pos   = 0;
+  for (child_->Init(); child_->NextBatch(batch); pos += batch.GetSelSize()) {
+    table_->Update(batch, pos);
+    if (spill_.IsFull(*table_)) {
+      spill_.Spill(*table_);
+    }
+  }
+  // the groups left in the table may have partial states in the files too
+  if (spill_.IsSpilled()) {
+    spill_.Spill(*table_);
+    spill_.Next(*table_);
+  }
+  // aggregation without group by always returns a row, e.g. count(*) of an empty table is 0
+  if (table_->GetGroupNum() == 0 && group_schema_->GetFieldCount() == 0) {
+    table_->AddEmptyGroup();
+  }
+  cursor_ = 0;
+  if (!IsEnd()) {
+    table_->WriteGroup(cursor_, out_schema_.get(), out_buf_.get());
+  }
+}
+
+void AggregateExecutorVec::Next()
+{
+  if (Advance()) {
+    table_->WriteGroup(cursor_, out_schema_.get(), out_buf_.get());
+  }
+}
+
+auto AggregateExecutorVec::IsEnd() const -> bool { return cursor_ >= table_->GetGroupNum(); }
+
+auto AggregateExecutorVec::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  auto nullmap_size = BITMAP_SIZE(out_schema_->GetFieldCount());
+  return {out_schema_.get(), out_buf_.get(), out_buf_.get() + nullmap_size, INVALID_RID};
+}
+
+auto AggregateExecutorVec::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  for (; !IsEnd() && !batch.IsFull(); Advance()) {
+    table_->WriteGroup(cursor_, out_schema_.get(), batch.AppendSlot(INVALID_RID));
+  }
+  return batch.GetSelSize() > 0;
+}
+
+auto AggregateExecutorVec::Advance() -> bool
+{
+  if (++cursor_ < table_->GetGroupNum()) {
+    return true;
+  }
+  if (spill_.IsSpilled() && spill_.Next(*table_)) {
+    cursor_ = 0;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace wsdb
@@ -19,14 +19,54 @@
 // Created by ziqi on 2024/8/12.
 //
 
+/**
+ * @brief Hash aggregation over batches of the child, returns the same rows as AggregateExecutor
+ * the batches are aggregated into an AggregateHashTable, groups are returned in the order they are first seen. When
+ * the table exceeds the memory budget, its groups are spilled as partial aggregates by AggregateSpill, and the groups
+ * are returned one partition at a time once the child is read, no longer in the order they are first seen.
+ */
+
 #ifndef WSDB_EXECUTOR_AGGREGATE_VEC_H
 #define WSDB_EXECUTOR_AGGREGATE_VEC_H
+#include "aggregate_hash_table.h"
+#include "aggregate_spill.h"
 #include "executor_abstract.h"
 
 namespace wsdb {
 
 class AggregateExecutorVec : public AbstractExecutor
-{};
+{
+public:
+  /// @param mem_budget bytes of groups kept in memory
+  AggregateExecutorVec(AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema,
+      size_t mem_budget = AGG_BUFFER_SIZE);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
+
+private:
+  /// move to the next group, loading the next spilled partition at the end of the table, returns false at the end
+  auto Advance() -> bool;
+
+private:
+  AbstractExecutorUptr   child_;
+  RecordSchemaUptr       agg_schema_;
+  RecordSchemaUptr       group_schema_;
+  AggregateHashTableUptr table_;
+  AggregateSpill         spill_;
+  // index of the current group of table_ in the output
+  size_t                  cursor_{0};
+  std::unique_ptr<char[]> out_buf_;
+};
 
 }  // namespace wsdb
 
@@ -0,0 +1,304 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+#include "executor_exchange.h"
+#include "worker_pool.h"
+
+namespace wsdb {
+
+ExchangeExecutor::ExchangeExecutor(TableHandle *tab, std::vector<ExchangePipeline> pipelines, size_t morsel_pages)
+    : AbstractExecutor(Basic),
+      tab_(tab),
+      pipelines_(std::move(pipelines)),
+      morsels_(morsel_pages),
+      parent_pipeline_(pipelines_.size())
+{
+  WSDB_ASSERT(!pipelines_.empty(), "an exchange needs at least one pipeline");
+}
+
+ExchangeExecutor::~ExchangeExecutor() { Stop(); }
+
+void ExchangeExecutor::Init()
+{
+  Stop();
+  Start();
+  FetchBatch();
+  Advance();
+}
+
+void ExchangeExecutor::Next()
+{
+  pos_++;
+  Advance();
+}
+
+auto ExchangeExecutor::IsEnd() const -> bool { return cur_ == nullptr; }
+
+auto ExchangeExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  return cur_->GetRow(pos_);
+}
+
+auto ExchangeExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  Advance();
+  for (; cur_ != nullptr && pos_ < cur_->GetSelSize() && !batch.IsFull(); ++pos_) {
+    batch.AppendView(cur_->GetRow(pos_));
+  }
+  return batch.GetSelSize() > 0;
+}
+
+auto ExchangeExecutor::GetOutSchema() const -> const RecordSchema * { return pipelines_.front().root_->GetOutSchema(); }
+
+void ExchangeExecutor::Drain(const Sink &sink)
+{
+  Stop();
+  sink_ = sink;
+  Start();
+  std::exception_ptr error;
+  try {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      TakeParentPipeline();
+    }
+    if (parent_pipeline_ != pipelines_.size()) {
+      for (size_t morsel; morsels_.Next(morsel);) {
+        if (!RunMorsel(parent_pipeline_, morsel, true)) {
+          break;
+        }
+      }
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // every morsel is taken, so a task not started by the pool would have nothing left to do
+  CancelTasks();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (error != nullptr) {
+      stop_ = true;
+      worker_cv_.notify_all();
+    }
+    parent_cv_.wait(lock, [this] { return running_ == 0; });
+    if (error == nullptr) {
+      error = error_;
+    }
+  }
+  sink_ = nullptr;
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ExchangeExecutor::Start()
+{
+  morsels_.Reset(FILE_HEADER_PAGE_ID + 1, static_cast<page_id_t>(tab_->GetTableHeader().page_num_));
+  outputs_ = std::vector<MorselOutput>(morsels_.GetMorselNum());
+  started_.assign(pipelines_.size(), false);
+  parent_pipeline_ = pipelines_.size();
+  next_morsel_     = 0;
+  buffered_        = 0;
+  stop_            = false;
+  error_           = nullptr;
+  cur_.reset();
+  pos_ = 0;
+  // more workers than morsels would have nothing to do
+  auto task_num = std::min(pipelines_.size(), morsels_.GetMorselNum());
+  running_      = task_num;
+  for (size_t i = 0; i < task_num; ++i) {
+    tickets_.push_back(WorkerPool::GetInstance().Submit([this, i] { Work(i); }));
+  }
+}
+
+void ExchangeExecutor::Work(size_t idx)
+{
+  bool is_taken;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_taken      = started_[idx] || stop_;
+    started_[idx] = true;
+  }
+  if (!is_taken) {
+    try {
+      for (size_t morsel; morsels_.Next(morsel);) {
+        if (!RunMorsel(idx, morsel, false)) {
+          break;
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error_ == nullptr) {
+        error_ = std::current_exception();
+      }
+      stop_ = true;
+      worker_cv_.notify_all();
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_--;
+  parent_cv_.notify_all();
+}
+
+auto ExchangeExecutor::RunMorsel(size_t idx, size_t morsel, bool is_parent) -> bool
+{
+  auto &pipeline   = pipelines_[idx];
+  *pipeline.range_ = morsels_.GetRange(morsel);
+  pipeline.root_->Init();
+  while (true) {
+    auto batch = TakeBatch();
+    if (!pipeline.root_->NextBatch(*batch)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(std::move(batch));
+      break;
+    }
+    if (sink_ != nullptr) {
+      sink_(idx, morsel, *batch);
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(std::move(batch));
+      if (stop_) {
+        return false;
+      }
+      continue;
+    }
+    if (!Push(morsel, std::move(batch), is_parent)) {
+      return false;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  outputs_[morsel].done_ = true;
+  parent_cv_.notify_all();
+  return true;
+}
+
+auto ExchangeExecutor::Push(size_t morsel, RecordBatchUptr batch, bool is_parent) -> bool
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  // the morsel the parent waits for is always let in, so later morsels can not keep the buffer full for good
+  worker_cv_.wait(lock, [&] {
+    return stop_ || is_parent || morsel == next_morsel_ || buffered_ < EXCHANGE_BUFFER_BATCHES * pipelines_.size();
+  });
+  if (stop_) {
+    free_.push_back(std::move(batch));
+    return false;
+  }
+  outputs_[morsel].batches_.push_back(std::move(batch));
+  buffered_++;
+  parent_cv_.notify_all();
+  return true;
+}
+
+auto ExchangeExecutor::TakeBatch() -> RecordBatchUptr
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      auto batch = std::move(free_.back());
+      free_.pop_back();
+      batch->Reset();
+      return batch;
+    }
+  }
+  return std::make_unique<RecordBatch>(GetOutSchema());
+}
+
+void ExchangeExecutor::FetchBatch()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (cur_ != nullptr) {
+    free_.push_back(std::move(cur_));
+  }
+  pos_ = 0;
+  while (next_morsel_ < outputs_.size()) {
+    if (error_ != nullptr) {
+      std::rethrow_exception(error_);
+    }
+    auto &output = outputs_[next_morsel_];
+    if (!output.batches_.empty()) {
+      cur_ = std::move(output.batches_.front());
+      output.batches_.pop_front();
+      buffered_--;
+      worker_cv_.notify_all();
+      return;
+    }
+    if (output.done_) {
+      next_morsel_++;
+      worker_cv_.notify_all();
+      continue;
+    }
+    // the workers may not have been started by the pool yet, then the parent works on a morsel instead of waiting
+    TakeParentPipeline();
+    size_t morsel;
+    if (parent_pipeline_ != pipelines_.size() && morsels_.Next(morsel)) {
+      lock.unlock();
+      RunMorsel(parent_pipeline_, morsel, true);
+      lock.lock();
+      continue;
+    }
+    parent_cv_.wait(lock);
+  }
+}
+
+void ExchangeExecutor::TakeParentPipeline()
+{
+  if (parent_pipeline_ != pipelines_.size()) {
+    return;
+  }
+  auto it = std::find(started_.begin(), started_.end(), false);
+  if (it != started_.end()) {
+    *it              = true;
+    parent_pipeline_ = static_cast<size_t>(it - started_.begin());
+  }
+}
+
+void ExchangeExecutor::Advance()
+{
+  while (cur_ != nullptr && pos_ >= cur_->GetSelSize()) {
+    FetchBatch();
+  }
+}
+
+void ExchangeExecutor::CancelTasks()
+{
+  for (auto ticket : tickets_) {
+    if (WorkerPool::GetInstance().Cancel(ticket)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_--;
+    }
+  }
+  tickets_.clear();
+}
+
+void ExchangeExecutor::Stop()
+{
+  // a queued task may be behind the worker of another exchange that waits for this thread to read its output
+  CancelTasks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  stop_ = true;
+  worker_cv_.notify_all();
+  parent_cv_.wait(lock, [this] { return running_ == 0; });
+}
+
+}  // namespace wsdb
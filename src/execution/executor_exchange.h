@@ -0,0 +1,167 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+/**
+ * @brief Gather the output of pipelines run in parallel by the workers of WorkerPool
+ * every pipeline is a copy of the same executor tree with a SeqScanExecutor at the bottom reading the pages of its
+ * PageRange, e.g. a filter over the scan, or a hash join probing a table shared by the pipelines with its rows. A
+ * worker points the range to a morsel it takes from the queue, runs the pipeline over it into batches the exchange owns
+ * and hands them over, then takes the next morsel. The batches are returned in the order of the morsels, so the rows
+ * come out in the order of a sequential scan, and at most EXCHANGE_BUFFER_BATCHES batches per worker are buffered ahead
+ * of the parent, except for the morsel it waits for.
+ * When the parent waits and a pipeline has not been started by the pool, e.g. the threads are busy with other
+ * queries, the thread of the parent runs that pipeline over a morsel itself, so the query makes progress anyway.
+ * An operator that consumes the rows of every worker on that worker, e.g. ParallelAggregateExecutor, drains the
+ * pipelines into a sink instead, the batches are then handed to the sink as they are produced and not buffered.
+ */
+
+#ifndef WSDB_EXECUTOR_EXCHANGE_H
+#define WSDB_EXECUTOR_EXCHANGE_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include "executor_abstract.h"
+#include "morsel.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+struct ExchangePipeline
+{
+  // pages the scan at the bottom of root_ reads, declared first so that it outlives root_
+  std::unique_ptr<PageRange> range_;
+  AbstractExecutorUptr       root_;
+};
+
+class ExchangeExecutor : public AbstractExecutor
+{
+public:
+  /// consumes a batch pipeline idx produced from morsel, on the thread that runs the pipeline
+  using Sink = std::function<void(size_t idx, size_t morsel, const RecordBatch &batch)>;
+
+  /**
+   * @param tab table whose pages are split into morsels
+   * @param pipelines one per worker, all with the same output schema
+   * @param morsel_pages pages in a morsel
+   */
+  ExchangeExecutor(TableHandle *tab, std::vector<ExchangePipeline> pipelines, size_t morsel_pages = MORSEL_PAGE_NUM);
+
+  /// stops the workers and waits for them
+  ~ExchangeExecutor() override;
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  /// batches reference the rows of a batch filled by a worker, which is kept until the next call
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return true; }
+
+  /**
+   * run the pipelines over all the morsels with the workers of the pool and the thread of the caller, passing the
+   * batches to sink in place of the parent, returns once every morsel is consumed and rethrows an error of a worker
+   */
+  void Drain(const Sink &sink);
+
+  [[nodiscard]] auto GetPipelineNum() const -> size_t { return pipelines_.size(); }
+
+private:
+  /// batches of a morsel in the order they are produced, done_ is set after the last one
+  struct MorselOutput
+  {
+    std::deque<RecordBatchUptr> batches_;
+    bool                        done_{false};
+  };
+
+  /// split the table into morsels and submit a task for every pipeline that has a morsel to run
+  void Start();
+
+  /// body of the task of pipeline idx, returns at once if the pipeline is already taken by the parent
+  void Work(size_t idx);
+
+  /// run pipeline idx over morsel, outputs are buffered without limit if is_parent, returns false if stopped
+  auto RunMorsel(size_t idx, size_t morsel, bool is_parent) -> bool;
+
+  /// let the parent take a pipeline not started by the pool, requires mutex_
+  void TakeParentPipeline();
+
+  /// hand a batch of morsel over, waiting for room in the buffer unless is_parent, returns false if stopped
+  auto Push(size_t morsel, RecordBatchUptr batch, bool is_parent) -> bool;
+
+  /// a batch from the free list, or a new one
+  auto TakeBatch() -> RecordBatchUptr;
+
+  /// replace cur_ by the next batch in morsel order, cur_ is nullptr at the end
+  void FetchBatch();
+
+  /// skip to a batch with rows left to read
+  void Advance();
+
+  /// cancel the tasks not started by the pool
+  void CancelTasks();
+
+  /// tell the workers to stop, cancel the tasks not started by the pool and wait until the others have returned
+  void Stop();
+
+private:
+  TableHandle                  *tab_;
+  std::vector<ExchangePipeline> pipelines_;
+  MorselQueue                   morsels_;
+
+  std::mutex mutex_;
+  // the parent waits for batches and for the tasks to return, the workers wait for room in the buffer
+  std::condition_variable parent_cv_;
+  std::condition_variable worker_cv_;
+  // set when a pipeline is taken by a worker or by the parent, parent_pipeline_ is the one of the parent
+  std::vector<bool>         started_;
+  size_t                    parent_pipeline_;
+  std::vector<MorselOutput> outputs_;
+  // morsel the parent reads from, all before it are drained
+  size_t next_morsel_{0};
+  size_t buffered_{0};
+  // tasks submitted to the pool that have not returned or been cancelled
+  std::vector<size_t>          tickets_;
+  size_t                       running_{0};
+  bool                         stop_{false};
+  std::exception_ptr           error_;
+  std::vector<RecordBatchUptr> free_;
+  // set while the pipelines are drained
+  Sink sink_;
+
+  // batch the parent reads and its position in it
+  RecordBatchUptr cur_;
+  size_t          pos_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_EXCHANGE_H
@@ -23,14 +23,57 @@
 
 namespace wsdb {
 
-FilterExecutor::FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter)
+FilterExecutor::FilterExecutor(AbstractExecutorUptr child, std::function<bool(const RecordView &)> filter)
     : AbstractExecutor(Basic), child_(std::move(child)), filter_(std::move(filter))
 {}
-void FilterExecutor::Init() { WSDB_STUDENT_TODO(l2, t1); }
 
-void FilterExecutor::Next() { WSDB_STUDENT_TODO(l2, t1); }
+FilterExecutor::FilterExecutor(AbstractExecutorUptr child, Predicate predicate)
+    : AbstractExecutor(Basic), child_(std::move(child)), predicate_(std::move(predicate))
+{}
+
+void FilterExecutor::Init()
+{
+  child_->Init();
+  SkipRejected();
+}
+
+void FilterExecutor::Next()
+{
+  child_->Next();
+  SkipRejected();
+}
+
+auto FilterExecutor::IsEnd() const -> bool { return child_->IsEnd(); }
+
+auto FilterExecutor::GetRecordView() const -> RecordView { return child_->GetRecordView(); }
+
+void FilterExecutor::SkipRejected()
+{
+  while (!child_->IsEnd() && !Pass(child_->GetRecordView())) {
+    child_->Next();
+  }
+}
 
-auto FilterExecutor::IsEnd() const -> bool { WSDB_STUDENT_TODO(l2, t1); }
+auto FilterExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  while (child_->NextBatch(batch)) {
+    auto sel = batch.GetSel();
+    if (filter_) {
+      size_t n = 0;
+      for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+        sel[n] = sel[i];
+        n += filter_(batch.GetRow(i));
+      }
+      batch.SetSelSize(n);
+    } else {
+      batch.SetSelSize(predicate_.Filter(batch.GetRows(), sel, batch.GetSelSize()));
+    }
+    if (batch.GetSelSize() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
 
 auto FilterExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
 }  // namespace wsdb
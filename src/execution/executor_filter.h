@@ -21,20 +21,24 @@
 
 /**
  * @brief Filter out the records that can not pass the filter function
- * 
+ * records are evaluated and passed on as views of the child's records, nothing is copied
  */
 
 #ifndef WSDB_EXECUTOR_FILTER_H
 #define WSDB_EXECUTOR_FILTER_H
 #include <functional>
 #include "executor_abstract.h"
+#include "expr/predicate.h"
 
 namespace wsdb {
 
 class FilterExecutor : public AbstractExecutor
 {
 public:
-  FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter);
+  FilterExecutor(AbstractExecutorUptr child, std::function<bool(const RecordView &)> filter);
+
+  /// filter with the compiled kernels of predicate, which should be bound to the child's output schema
+  FilterExecutor(AbstractExecutorUptr child, Predicate predicate);
 
   void Init() override;
 
@@ -44,9 +48,27 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  /// filter the batches of the child in place by shrinking their selection vectors
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
+
+private:
+  /// advance the child until its current record passes the filter
+  void SkipRejected();
+
+  [[nodiscard]] auto Pass(const RecordView &record) const -> bool
+  {
+    return filter_ ? filter_(record) : predicate_.Eval(record);
+  }
+
 private:
-  AbstractExecutorUptr                child_;
-  std::function<bool(const Record &)> filter_;
+  AbstractExecutorUptr                    child_;
+  std::function<bool(const RecordView &)> filter_;
+  // used when filter_ is empty
+  Predicate predicate_;
 };
 
 }  // namespace wsdb
@@ -23,7 +23,7 @@
 
 namespace wsdb {
 
-InsertExecutor::InsertExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::vector<RecordUptr> inserts)
+InsertExecutor::InsertExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::vector<Record> inserts)
     : AbstractExecutor(DML), tbl_(tbl), indexes_(std::move(indexes)), inserts_(std::move(inserts)), is_end_(false)
 {
   std::vector<RTField> fields(1);
@@ -38,7 +38,15 @@ void InsertExecutor::Next()
   // number of inserted records
   int count = 0;
 
-  WSDB_STUDENT_TODO(l2, t1);
+  // records are written page by page through the batch path, then indexed with their new rids
+  auto rids = tbl_->InsertRecords(inserts_);
+  for (size_t i = 0; i < inserts_.size(); ++i) {
+    inserts_[i].SetRID(rids[i]);
+    for (auto &index : indexes_) {
+      index->InsertRecord(inserts_[i]);
+    }
+    count++;
+  }
 
   std::vector<ValueSptr> values{ValueFactory::CreateIntValue(count)};
   record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
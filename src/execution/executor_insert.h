@@ -35,7 +35,7 @@ namespace wsdb {
 class InsertExecutor : public AbstractExecutor
 {
 public:
-  InsertExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::vector<RecordUptr> inserts);
+  InsertExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::vector<Record> inserts);
 
   void Init() override;
 
@@ -46,7 +46,7 @@ public:
 private:
   TableHandle             *tbl_;
   std::list<IndexHandle *> indexes_;
-  std::vector<RecordUptr>  inserts_;
+  std::vector<Record>      inserts_;
   bool                     is_end_;
 };
 }  // namespace wsdb
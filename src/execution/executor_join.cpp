@@ -20,6 +20,7 @@
 //
 #include "executor_join.h"
 
+#include <cstring>
 #include <utility>
 namespace wsdb {
 JoinExecutor::JoinExecutor(
@@ -42,6 +43,35 @@ JoinExecutor::JoinExecutor(
     fields.push_back(right_schema->GetFieldAt(i));
   }
   out_schema_ = std::make_unique<RecordSchema>(fields);
+  predicate_  = Predicate(conditions_, out_schema_.get());
+}
+
+void JoinExecutor::ConcatRow(const RecordView &left, const RecordView *right, char *slot) const
+{
+  auto left_schema  = left_->GetOutSchema();
+  auto right_schema = right_->GetOutSchema();
+  auto left_cnt     = left_schema->GetFieldCount();
+  auto right_cnt    = right_schema->GetFieldCount();
+  auto nullmap_size = BITMAP_SIZE(left_cnt + right_cnt);
+  auto data         = slot + nullmap_size;
+  // left fields keep their offsets, right fields are shifted by the length of the left record
+  memset(slot, 0, nullmap_size);
+  memcpy(data, left.GetData(), left_schema->GetRecordLength());
+  for (size_t i = 0; i < left_cnt; ++i) {
+    if (left.IsNull(i)) {
+      BitMap::SetBit(slot, i, true);
+    }
+  }
+  if (right == nullptr) {
+    memset(data + left_schema->GetRecordLength(), 0, right_schema->GetRecordLength());
+  } else {
+    memcpy(data + left_schema->GetRecordLength(), right->GetData(), right_schema->GetRecordLength());
+  }
+  for (size_t i = 0; i < right_cnt; ++i) {
+    if (right == nullptr || right->IsNull(i)) {
+      BitMap::SetBit(slot, left_cnt + i, true);
+    }
+  }
 }
 
 void JoinExecutor::Init()
@@ -30,6 +30,7 @@
 
 #include "executor_abstract.h"
 #include "common/condition.h"
+#include "expr/predicate.h"
 
 namespace wsdb {
 class JoinExecutor : public AbstractExecutor
@@ -56,11 +57,26 @@ protected:
 
   [[nodiscard]] virtual auto IsEndOuterJoin() const -> bool = 0;
 
+  /**
+   * Write the joined row of left and right into slot, laid out as a record of the out schema: null map followed by
+   * data, left fields come first
+   * @param right nullptr to join left with a row of nulls, e.g. for unmatched rows of an outer join
+   */
+  void ConcatRow(const RecordView &left, const RecordView *right, char *slot) const;
+
+  /// view of a row written by ConcatRow
+  [[nodiscard]] auto GetRowView(const char *slot) const -> RecordView
+  {
+    return {out_schema_.get(), slot, slot + BITMAP_SIZE(out_schema_->GetFieldCount()), INVALID_RID};
+  }
+
 protected:
   JoinType             join_type_;
   AbstractExecutorUptr left_;
   AbstractExecutorUptr right_;
   ConditionVec         conditions_;
+  // conditions_ bound to the out schema, evaluated on joined rows
+  Predicate predicate_;
 };
 
 }  // namespace wsdb
@@ -0,0 +1,387 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/26.
+//
+
+#include "executor_join_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wsdb {
+struct HashJoinExecutor::SharedTable
+{
+  std::mutex             mutex_;
+  bool                   is_built_{false};
+  std::vector<Partition> parts_;
+};
+
+auto HashJoinExecutor::MakeSharedTable() -> std::shared_ptr<SharedTable> { return std::make_shared<SharedTable>(); }
+
+HashJoinExecutor::HashJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+    RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema, bool build_left, size_t mem_budget,
+    std::shared_ptr<SharedTable> shared_table)
+    // like sort merge join, the equal conditions have been converted to key schemas
+    : JoinExecutor(join_type, std::move(left), std::move(right), {}),
+      left_key_schema_(std::move(left_key_schema)),
+      right_key_schema_(std::move(right_key_schema)),
+      build_left_(build_left),
+      mem_budget_(mem_budget),
+      build_(build_left ? left_.get() : right_.get()),
+      probe_(build_left ? right_.get() : left_.get()),
+      build_slot_size_(
+          BITMAP_SIZE(build_->GetOutSchema()->GetFieldCount()) + build_->GetOutSchema()->GetRecordLength()),
+      // tables are at most half full
+      table_row_cost_(sizeof(size_t) + 2 * sizeof(Bucket)),
+      shared_table_(std::move(shared_table)),
+      parts_(shared_table_ != nullptr ? &shared_table_->parts_ : &own_parts_),
+      join_buf_(std::make_unique<char[]>(BITMAP_SIZE(out_schema_->GetFieldCount()) + out_schema_->GetRecordLength()))
+{
+  WSDB_ASSERT(left_key_schema_->GetFieldCount() == right_key_schema_->GetFieldCount(), "key field count mismatch");
+  // the matches of the build rows are marked by the pipeline that finds them
+  WSDB_ASSERT(shared_table_ == nullptr || join_type_ != OUTER_JOIN || !build_left_,
+      "outer join that builds on the left can not share its table");
+  for (size_t i = 0; i < left_key_schema_->GetFieldCount(); ++i) {
+    // int and float keys that compare equal do not hash to the same value
+    WSDB_ASSERT(left_key_schema_->GetFieldAt(i).field_.field_type_ ==
+                    right_key_schema_->GetFieldAt(i).field_.field_type_,
+        "hash join keys should have the same type");
+  }
+  auto build_key = build_left_ ? left_key_schema_.get() : right_key_schema_.get();
+  auto probe_key = build_left_ ? right_key_schema_.get() : left_key_schema_.get();
+  build_hasher_  = RecordHasher(build_key, build_->GetOutSchema());
+  probe_hasher_  = RecordHasher(probe_key, probe_->GetOutSchema());
+  build_cmp_     = RecordComparator(build_key, build_->GetOutSchema());
+  probe_cmp_     = RecordComparator(probe_key, probe_->GetOutSchema(), build_key, build_->GetOutSchema());
+}
+
+auto HashJoinExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  return GetRowView(join_buf_.get());
+}
+
+auto HashJoinExecutor::PartitionOf(size_t hash) const -> size_t
+{
+  // buckets are indexed by the low bits of the hash, so the hash is remixed before it picks a partition, and remixed
+  // differently at every level so that a spilled partition splits again when it is partitioned by the next pass
+  uint64_t h = hash ^ ((level_ + 1) * 0x9e3779b97f4a7c15ULL);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h % HASH_JOIN_PARTITION_NUM;
+}
+
+void HashJoinExecutor::Build()
+{
+  parts_->clear();
+  parts_->resize(HASH_JOIN_PARTITION_NUM);
+  size_t mem_used = 0;
+  auto   batch    = RecordBatch(build_->GetOutSchema());
+  auto   next     = [&]() { return build_file_ != nullptr ? build_file_->Read(batch) : build_->NextBatch(batch); };
+  if (build_file_ != nullptr) {
+    build_file_->Rewind();
+  } else {
+    build_->Init();
+  }
+  while (next()) {
+    for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+      const auto &row  = batch.GetRow(i);
+      auto       &part = (*parts_)[PartitionOf(build_hasher_.Hash(row))];
+      if (part.build_file_ != nullptr) {
+        part.build_file_->Append(row);
+        continue;
+      }
+      auto nullmap_size = BITMAP_SIZE(build_->GetOutSchema()->GetFieldCount());
+      // the rows of a partition grow by doubling, so its memory is what the vector holds, not what the rows fill
+      auto capacity = part.rows_.capacity();
+      part.rows_.resize((part.row_num_ + 1) * build_slot_size_);
+      auto slot = part.rows_.data() + part.row_num_ * build_slot_size_;
+      memcpy(slot, row.GetNullMap(), nullmap_size);
+      memcpy(slot + nullmap_size, row.GetData(), build_->GetOutSchema()->GetRecordLength());
+      part.row_num_++;
+      mem_used += part.rows_.capacity() - capacity + table_row_cost_;
+      // rows of a single key never split, past the max depth the partitions are joined in memory whatever their size
+      while (mem_used > mem_budget_ && level_ < HASH_JOIN_MAX_DEPTH && shared_table_ == nullptr) {
+        auto largest = std::max_element(parts_->begin(), parts_->end(), [](const Partition &l, const Partition &r) {
+          return l.row_num_ < r.row_num_;
+        });
+        mem_used -= Spill(*largest);
+      }
+    }
+  }
+  // the build input of a pass is no longer needed once it is partitioned
+  build_file_.reset();
+  for (auto &part : *parts_) {
+    if (part.build_file_ == nullptr) {
+      BuildTable(part);
+    }
+  }
+}
+
+auto HashJoinExecutor::Spill(Partition &part) -> size_t
+{
+  part.build_file_ = std::make_unique<SpillFile>(build_->GetOutSchema());
+  part.probe_file_ = std::make_unique<SpillFile>(probe_->GetOutSchema());
+  for (size_t i = 0; i < part.row_num_; ++i) {
+    part.build_file_->Append(GetBuildRow(part, i));
+  }
+  auto freed = part.rows_.capacity() + part.row_num_ * table_row_cost_;
+  part.row_num_ = 0;
+  std::vector<char>().swap(part.rows_);
+  return freed;
+}
+
+void HashJoinExecutor::BuildTable(Partition &part)
+{
+  // keep the load factor under 1/2 so that probe sequences stay short and always reach an empty slot
+  size_t capacity = 16;
+  while (capacity < part.row_num_ * 2) {
+    capacity <<= 1;
+  }
+  auto mask = capacity - 1;
+  part.buckets_.assign(capacity, {0, 0});
+  part.next_.assign(part.row_num_, 0);
+  // insert backwards so that prepending to the chains keeps the rows of a key in the order they are read
+  for (size_t i = part.row_num_; i-- > 0;) {
+    auto rec  = GetBuildRow(part, i);
+    auto hash = build_hasher_.Hash(rec);
+    for (auto pos = hash & mask;; pos = (pos + 1) & mask) {
+      auto &bucket = part.buckets_[pos];
+      if (bucket.head_ == 0) {
+        bucket = {hash, i + 1};
+        break;
+      }
+      if (bucket.hash_ == hash && build_cmp_.Equal(GetBuildRow(part, bucket.head_ - 1), rec)) {
+        part.next_[i] = bucket.head_;
+        bucket.head_  = i + 1;
+        break;
+      }
+    }
+  }
+  part.matched_.assign(join_type_ == OUTER_JOIN && build_left_ ? part.row_num_ : 0, false);
+}
+
+auto HashJoinExecutor::Lookup(const Partition &part, const RecordView &rec, size_t hash) const -> size_t
+{
+  auto mask = part.buckets_.size() - 1;
+  for (auto pos = hash & mask;; pos = (pos + 1) & mask) {
+    const auto &bucket = part.buckets_[pos];
+    if (bucket.head_ == 0) {
+      return 0;
+    }
+    if (bucket.hash_ == hash && probe_cmp_.Equal(rec, GetBuildRow(part, bucket.head_ - 1))) {
+      return bucket.head_;
+    }
+  }
+}
+
+auto HashJoinExecutor::Probe() -> bool
+{
+  auto is_outer = join_type_ == OUTER_JOIN;
+  while (true) {
+    if (probe_rec_ != nullptr) {
+      // all rows of the chain have the keys of the probe row, no need to compare again
+      if (chain_ != 0) {
+        auto idx       = chain_ - 1;
+        chain_         = probe_part_->next_[idx];
+        probe_matched_ = true;
+        if (!probe_part_->matched_.empty()) {
+          probe_part_->matched_[idx] = true;
+        }
+        out_probe_ = probe_rec_;
+        out_build_ = GetBuildRow(*probe_part_, idx);
+        has_build_ = true;
+        return true;
+      }
+      // the probe row stays valid until the probe batch is refilled
+      auto rec   = probe_rec_;
+      probe_rec_ = nullptr;
+      probe_pos_++;
+      if (is_outer && !build_left_ && !probe_matched_) {
+        out_probe_ = rec;
+        has_build_ = false;
+        return true;
+      }
+    }
+    if (probe_pos_ == probe_batch_->GetSelSize()) {
+      probe_pos_ = 0;
+      if (!(probe_file_ != nullptr ? probe_file_->Read(*probe_batch_) : probe_->NextBatch(*probe_batch_))) {
+        return false;
+      }
+    }
+    const auto &row  = probe_batch_->GetRow(probe_pos_);
+    auto        hash = probe_hasher_.Hash(row);
+    auto       &part = (*parts_)[PartitionOf(hash)];
+    if (part.probe_file_ != nullptr) {
+      // joined with the build rows of the partition by a later pass
+      part.probe_file_->Append(row);
+      probe_pos_++;
+      continue;
+    }
+    probe_rec_     = &row;
+    probe_part_    = &part;
+    chain_         = Lookup(part, row, hash);
+    probe_matched_ = false;
+  }
+}
+
+auto HashJoinExecutor::NextUnmatched() -> bool
+{
+  for (; unmatched_part_ < parts_->size(); unmatched_part_++, unmatched_idx_ = 0) {
+    const auto &part = (*parts_)[unmatched_part_];
+    for (; unmatched_idx_ < part.matched_.size(); ++unmatched_idx_) {
+      if (!part.matched_[unmatched_idx_]) {
+        out_probe_ = nullptr;
+        out_build_ = GetBuildRow(part, unmatched_idx_++);
+        has_build_ = true;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto HashJoinExecutor::NextPass() -> bool
+{
+  // a shared table has no spilled partitions, and is still probed by the other pipelines
+  if (shared_table_ != nullptr) {
+    return false;
+  }
+  // unmatched build rows of outer join are only found by probing, otherwise partitions without probe rows are done
+  auto keep_empty = join_type_ == OUTER_JOIN && build_left_;
+  for (auto &part : *parts_) {
+    if (part.build_file_ != nullptr && (keep_empty || part.probe_file_->GetRowNum() > 0)) {
+      tasks_.push_back({level_ + 1, std::move(part.build_file_), std::move(part.probe_file_)});
+    }
+  }
+  parts_->clear();
+  if (tasks_.empty()) {
+    return false;
+  }
+  auto task = std::move(tasks_.back());
+  tasks_.pop_back();
+  level_      = task.level_;
+  build_file_ = std::move(task.build_file_);
+  probe_file_ = std::move(task.probe_file_);
+  Build();
+  probe_file_->Rewind();
+  probe_batch_->Reset();
+  probe_pos_      = 0;
+  unmatched_part_ = 0;
+  unmatched_idx_  = 0;
+  return true;
+}
+
+auto HashJoinExecutor::FindNext() -> bool
+{
+  while (true) {
+    switch (phase_) {
+      case Phase::PROBE:
+        if (Probe()) {
+          return true;
+        }
+        phase_ = join_type_ == OUTER_JOIN && build_left_ ? Phase::UNMATCHED : Phase::NEXT_PASS;
+        break;
+      case Phase::UNMATCHED:
+        if (NextUnmatched()) {
+          return true;
+        }
+        phase_ = Phase::NEXT_PASS;
+        break;
+      case Phase::NEXT_PASS: phase_ = NextPass() ? Phase::PROBE : Phase::DONE; break;
+      case Phase::DONE: return false;
+    }
+  }
+}
+
+void HashJoinExecutor::WriteRow(char *slot) const
+{
+  // the left fields always come first, the unmatched rows of an outer join only come from the left side
+  if (build_left_) {
+    ConcatRow(out_build_, out_probe_, slot);
+  } else {
+    ConcatRow(*out_probe_, has_build_ ? &out_build_ : nullptr, slot);
+  }
+}
+
+auto HashJoinExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  // the row found by Init or Next has not been consumed yet
+  if (!is_end_) {
+    WriteRow(batch.AppendSlot(INVALID_RID));
+    is_end_ = true;
+  }
+  while (!batch.IsFull() && FindNext()) {
+    WriteRow(batch.AppendSlot(INVALID_RID));
+  }
+  return batch.GetSelSize() > 0;
+}
+
+/// inner join
+void HashJoinExecutor::InitInnerJoin()
+{
+  tasks_.clear();
+  level_ = 0;
+  build_file_.reset();
+  probe_file_.reset();
+  if (shared_table_ == nullptr) {
+    Build();
+  } else {
+    std::lock_guard<std::mutex> lock(shared_table_->mutex_);
+    if (!shared_table_->is_built_) {
+      Build();
+      shared_table_->is_built_ = true;
+    }
+  }
+  probe_->Init();
+  probe_batch_    = std::make_unique<RecordBatch>(probe_->GetOutSchema());
+  probe_pos_      = 0;
+  probe_rec_      = nullptr;
+  chain_          = 0;
+  unmatched_part_ = 0;
+  unmatched_idx_  = 0;
+  phase_          = Phase::PROBE;
+  NextInnerJoin();
+}
+
+void HashJoinExecutor::NextInnerJoin()
+{
+  is_end_ = !FindNext();
+  if (!is_end_) {
+    WriteRow(join_buf_.get());
+  }
+}
+
+auto HashJoinExecutor::IsEndInnerJoin() const -> bool { return is_end_; }
+
+/// outer join, only differs from inner join in the unmatched rows FindNext produces
+void HashJoinExecutor::InitOuterJoin() { InitInnerJoin(); }
+
+void HashJoinExecutor::NextOuterJoin() { NextInnerJoin(); }
+
+auto HashJoinExecutor::IsEndOuterJoin() const -> bool { return is_end_; }
+
+}  // namespace wsdb
@@ -0,0 +1,209 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/26.
+//
+
+/**
+ * @brief Join two tables on equal keys by hash join: the rows of the build side are kept in open addressing tables
+ * keyed on their join keys, then the probe side is streamed through them. For outer join, the left table is the outer
+ * table and may be either side.
+ * Both sides are split into partitions by the hash of their keys. When the build side exceeds the memory budget, the
+ * largest partitions are spilled to temp files until the rest fits (hybrid hash join), probe rows of the spilled
+ * partitions are spilled as well, and every pair of spilled partitions is joined by another pass afterwards, which
+ * partitions them again if they still do not fit.
+ * The pipelines of an exchange probe in parallel by sharing one table: the first of them to be initialized builds it
+ * from its build child, the others wait for it and never read their own. A shared table is only read after it is
+ * built and is never spilled, so it should be expected to fit in the budget.
+ */
+
+#ifndef WSDB_EXECUTOR_JOIN_HASH_H
+#define WSDB_EXECUTOR_JOIN_HASH_H
+
+#include <mutex>
+#include "common/config.h"
+#include "executor_join.h"
+#include "spill_file.h"
+#include "system/handle/record_comparator.h"
+
+namespace wsdb {
+
+class HashJoinExecutor : public JoinExecutor
+{
+public:
+  /// table shared by the joins in the pipelines of an exchange
+  struct SharedTable;
+
+  static auto MakeSharedTable() -> std::shared_ptr<SharedTable>;
+
+  /**
+   * @param left_key_schema key fields of the left child, paired by position with right_key_schema, the paired fields
+   * should have the same type
+   * @param build_left build the table on the left child and probe it with the right one, otherwise the other way round
+   * @param mem_budget bytes of build rows and their hash tables kept in memory
+   * @param shared_table probe this table instead of one of its own, not for outer join that builds on the left
+   */
+  HashJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+      RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema, bool build_left,
+      size_t mem_budget = HASH_JOIN_BUFFER_SIZE, std::shared_ptr<SharedTable> shared_table = nullptr);
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  /// joins batches of the probe side, the joined rows are written into the batch
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return left_->IsVectorized() && right_->IsVectorized(); }
+
+private:
+  void InitInnerJoin() override;
+
+  void NextInnerJoin() override;
+
+  [[nodiscard]] auto IsEndInnerJoin() const -> bool override;
+
+  void InitOuterJoin() override;
+
+  void NextOuterJoin() override;
+
+  [[nodiscard]] auto IsEndOuterJoin() const -> bool override;
+
+  // one slot per distinct key of the build side
+  struct Bucket
+  {
+    size_t hash_;
+    // index + 1 of the first build row of the key, 0 for an empty slot
+    size_t head_;
+  };
+
+  struct Partition
+  {
+    // build rows kept in memory, laid out as in Record
+    std::vector<char> rows_;
+    size_t            row_num_{0};
+    // open addressing with linear probing, the size is a power of 2
+    std::vector<Bucket> buckets_;
+    // index + 1 of the next build row of the same key, build rows of a key are chained in the order they are read
+    std::vector<size_t> next_;
+    // marks the build rows that found a match, only used for outer join that builds on the left
+    std::vector<bool> matched_;
+    // set when the partition is spilled, rows of both sides go to the files from then on
+    SpillFileUptr build_file_;
+    SpillFileUptr probe_file_;
+  };
+
+  // a pair of spilled partitions to join by a later pass
+  struct Task
+  {
+    size_t        level_;
+    SpillFileUptr build_file_;
+    SpillFileUptr probe_file_;
+  };
+
+  enum class Phase
+  {
+    PROBE,
+    // for outer join that builds on the left, emit the build rows that never matched
+    UNMATCHED,
+    // start the pass of the next spilled partitions
+    NEXT_PASS,
+    DONE
+  };
+
+  /// read the build input of the pass into partitions, spilling the largest ones while the budget is exceeded
+  void Build();
+
+  /// write the rows of part to its build file and free them, returns the bytes freed
+  auto Spill(Partition &part) -> size_t;
+
+  void BuildTable(Partition &part);
+
+  [[nodiscard]] auto PartitionOf(size_t hash) const -> size_t;
+
+  [[nodiscard]] auto GetBuildRow(const Partition &part, size_t idx) const -> RecordView
+  {
+    auto slot = part.rows_.data() + idx * build_slot_size_;
+    return {build_->GetOutSchema(), slot, slot + BITMAP_SIZE(build_->GetOutSchema()->GetFieldCount()), INVALID_RID};
+  }
+
+  /// the chain of build rows of part whose keys equal the keys of rec of the probe side, 0 if there is none
+  [[nodiscard]] auto Lookup(const Partition &part, const RecordView &rec, size_t hash) const -> size_t;
+
+  /// find the next joined row from the probe input of the pass, returns false when the probe input is exhausted
+  auto Probe() -> bool;
+
+  /// find the next build row of the pass that never matched
+  auto NextUnmatched() -> bool;
+
+  /// queue the spilled partitions of the pass and start the pass of the next queued ones, false if there is none
+  auto NextPass() -> bool;
+
+  /// advance to the next joined row, returns false when all rows are produced
+  auto FindNext() -> bool;
+
+  /// write the joined row found by FindNext into slot
+  void WriteRow(char *slot) const;
+
+private:
+  RecordSchemaUptr  left_key_schema_;
+  RecordSchemaUptr  right_key_schema_;
+  bool              build_left_;
+  size_t            mem_budget_;
+  AbstractExecutor *build_;
+  AbstractExecutor *probe_;
+  size_t            build_slot_size_;
+  // memory a build row takes in the hash table, on top of the rows of its partition
+  size_t table_row_cost_;
+
+  RecordHasher build_hasher_;
+  RecordHasher probe_hasher_;
+  // compares build rows with each other and probe rows with build rows on their keys
+  RecordComparator build_cmp_;
+  RecordComparator probe_cmp_;
+
+  // the current pass reads the children at level 0 and spilled partitions of the previous levels afterwards
+  size_t                       level_{0};
+  SpillFileUptr                build_file_;
+  SpillFileUptr                probe_file_;
+  std::shared_ptr<SharedTable> shared_table_;
+  // partitions of the pass, own_parts_ or the ones of shared_table_
+  std::vector<Partition>  own_parts_;
+  std::vector<Partition> *parts_;
+  std::vector<Task>       tasks_;
+
+  Phase           phase_{Phase::DONE};
+  RecordBatchUptr probe_batch_;
+  size_t          probe_pos_{0};
+  // the current probe row, its partition and the remaining chain of build rows it matches
+  const RecordView *probe_rec_{nullptr};
+  Partition        *probe_part_{nullptr};
+  size_t            chain_{0};
+  bool              probe_matched_{false};
+  // the joined row found by FindNext, either side is null for the unmatched rows of an outer join
+  const RecordView *out_probe_{nullptr};
+  RecordView        out_build_;
+  bool              has_build_{false};
+  size_t            unmatched_part_{0};
+  size_t            unmatched_idx_{0};
+  bool              is_end_{true};
+  // the current joined row in row mode
+  std::unique_ptr<char[]> join_buf_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_JOIN_HASH_H
@@ -25,27 +25,100 @@
 namespace wsdb {
 NestedLoopJoinExecutor::NestedLoopJoinExecutor(
     JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right, ConditionVec conditions)
-    : JoinExecutor(join_type, std::move(left), std::move(right), std::move(conditions))
+    : JoinExecutor(join_type, std::move(left), std::move(right), std::move(conditions)),
+      join_buf_(std::make_unique<char[]>(
+          BITMAP_SIZE(out_schema_->GetFieldCount()) + out_schema_->GetRecordLength()))
 {}
 
+auto NestedLoopJoinExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  return GetRowView(join_buf_.get());
+}
+
+void NestedLoopJoinExecutor::BufferRight()
+{
+  right_buf_.clear();
+  auto batch = RecordBatch(right_->GetOutSchema());
+  for (right_->Init(); right_->NextBatch(batch);) {
+    for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+      right_buf_.push_back(std::make_unique<Record>(batch.GetRow(i)));
+    }
+  }
+}
+
+void NestedLoopJoinExecutor::FindMatch()
+{
+  for (; !left_->IsEnd(); left_->Next(), right_idx_ = 0) {
+    auto left = left_->GetRecordView();
+    for (; right_idx_ < right_buf_.size(); ++right_idx_) {
+      RecordView right = *right_buf_[right_idx_];
+      ConcatRow(left, &right, join_buf_.get());
+      if (predicate_.Eval(GetRowView(join_buf_.get()))) {
+        return;
+      }
+    }
+  }
+}
+
+auto NestedLoopJoinExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  if (join_type_ != INNER_JOIN) {
+    return AbstractExecutor::NextBatch(batch);
+  }
+  if (left_batch_ == nullptr) {
+    left_batch_ = std::make_unique<RecordBatch>(left_->GetOutSchema(), batch.GetCapacity());
+    left_pos_   = 0;
+  }
+  // the row interface may have stopped in the middle of a left row, continue from it
+  while (true) {
+    batch.Reset();
+    while (!batch.IsFull()) {
+      if (left_pos_ == left_batch_->GetSelSize()) {
+        left_pos_ = 0;
+        if (!left_->NextBatch(*left_batch_)) {
+          break;
+        }
+      }
+      const auto &left = left_batch_->GetRow(left_pos_);
+      for (; right_idx_ < right_buf_.size() && !batch.IsFull(); ++right_idx_) {
+        RecordView right = *right_buf_[right_idx_];
+        ConcatRow(left, &right, batch.AppendSlot(INVALID_RID));
+      }
+      if (right_idx_ == right_buf_.size()) {
+        left_pos_++;
+        right_idx_ = 0;
+      }
+    }
+    if (batch.GetRowNum() == 0) {
+      return false;
+    }
+    batch.SetSelSize(predicate_.Filter(batch.GetRows(), batch.GetSel(), batch.GetSelSize()));
+    if (batch.GetSelSize() > 0) {
+      return true;
+    }
+  }
+}
+
 /// inner join
 void NestedLoopJoinExecutor::InitInnerJoin()
 {
-  WSDB_STUDENT_TODO(l2, f1);
-  WSDB_STUDENT_TODO(l3, t1);
+  BufferRight();
+  left_->Init();
+  right_idx_ = 0;
+  left_batch_.reset();
+  FindMatch();
 }
 
 void NestedLoopJoinExecutor::NextInnerJoin()
 {
-  WSDB_STUDENT_TODO(l2, f1);
-  WSDB_STUDENT_TODO(l3, t1);
+  right_idx_++;
+  FindMatch();
 }
 
-auto NestedLoopJoinExecutor::IsEndInnerJoin() const -> bool
-{
-  WSDB_STUDENT_TODO(l2, f1);
-  WSDB_STUDENT_TODO(l3, t1);
-}
+auto NestedLoopJoinExecutor::IsEndInnerJoin() const -> bool { return left_->IsEnd(); }
 
 /// outer join
 void NestedLoopJoinExecutor::InitOuterJoin() { WSDB_STUDENT_TODO(l3, t2); }
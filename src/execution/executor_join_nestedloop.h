@@ -37,6 +37,16 @@ public:
   NestedLoopJoinExecutor(
       JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right, ConditionVec conditions);
 
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  /// inner join only, joins batches of the left child with the buffered right rows and filters the joined batch
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override
+  {
+    return join_type_ == INNER_JOIN && left_->IsVectorized() && right_->IsVectorized();
+  }
+
 private:
   void InitInnerJoin() override;
 
@@ -50,11 +60,25 @@ private:
 
   [[nodiscard]] auto IsEndOuterJoin() const -> bool override;
 
+  /// read all rows of the right child into right_buf_
+  void BufferRight();
+
+  /// starting from left_'s current row and right_idx_, find the next pair that satisfies the conditions
+  void FindMatch();
+
 private:
   // temporarily store record from the left executor
   RecordUptr left_rec_ = nullptr;
   // for outer join, indicates whether a valid right value is found
   bool need_gen_null_{false};
+  // the right child is scanned once and kept in memory
+  std::vector<RecordUptr> right_buf_;
+  size_t                  right_idx_{0};
+  // the current joined row in row mode
+  std::unique_ptr<char[]> join_buf_;
+  // the current batch of the left child and the position of the next left row in it, used in batch mode
+  RecordBatchUptr left_batch_;
+  size_t          left_pos_{0};
 };
 
 }  // namespace wsdb
@@ -28,6 +28,7 @@
 #define WSDB_EXECUTOR_JOIN_SORTMERGE_H
 
 #include "executor_join.h"
+#include "system/handle/record_comparator.h"
 
 namespace wsdb {
 class SortMergeJoinExecutor : public JoinExecutor
@@ -54,6 +55,8 @@ private:
 private:
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  // compares left records with right records on their key fields
+  RecordComparator key_cmp_;
 
   // temporarily store record from the left executor
   RecordUptr left_rec_;
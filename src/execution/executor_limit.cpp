@@ -20,17 +20,50 @@
 //
 
 #include "executor_limit.h"
+#include <algorithm>
 
 namespace wsdb {
 LimitExecutor::LimitExecutor(AbstractExecutorUptr child, int limit)
     : AbstractExecutor(Basic), child_(std::move(child)), limit_(limit), count_(0)
 {}
 
-void LimitExecutor::Init() { WSDB_STUDENT_TODO(l2, t1); }
+void LimitExecutor::Init()
+{
+  count_ = 0;
+  child_->Init();
+}
 
-void LimitExecutor::Next() { WSDB_STUDENT_TODO(l2, t1); }
+void LimitExecutor::Next()
+{
+  // do not pull the child any further once the limit is reached
+  if (++count_ < limit_) {
+    child_->Next();
+  }
+}
 
-[[nodiscard]] auto LimitExecutor::IsEnd() const -> bool { WSDB_STUDENT_TODO(l2, t1); }
+[[nodiscard]] auto LimitExecutor::IsEnd() const -> bool { return count_ >= limit_ || child_->IsEnd(); }
+
+auto LimitExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  return child_->GetRecordView();
+}
+
+auto LimitExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  if (count_ >= limit_) {
+    batch.Reset();
+    return false;
+  }
+  if (!child_->NextBatch(batch)) {
+    return false;
+  }
+  batch.SetSelSize(std::min(batch.GetSelSize(), static_cast<size_t>(limit_ - count_)));
+  count_ += static_cast<int>(batch.GetSelSize());
+  return true;
+}
 
 [[nodiscard]] auto LimitExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
 }  // namespace wsdb
@@ -43,6 +43,12 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
+
 private:
   AbstractExecutorUptr child_;
   // max number of records to return
@@ -0,0 +1,130 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/27.
+//
+
+#include "executor_materialize.h"
+#include <algorithm>
+#include <numeric>
+
+namespace wsdb {
+
+MaterializeExecutor::MaterializeExecutor(AbstractExecutorUptr child, TableHandle *tab, RecordSchemaUptr out_schema)
+    : AbstractExecutor(Basic), child_(std::move(child)), tab_(tab), out_schema_(std::move(out_schema))
+{
+  const auto *child_schema = child_->GetOutSchema();
+  const auto &tab_schema   = tab_->GetSchema();
+  for (size_t i = 0; i < out_schema_->GetFieldCount(); ++i) {
+    const auto &field = out_schema_->GetFieldAt(i);
+    auto        idx   = child_schema->GetRTFieldIndex(field);
+    if (idx != child_schema->GetFieldCount()) {
+      child_fields_.emplace_back(idx, i);
+      continue;
+    }
+    idx = tab_schema.GetRTFieldIndex(field);
+    if (idx == tab_schema.GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    tab_fields_.emplace_back(idx, i);
+  }
+  out_buf_ = std::make_unique<char[]>(BITMAP_SIZE(out_schema_->GetFieldCount()) + out_schema_->GetRecordLength());
+}
+
+void MaterializeExecutor::Init()
+{
+  child_->Init();
+  Materialize();
+}
+
+void MaterializeExecutor::Next()
+{
+  child_->Next();
+  Materialize();
+}
+
+auto MaterializeExecutor::IsEnd() const -> bool { return child_->IsEnd(); }
+
+auto MaterializeExecutor::GetOutSchema() const -> const RecordSchema * { return out_schema_.get(); }
+
+auto MaterializeExecutor::GetRecordView() const -> RecordView { return view_; }
+
+auto MaterializeExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  if (child_batch_ == nullptr) {
+    child_batch_ = std::make_unique<RecordBatch>(child_->GetOutSchema(), batch.GetCapacity());
+  }
+  batch.Reset();
+  view_ = {};
+  if (!child_->NextBatch(*child_batch_)) {
+    guard_.Release();
+    return false;
+  }
+  // 1. lay out the output rows in the order of the child and copy what the child has
+  auto n = child_batch_->GetSelSize();
+  slots_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    const auto &row = child_batch_->GetRow(i);
+    slots_[i]       = batch.AppendSlot(row.GetRID());
+    CopyChildFields(row, slots_[i]);
+  }
+  if (tab_fields_.empty()) {
+    return true;
+  }
+  // 2. read the other fields from the table in page order
+  order_.resize(n);
+  std::iota(order_.begin(), order_.end(), 0);
+  std::sort(order_.begin(), order_.end(), [this](size_t l, size_t r) {
+    auto lrid = child_batch_->GetRow(l).GetRID();
+    auto rrid = child_batch_->GetRow(r).GetRID();
+    return lrid.PageID() != rrid.PageID() ? lrid.PageID() < rrid.PageID() : lrid.SlotID() < rrid.SlotID();
+  });
+  for (auto i : order_) {
+    tab_->ReadFields(child_batch_->GetRow(i).GetRID(), guard_, tab_fields_, out_schema_.get(), slots_[i]);
+  }
+  return true;
+}
+
+void MaterializeExecutor::CopyChildFields(const RecordView &row, char *slot) const
+{
+  auto data = slot + BITMAP_SIZE(out_schema_->GetFieldCount());
+  for (const auto &[src, dst] : child_fields_) {
+    BitMap::SetBit(slot, dst, row.IsNull(src));
+    memcpy(data + out_schema_->GetFieldOffset(dst),
+        row.GetFieldData(src),
+        out_schema_->GetFieldAt(dst).field_.field_size_);
+  }
+}
+
+void MaterializeExecutor::Materialize()
+{
+  if (child_->IsEnd()) {
+    guard_.Release();
+    view_ = {};
+    return;
+  }
+  auto row = child_->GetRecordView();
+  CopyChildFields(row, out_buf_.get());
+  if (!tab_fields_.empty()) {
+    tab_->ReadFields(row.GetRID(), guard_, tab_fields_, out_schema_.get(), out_buf_.get());
+  }
+  view_ = {out_schema_.get(), out_buf_.get(), out_buf_.get() + BITMAP_SIZE(out_schema_->GetFieldCount()), row.GetRID()};
+}
+
+}  // namespace wsdb
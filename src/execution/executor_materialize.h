@@ -0,0 +1,91 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/27.
+//
+
+/**
+ * @brief Late materialization: fill in the fields a narrow child does not carry from the table by the RIDs of its rows
+ * the child is typically a scan that only outputs the columns of its conditions, with filters above it. Fields of the
+ * output that the child has are copied from its rows, the others are read from the pages of the table, so they are
+ * only fetched for the rows that survive the child. Rows of a batch are fetched in page order, every page is pinned
+ * once per batch, while the output keeps the order of the child
+ */
+
+#ifndef WSDB_EXECUTOR_MATERIALIZE_H
+#define WSDB_EXECUTOR_MATERIALIZE_H
+
+#include "executor_abstract.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+class MaterializeExecutor : public AbstractExecutor
+{
+public:
+  /**
+   * @param child rows should carry the RIDs of records in tab, so only scans and filters can be below
+   * @param tab
+   * @param out_schema fields of tab to output
+   */
+  MaterializeExecutor(AbstractExecutorUptr child, TableHandle *tab, RecordSchemaUptr out_schema);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
+
+private:
+  /// copy the fields the child has from row to slot
+  void CopyChildFields(const RecordView &row, char *slot) const;
+
+  /// materialize the current row of the child into out_buf_
+  void Materialize();
+
+private:
+  AbstractExecutorUptr child_;
+  TableHandle         *tab_;
+  RecordSchemaUptr     out_schema_;
+  // pairs of (index in the child schema, index in out_schema_)
+  std::vector<std::pair<size_t, size_t>> child_fields_;
+  // pairs of (index in the table schema, index in out_schema_)
+  std::vector<std::pair<size_t, size_t>> tab_fields_;
+  // keeps the last page the fields are read from pinned
+  PageGuard guard_;
+
+  std::unique_ptr<char[]> out_buf_;
+  RecordView              view_;
+
+  RecordBatchUptr     child_batch_;
+  std::vector<char *> slots_;
+  std::vector<size_t> order_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_MATERIALIZE_H
@@ -27,14 +27,75 @@ ProjectionExecutor::ProjectionExecutor(AbstractExecutorUptr child, RecordSchemaU
     : AbstractExecutor(Basic), child_(std::move(child))
 {
   out_schema_ = std::move(proj_schema);
+  auto child_schema = child_->GetOutSchema();
+  for (const auto &field : out_schema_->GetFields()) {
+    auto idx = child_schema->GetRTFieldIndex(field);
+    WSDB_ASSERT(idx < child_schema->GetFieldCount(), fmt::format("field {} not found in child", field.field_.field_name_));
+    src_idx_.push_back(idx);
+  }
+  out_buf_ = std::make_unique<char[]>(BITMAP_SIZE(out_schema_->GetFieldCount()) + out_schema_->GetRecordLength());
 }
 
-// hint: record_ = std::make_unique<Record>(out_schema_.get(), *child_record);
+void ProjectionExecutor::Init()
+{
+  child_->Init();
+  Project();
+}
+
+void ProjectionExecutor::Next()
+{
+  child_->Next();
+  Project();
+}
 
-void ProjectionExecutor::Init() { WSDB_STUDENT_TODO(l2, t1); }
+auto ProjectionExecutor::IsEnd() const -> bool { return child_->IsEnd(); }
 
-void ProjectionExecutor::Next() { WSDB_STUDENT_TODO(l2, t1); }
+auto ProjectionExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  auto nullmap_size = BITMAP_SIZE(out_schema_->GetFieldCount());
+  return {out_schema_.get(), out_buf_.get(), out_buf_.get() + nullmap_size, INVALID_RID};
+}
 
-auto ProjectionExecutor::IsEnd() const -> bool { WSDB_STUDENT_TODO(l2, t1); }
+auto ProjectionExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  if (child_batch_ == nullptr) {
+    child_batch_ = std::make_unique<RecordBatch>(child_->GetOutSchema(), batch.GetCapacity());
+  }
+  batch.Reset();
+  if (!child_->NextBatch(*child_batch_)) {
+    return false;
+  }
+  // only the selected rows of the child are copied, the output batch is dense
+  for (size_t i = 0; i < child_batch_->GetSelSize(); ++i) {
+    ProjectRow(child_batch_->GetRow(i), batch.AppendSlot(INVALID_RID));
+  }
+  return true;
+}
+
+void ProjectionExecutor::Project()
+{
+  if (child_->IsEnd()) {
+    return;
+  }
+  // the only copy on the way up: the projected layout differs from the child's, fields are read from the child's view
+  ProjectRow(child_->GetRecordView(), out_buf_.get());
+}
+
+void ProjectionExecutor::ProjectRow(const RecordView &row, char *slot) const
+{
+  auto nullmap_size = BITMAP_SIZE(out_schema_->GetFieldCount());
+  memset(slot, 0, nullmap_size);
+  for (size_t j = 0; j < src_idx_.size(); ++j) {
+    memcpy(slot + nullmap_size + out_schema_->GetFieldOffset(j),
+        row.GetFieldData(src_idx_[j]),
+        out_schema_->GetFieldAt(j).field_.field_size_);
+    if (row.IsNull(src_idx_[j])) {
+      BitMap::SetBit(slot, j, true);
+    }
+  }
+}
 
 }  // namespace wsdb
\ No newline at end of file
@@ -21,7 +21,8 @@
 
 /**
  * @brief Project the records returned by the child executor, keep the columns and their relative orders in the projection schema
- * Hint: use Record(proj_schema, child_rec) to do the projection
+ * the projected record is built directly from the child's record view into a buffer reused for every row, so rows
+ * streamed through the projection do not grow the statement arena
  */
 
 #ifndef WSDB_EXECUTOR_PROJECTION_H
@@ -41,8 +42,27 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+private:
+  /// build the output row from the current record of the child
+  void Project();
+
+  /// copy the projected fields of row into slot, which holds a null map followed by the data of the out schema
+  void ProjectRow(const RecordView &row, char *slot) const;
+
 private:
   AbstractExecutorUptr child_;
+  // index in the child's out schema of each projected field
+  std::vector<size_t> src_idx_;
+  // rows of the child to project in NextBatch, allocated on first use
+  RecordBatchUptr child_batch_;
+  // the current output row of the row interface
+  std::unique_ptr<char[]> out_buf_;
 };
 }  // namespace wsdb
 
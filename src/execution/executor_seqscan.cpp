@@ -16,25 +16,179 @@
  -----------------------------------------------------------------------------*/
 
 //
-// Created by ziqi on 2024/7/18.
+// Created by ziqi on 2024/8/4.
 //
 
 #include "executor_seqscan.h"
+#include <numeric>
+#include "expr/column_kernel.h"
 
 namespace wsdb {
 
-SeqScanExecutor::SeqScanExecutor(TableHandle *tab) : AbstractExecutor(Basic), tab_(tab) {}
+SeqScanExecutor::SeqScanExecutor(TableHandle *tab) : SeqScanExecutor(tab, {}, {}) {}
+
+SeqScanExecutor::SeqScanExecutor(
+    TableHandle *tab, const ConditionVec &conds, const std::vector<RTField> &fields, const PageRange *range)
+    : AbstractExecutor(Basic),
+      tab_(tab),
+      range_(range),
+      is_pax_(tab->GetStorageModel() == StorageModel::PAX_MODEL),
+      has_conds_(!conds.empty()),
+      sel_(tab->GetTableHeader().rec_per_page_)
+{
+  const auto &tab_schema = tab_->GetSchema();
+  if (!fields.empty()) {
+    out_schema_ = std::make_unique<RecordSchema>(fields);
+  }
+  const auto *out_schema = GetOutSchema();
+  const auto *src_schema = &tab_schema;
+  if (is_pax_) {
+    // only the columns that are output or looked at by the conditions are read from the pages, in table order
+    auto is_cond_field = [&conds, &tab_schema](size_t idx) {
+      return std::any_of(conds.begin(), conds.end(), [&tab_schema, idx](const Condition &cond) {
+        return tab_schema.GetRTFieldIndex(cond.GetLCol()) == idx ||
+               (cond.GetRhsType() == kColumn && tab_schema.GetRTFieldIndex(cond.GetRCol()) == idx);
+      });
+    };
+    std::vector<RTField> chunk_fields;
+    for (size_t i = 0; i < tab_schema.GetFieldCount(); ++i) {
+      const auto &field = tab_schema.GetFieldAt(i);
+      if (out_schema->GetRTFieldIndex(field) != out_schema->GetFieldCount() || is_cond_field(i)) {
+        chunk_fields.push_back(field);
+      }
+    }
+    chunk_schema_ = std::make_unique<RecordSchema>(std::move(chunk_fields));
+    src_schema    = chunk_schema_.get();
+    bitmap_.resize(BITMAP_SIZE(tab_->GetTableHeader().rec_per_page_));
+  }
+  src_idx_.reserve(out_schema->GetFieldCount());
+  for (const auto &field : out_schema->GetFields()) {
+    auto idx = src_schema->GetRTFieldIndex(field);
+    if (idx == src_schema->GetFieldCount()) {
+      WSDB_THROW(WSDB_FIELD_MISS, field.field_.field_name_);
+    }
+    src_idx_.push_back(idx);
+  }
+  predicate_ = Predicate(conds, src_schema);
+  slot_buf_  = std::make_unique<char[]>(BITMAP_SIZE(out_schema->GetFieldCount()) + out_schema->GetRecordLength());
+}
 
 void SeqScanExecutor::Init()
 {
-  rid_ = tab_->GetFirstRID();
-  
-  WSDB_STUDENT_TODO(l2, t1);
+  page_id_ = range_ == nullptr ? FILE_HEADER_PAGE_ID : range_->begin_ - 1;
+  sel_num_ = 0;
+  pos_     = 0;
+  Seek();
+  LoadView();
+}
+
+void SeqScanExecutor::Next()
+{
+  pos_++;
+  Seek();
+  LoadView();
 }
 
-void SeqScanExecutor::Next() { WSDB_STUDENT_TODO(l2, t1); }
+auto SeqScanExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  while (!batch.IsFull() && Seek()) {
+    for (; pos_ < sel_num_ && !batch.IsFull(); ++pos_) {
+      auto row = sel_[pos_];
+      WriteRow(row, batch.AppendSlot(GetRID(row)));
+    }
+  }
+  view_ = {};
+  return batch.GetSelSize() > 0;
+}
 
-auto SeqScanExecutor::IsEnd() const -> bool { WSDB_STUDENT_TODO(l2, t1); }
+auto SeqScanExecutor::Seek() -> bool
+{
+  while (pos_ >= sel_num_) {
+    auto end = range_ == nullptr ? static_cast<page_id_t>(tab_->GetTableHeader().page_num_) : range_->end_;
+    if (page_id_ + 1 >= end) {
+      page_rows_.clear();
+      chunk_.reset();
+      guard_.Release();
+      return false;
+    }
+    LoadPage(++page_id_);
+  }
+  return true;
+}
 
-auto SeqScanExecutor::GetOutSchema() const -> const RecordSchema * { return &tab_->GetSchema(); }
-}  // namespace wsdb
\ No newline at end of file
+void SeqScanExecutor::LoadPage(page_id_t pid)
+{
+  pos_ = 0;
+  if (is_pax_) {
+    chunk_   = tab_->GetChunk(pid, chunk_schema_.get());
+    auto n   = chunk_->GetRowCount();
+    sel_num_ = n;
+    if (has_conds_) {
+      predicate_.Filter(*chunk_, bitmap_.data());
+      sel_num_ = ColumnKernel::ToSelection(bitmap_.data(), n, sel_.data());
+    } else {
+      std::iota(sel_.begin(), sel_.begin() + static_cast<long>(n), 0);
+    }
+    return;
+  }
+  page_rows_.clear();
+  tab_->ViewPage(pid, guard_, page_rows_);
+  std::iota(sel_.begin(), sel_.begin() + static_cast<long>(page_rows_.size()), 0);
+  sel_num_ = page_rows_.size();
+  if (has_conds_) {
+    sel_num_ = predicate_.Filter(page_rows_.data(), sel_.data(), sel_num_);
+  }
+}
+
+void SeqScanExecutor::WriteRow(size_t row, char *slot) const
+{
+  const auto *out_schema   = GetOutSchema();
+  auto        nullmap_size = BITMAP_SIZE(out_schema->GetFieldCount());
+  auto        data         = slot + nullmap_size;
+  if (!is_pax_ && out_schema_ == nullptr) {
+    memcpy(slot, page_rows_[row].GetNullMap(), nullmap_size);
+    memcpy(data, page_rows_[row].GetData(), out_schema->GetRecordLength());
+    return;
+  }
+  for (size_t i = 0; i < src_idx_.size(); ++i) {
+    auto        src_idx = src_idx_[i];
+    const char *src     = nullptr;
+    bool        is_null = false;
+    if (is_pax_) {
+      const auto &col = chunk_->GetColumn(src_idx);
+      src             = col.GetFieldData(row);
+      is_null         = col.IsNull(row);
+    } else {
+      src     = page_rows_[row].GetData() + tab_->GetSchema().GetFieldOffset(src_idx);
+      is_null = page_rows_[row].IsNull(src_idx);
+    }
+    BitMap::SetBit(slot, i, is_null);
+    memcpy(data + out_schema->GetFieldOffset(i), src, out_schema->GetFieldAt(i).field_.field_size_);
+  }
+}
+
+void SeqScanExecutor::LoadView()
+{
+  if (IsEnd()) {
+    view_ = {};
+    return;
+  }
+  auto row = sel_[pos_];
+  if (!is_pax_ && out_schema_ == nullptr) {
+    view_ = page_rows_[row];
+    return;
+  }
+  WriteRow(row, slot_buf_.get());
+  view_ = {GetOutSchema(), slot_buf_.get(), slot_buf_.get() + BITMAP_SIZE(GetOutSchema()->GetFieldCount()), GetRID(row)};
+}
+
+auto SeqScanExecutor::IsEnd() const -> bool { return pos_ >= sel_num_; }
+
+auto SeqScanExecutor::GetRecordView() const -> RecordView { return view_; }
+
+auto SeqScanExecutor::GetOutSchema() const -> const RecordSchema *
+{
+  return out_schema_ == nullptr ? &tab_->GetSchema() : out_schema_.get();
+}
+}  // namespace wsdb
@@ -21,12 +21,17 @@
 
 /**
  * @brief Iterate over all records in the table, check TableHandle for more details
- * 
+ * the table is scanned a page at a time: pushed down conditions are evaluated on the records in the page (in place for
+ * NARY, on the columns of the page with the SIMD kernels for PAX) before anything is copied, and only the rows that
+ * pass are materialized with the projected fields. Without conditions and projection, records of NARY tables are
+ * exposed as views into the current page, which stays pinned until the scan moves to another page
  */
 
 #ifndef WSDB_EXECUTOR_SEQSCAN_H
 #define WSDB_EXECUTOR_SEQSCAN_H
 #include "executor_abstract.h"
+#include "expr/predicate.h"
+#include "morsel.h"
 #include "system/handle/table_handle.h"
 
 namespace wsdb {
@@ -35,6 +40,16 @@ class SeqScanExecutor : public AbstractExecutor
 public:
   explicit SeqScanExecutor(TableHandle *tab);
 
+  /**
+   * @param tab
+   * @param conds conditions pushed down from a filter, on columns of tab only
+   * @param fields fields to output in this order, all fields of tab if empty
+   * @param range only scan these pages, read at every Init so that a worker of a parallel scan can point it to the
+   * next morsel, all pages of tab if nullptr
+   */
+  SeqScanExecutor(TableHandle *tab, const ConditionVec &conds, const std::vector<RTField> &fields,
+      const PageRange *range = nullptr);
+
   void Init() override;
 
   void Next() override;
@@ -43,9 +58,58 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return true; }
+
+private:
+  /// move on to the next page if the rows of the current one are used up, returns false at the end of the table
+  auto Seek() -> bool;
+
+  /// load the rows of page pid that pass the conditions into sel_
+  void LoadPage(page_id_t pid);
+
+  /// write the output fields of the row-th row of the current page to slot, laid out as in Record
+  void WriteRow(size_t row, char *slot) const;
+
+  [[nodiscard]] auto GetRID(size_t row) const -> RID
+  {
+    return chunk_ == nullptr ? page_rows_[row].GetRID() : chunk_->GetRID(row);
+  }
+
+  /// point view_ to the current row
+  void LoadView();
+
 private:
-  TableHandle *tab_;
-  RID          rid_;
+  TableHandle     *tab_;
+  const PageRange *range_;
+  bool             is_pax_;
+  bool             has_conds_;
+  // evaluated on the records of a NARY page or on the chunk of a PAX page
+  Predicate predicate_;
+  // nullptr if all fields of the table are output
+  RecordSchemaUptr out_schema_;
+  // columns read from PAX pages: the output fields and the ones in the conditions
+  RecordSchemaUptr chunk_schema_;
+  // where each output field comes from, indexes into the table schema for NARY, into chunk_schema_ for PAX
+  std::vector<size_t> src_idx_;
+
+  page_id_t page_id_{INVALID_PAGE_ID};
+  // keeps the NARY page of page_rows_ pinned
+  PageGuard               guard_;
+  std::vector<RecordView> page_rows_;
+  ChunkUptr               chunk_;
+  std::vector<char>       bitmap_;
+  // rows of the current page that pass the conditions, pos_ is the current one
+  std::vector<uint32_t> sel_;
+  size_t                sel_num_{0};
+  size_t                pos_{0};
+
+  // the current row of the row interface, materialized in slot_buf_ unless it can be viewed in the page
+  std::unique_ptr<char[]> slot_buf_;
+  RecordView              view_;
 };
 }  // namespace wsdb
 
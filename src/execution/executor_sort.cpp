@@ -15,97 +15,387 @@
  - along with this program.  If not, see <https://www.gnu.org/licenses/>.
  -----------------------------------------------------------------------------*/
 
+
 //
 // Created by ziqi on 2024/8/5.
 //
-#include <unistd.h>
-#include "common/config.h"
+#include <algorithm>
+#include <array>
 #include "executor_sort.h"
-
-static long long sort_result_fresh_id_ = 0;
-#define SORT_FILE_PATH(obj_name) FILE_NAME(TMP_DIR, obj_name, TMP_SUFFIX)
+#include "worker_pool.h"
 
 namespace wsdb {
-SortExecutor::SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc)
-    : AbstractExecutor(Basic),
-      child_(std::move(child)),
-      key_schema_(std::move(key_schema)),
-      buf_idx_(0),
-      is_desc_(is_desc),
-      is_sorted_(false),
-      is_merge_sort_(false),
-      max_rec_num_(SORT_BUFFER_SIZE / child_->GetOutSchema()->GetRecordLength()),
-      tmp_file_num_(0),
-      merge_result_file_(fmt::format("sort_result_{}", sort_result_fresh_id_++))
+
+namespace {
+
+// rows sorted by a thread at least, fewer are not worth handing to a worker
+constexpr size_t MIN_ROWS_PER_THREAD = 16 * 1024;
+// keys of up to two words are radix sorted
+constexpr size_t RADIX_KEY_SIZE = 2 * sizeof(uint64_t);
+// chunks of fewer rows are sorted by comparison, clearing and scanning the counts of a radix sort would cost more
+constexpr size_t MIN_RADIX_ROWS = 1024;
+
+/// the first W words of the normalized key of a row, big-endian so that they compare as integers like the key bytes
+template <size_t W>
+struct SortEntry
+{
+  uint64_t key_[W];
+  size_t   idx_;
+
+  /// byte b of the key, 0 being the most significant
+  [[nodiscard]] auto Digit(size_t b) const -> size_t { return (key_[b / 8] >> (56 - b % 8 * 8)) & 0xFF; }
+};
+
+/// the len bytes at key as the most significant bytes of a word, padded with 0
+auto LoadWord(const char *key, size_t len) -> uint64_t
 {
-  // comment the line below after testing
-  //  max_rec_num_ = 10;
+  uint64_t word = 0;
+  std::memcpy(&word, key, std::min(len, sizeof(word)));
+  if constexpr (std::endian::native == std::endian::little) {
+    word = __builtin_bswap64(word);
+  }
+  return word;
 }
 
-SortExecutor::~SortExecutor()
+/**
+ * LSD radix sort of the entries on the first key_size bytes of their keys, one byte per pass from the least
+ * significant one. The counts of all bytes are taken in a single pass over the entries, and bytes that are the same
+ * in every entry, e.g. the null bytes or the high bytes of small integers, are skipped. Every pass is stable, so
+ * entries with equal keys keep their order.
+ * @param tmp as many entries as entries, the scratch space of the passes
+ */
+template <size_t W>
+void RadixSort(SortEntry<W> *entries, SortEntry<W> *tmp, size_t n, size_t key_size)
 {
-  if (is_merge_sort_) {
-    // TODO: do some clean up, e.g. close the result file
-    WSDB_STUDENT_TODO(l2, f1);
+  std::vector<std::array<size_t, 256>> counts(key_size);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < key_size; ++b) {
+      counts[b][entries[i].Digit(b)]++;
+    }
+  }
+  auto *src = entries;
+  auto *dst = tmp;
+  for (auto b = key_size; b-- > 0;) {
+    auto &count = counts[b];
+    if (count[src[0].Digit(b)] == n) {
+      continue;
+    }
+    // the counts become the positions each digit starts at
+    for (size_t d = 0, pos = 0; d < count.size(); ++d) {
+      pos += std::exchange(count[d], pos);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      dst[count[src[i].Digit(b)]++] = src[i];
+    }
+    std::swap(src, dst);
   }
+  if (src != entries) {
+    std::copy(src, src + n, entries);
+  }
+}
+
+/// a piece of the merge of two sorted ranges of entries, written to the output from out_
+struct MergePiece
+{
+  size_t l_begin_, l_end_;
+  size_t r_begin_, r_end_;
+  size_t out_;
+};
+
+/// merge path: the number of entries taken from l by the first d entries of the merge of l and r, found by a binary
+/// search along the d-th diagonal of the merge matrix
+template <typename Entry, typename Less>
+auto CoRank(const Entry *l, size_t l_len, const Entry *r, size_t r_len, size_t d, const Less &less) -> size_t
+{
+  size_t lo = d > r_len ? d - r_len : 0;
+  size_t hi = std::min(d, l_len);
+  while (lo < hi) {
+    auto i = lo + (hi - lo) / 2;
+    // taking i entries of l is too few if l[i] comes before the last entry taken from r
+    if (less(l[i], r[d - i - 1])) {
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+}  // namespace
+
+SortExecutor::SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc, size_t mem_budget,
+    size_t thread_num)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      key_schema_(std::move(key_schema)),
+      key_norm_(key_schema_.get(), child_->GetOutSchema(), is_desc),
+      slot_size_(BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount()) + child_->GetOutSchema()->GetRecordLength()),
+      thread_num_(thread_num != 0 ? thread_num : WorkerPool::GetMaxWorkers()),
+      is_radix_(key_norm_.GetKeySize() <= RADIX_KEY_SIZE)
+{
+  // a row in memory takes its slot, a sort entry and its copy in a radix pass or a merge of chunks, its place in
+  // order_, and its key unless the entries hold all of it
+  auto key_size   = key_norm_.GetKeySize();
+  auto entry_size = (key_size > sizeof(uint64_t) && is_radix_ ? 3 : 2) * sizeof(size_t);
+  auto row_size   = slot_size_ + 2 * entry_size + sizeof(size_t) + (is_radix_ ? 0 : key_size);
+  max_rec_num_    = std::max(mem_budget / row_size, size_t{1});
+  // every run being merged holds a block of rows, one more block is left for the output of a pass
+  fan_in_ = std::max(mem_budget / SPILL_BLOCK_SIZE, size_t{3}) - 1;
 }
 
 void SortExecutor::Init()
 {
-  // TODO: decide whether to use merge sort according to the cardinality of the child. 
-  // leave is_merge_sort_ as false if you just want to use in-memory sort
-  is_merge_sort_ = false;
+  rows_.clear();
+  // the buffer takes the budgeted rows once, growing it by doubling could take up to twice the budget before a spill,
+  // the pages of the reservation are only touched as rows come in
+  rows_.reserve(max_rec_num_ * slot_size_);
+  row_num_ = 0;
+  runs_.clear();
+  tree_.reset();
+  readers_.clear();
+  merge_runs_.clear();
+  auto batch = RecordBatch(child_->GetOutSchema());
+  for (child_->Init(); child_->NextBatch(batch);) {
+    for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+      if (row_num_ == max_rec_num_) {
+        SortBuffer();
+        SpillRun();
+      }
+      const auto &row          = batch.GetRow(i);
+      auto        nullmap_size = BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount());
+      WSDB_ASSERT(rows_.size() + slot_size_ <= rows_.capacity(), "sort buffer grows beyond its budget");
+      rows_.resize((row_num_ + 1) * slot_size_);
+      auto slot = rows_.data() + row_num_ * slot_size_;
+      memcpy(slot, row.GetNullMap(), nullmap_size);
+      memcpy(slot + nullmap_size, row.GetData(), child_->GetOutSchema()->GetRecordLength());
+      row_num_++;
+    }
+  }
+  SortBuffer();
+  buf_idx_       = 0;
+  is_merge_sort_ = !runs_.empty();
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(l2, f1);
+    if (row_num_ > 0) {
+      SpillRun();
+    }
+    // release the memory of run generation before the merge takes it
+    std::vector<char>().swap(rows_);
+    std::vector<size_t>().swap(order_);
+    MergeRuns();
   }
-  WSDB_STUDENT_TODO(l2, t1);
 }
 
 void SortExecutor::Next()
 {
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
+    NextMergeRow();
+    return;
   }
-  WSDB_STUDENT_TODO(L2, t1);
+  buf_idx_++;
 }
 
 auto SortExecutor::IsEnd() const -> bool
 {
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
+    return readers_[tree_->GetWinner()].is_end_;
   }
-  WSDB_STUDENT_TODO(L2, t1);
+  return buf_idx_ >= row_num_;
 }
 
-auto SortExecutor::Compare(const Record &lhs, const Record &rhs) const -> bool
+auto SortExecutor::GetRecordView() const -> RecordView
 {
-  auto lkey = std::make_unique<Record>(key_schema_.get(), lhs);
-  auto rkey = std::make_unique<Record>(key_schema_.get(), rhs);
-  return is_desc_ ? Record::Compare(*lkey, *rkey) > 0 : lkey->Compare(*lkey, *rkey) < 0;
+  if (IsEnd()) {
+    return {};
+  }
+  return is_merge_sort_ ? GetMergeRow() : GetBufferRow(order_[buf_idx_]);
+}
+
+auto SortExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  if (is_merge_sort_) {
+    // the rows of a run are only valid until its next block is read
+    for (; !IsEnd() && !batch.IsFull(); NextMergeRow()) {
+      batch.AppendCopy(GetMergeRow());
+    }
+  } else {
+    for (; !IsEnd() && !batch.IsFull(); buf_idx_++) {
+      batch.AppendView(GetBufferRow(order_[buf_idx_]));
+    }
+  }
+  return batch.GetSelSize() > 0;
 }
 
 auto SortExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
 
-/// methods below are only used for merge sort
+void SortExecutor::SortBuffer()
+{
+  if (is_radix_ && key_norm_.GetKeySize() > sizeof(uint64_t)) {
+    SortRows<2>();
+  } else {
+    SortRows<1>();
+  }
+}
 
-auto SortExecutor::GetSortFileName(size_t file_group, size_t file_idx) const -> std::string
+template <size_t W>
+void SortExecutor::SortRows()
 {
-  return fmt::format("{}_{}_{}", merge_result_file_, file_group, file_idx);
+  using Entry   = SortEntry<W>;
+  auto key_size = key_norm_.GetKeySize();
+  // the entries hold the whole key on the radix path, otherwise the keys are kept for the bytes after the first word
+  auto rest    = is_radix_ ? 0 : key_size - std::min(key_size, sizeof(uint64_t));
+  auto keys    = std::make_unique<char[]>(rest != 0 ? row_num_ * key_size : 0);
+  auto entries = std::vector<Entry>(row_num_);
+  // ties are broken by the position of the rows so that the order does not depend on how the rows are split among
+  // threads, nor on whether a chunk is radix sorted
+  auto less = [&](const Entry &l, const Entry &r) {
+    for (size_t w = 0; w < W; ++w) {
+      if (l.key_[w] != r.key_[w]) {
+        return l.key_[w] < r.key_[w];
+      }
+    }
+    if (rest != 0) {
+      auto cmp = std::memcmp(keys.get() + l.idx_ * key_size + sizeof(uint64_t),
+          keys.get() + r.idx_ * key_size + sizeof(uint64_t),
+          rest);
+      if (cmp != 0) {
+        return cmp < 0;
+      }
+    }
+    return l.idx_ < r.idx_;
+  };
+  // every thread encodes the keys of a chunk of rows and sorts it, the radix passes and the merges of chunks share
+  // the scratch space
+  auto chunk_num = std::clamp(row_num_ / MIN_ROWS_PER_THREAD, size_t{1}, thread_num_);
+  auto bounds    = std::vector<size_t>(chunk_num + 1);
+  auto merged    = std::vector<Entry>(chunk_num > 1 || is_radix_ ? row_num_ : 0);
+  for (size_t i = 0; i <= chunk_num; ++i) {
+    bounds[i] = row_num_ * i / chunk_num;
+  }
+  WorkerPool::GetInstance().ParallelFor(chunk_num, thread_num_, [&](size_t chunk) {
+    auto buf = std::vector<char>(key_size);
+    for (auto i = bounds[chunk]; i < bounds[chunk + 1]; ++i) {
+      auto key = rest != 0 ? keys.get() + i * key_size : buf.data();
+      key_norm_.Encode(GetBufferRow(i), key);
+      entries[i].idx_ = i;
+      for (size_t w = 0; w < W; ++w) {
+        entries[i].key_[w] = LoadWord(key + w * sizeof(uint64_t), key_size - std::min(key_size, w * sizeof(uint64_t)));
+      }
+    }
+    auto begin = bounds[chunk];
+    auto len   = bounds[chunk + 1] - begin;
+    if (is_radix_ && len >= MIN_RADIX_ROWS) {
+      RadixSort(entries.data() + begin, merged.data() + begin, len, key_size);
+    } else {
+      std::sort(entries.begin() + begin, entries.begin() + begin + len, less);
+    }
+  });
+  // merge pairs of chunks until one is left, each merge is cut into pieces of about row_num_ / thread_num_ entries so
+  // that the threads share the work even when only two chunks are left
+  auto piece_size = std::max(row_num_ / thread_num_ + 1, MIN_ROWS_PER_THREAD);
+  while (bounds.size() > 2) {
+    std::vector<MergePiece> pieces;
+    std::vector<size_t>     next_bounds;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+      auto begin = bounds[i];
+      auto mid   = bounds[i + 1];
+      // the last chunk of an odd number is merged with nothing
+      auto end = i + 2 < bounds.size() ? bounds[i + 2] : mid;
+      next_bounds.push_back(begin);
+      for (auto d = size_t{0}; d < end - begin; d += piece_size) {
+        auto d_end = std::min(d + piece_size, end - begin);
+        auto l     = CoRank(entries.data() + begin, mid - begin, entries.data() + mid, end - mid, d, less);
+        auto l_end = CoRank(entries.data() + begin, mid - begin, entries.data() + mid, end - mid, d_end, less);
+        pieces.push_back({begin + l, begin + l_end, mid + d - l, mid + d_end - l_end, begin + d});
+      }
+    }
+    next_bounds.push_back(row_num_);
+    WorkerPool::GetInstance().ParallelFor(pieces.size(), thread_num_, [&](size_t i) {
+      const auto &piece = pieces[i];
+      std::merge(entries.begin() + piece.l_begin_,
+          entries.begin() + piece.l_end_,
+          entries.begin() + piece.r_begin_,
+          entries.begin() + piece.r_end_,
+          merged.begin() + piece.out_,
+          less);
+    });
+    entries.swap(merged);
+    bounds.swap(next_bounds);
+  }
+  order_.resize(row_num_);
+  for (size_t i = 0; i < row_num_; ++i) {
+    order_[i] = entries[i].idx_;
+  }
 }
 
-void SortExecutor::SortBuffer() { WSDB_STUDENT_TODO(L2, t1); }
+void SortExecutor::SpillRun()
+{
+  auto run = std::make_unique<SpillFile>(child_->GetOutSchema());
+  for (auto idx : order_) {
+    run->Append(GetBufferRow(idx));
+  }
+  run->Rewind();
+  runs_.push_back(std::move(run));
+  rows_.clear();
+  row_num_ = 0;
+}
 
-void SortExecutor::DumpBufferToFile(size_t file_idx) { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::AdvanceReader(RunReader &reader)
+{
+  if (++reader.pos_ >= reader.batch_->GetSelSize()) {
+    reader.pos_ = 0;
+    if (!reader.run_->Read(*reader.batch_)) {
+      reader.is_end_ = true;
+      return;
+    }
+  }
+  key_norm_.Encode(reader.batch_->GetRow(reader.pos_), reader.key_.data());
+}
 
-void SortExecutor::LoadMergeResult() { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::OpenMerge(std::vector<SpillFileUptr> runs)
+{
+  merge_runs_ = std::move(runs);
+  readers_.clear();
+  readers_.resize(merge_runs_.size());
+  auto block_rows = std::max(SPILL_BLOCK_SIZE / slot_size_, size_t{1});
+  for (size_t i = 0; i < merge_runs_.size(); ++i) {
+    auto &reader  = readers_[i];
+    reader.run_   = merge_runs_[i].get();
+    reader.batch_ = std::make_unique<RecordBatch>(child_->GetOutSchema(), block_rows);
+    reader.key_.resize(key_norm_.GetKeySize());
+    // an empty batch makes the first advance read the first block
+    reader.pos_ = 0;
+    AdvanceReader(reader);
+  }
+  tree_ = std::make_unique<LoserTree<RunLess>>(readers_.size(), RunLess{&readers_, key_norm_.GetKeySize()});
+  tree_->Build();
+}
+
+void SortExecutor::NextMergeRow()
+{
+  AdvanceReader(readers_[tree_->GetWinner()]);
+  tree_->Replay();
+}
 
-void SortExecutor::Merge()
+void SortExecutor::MergeRuns()
 {
-  // 1. create a heap according to is_desc_
-  // 2. read the first tuple from each file
-  // 3. pop the top of the heap and write to file: group 1, file: file_index
-  // run until all runs are exhausted, then read tuples from group 1, file 0, write to group 0, file 0 ...
-  WSDB_STUDENT_TODO(L2, f1);
+  // runs are taken from the front and the merged run goes to the back, so every pass merges runs of similar sizes
+  while (runs_.size() > fan_in_) {
+    std::vector<SpillFileUptr> runs;
+    for (size_t i = 0; i < fan_in_; ++i) {
+      runs.push_back(std::move(runs_.front()));
+      runs_.pop_front();
+    }
+    OpenMerge(std::move(runs));
+    auto merged = std::make_unique<SpillFile>(child_->GetOutSchema());
+    for (; !IsEnd(); NextMergeRow()) {
+      merged->Append(GetMergeRow());
+    }
+    merged->Rewind();
+    runs_.push_back(std::move(merged));
+  }
+  OpenMerge({std::make_move_iterator(runs_.begin()), std::make_move_iterator(runs_.end())});
+  runs_.clear();
 }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
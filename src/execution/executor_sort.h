@@ -15,30 +15,44 @@
  - along with this program.  If not, see <https://www.gnu.org/licenses/>.
  -----------------------------------------------------------------------------*/
 
+
 //
 // Created by ziqi on 2024/8/5.
 //
 
 /**
  * @brief Sort the records returned by the child executor
- *
+ * inputs that fit in the memory budget are sorted in memory, larger ones by external merge sort: runs of the size of
+ * the budget are sorted and spilled to temp files, then merged by a loser tree with a fan-in that also fits in the
+ * budget. Merges of earlier passes write new runs, the last one streams its rows to the parent.
+ * The buffer is sorted by several threads: each sorts a chunk of the rows, then pairs of chunks are merged until one
+ * is left, every merge cut into pieces of equal size by merge path so that all threads share it. Chunks with
+ * normalized keys of up to 16 bytes are radix sorted on their key bytes, longer keys by comparison. Rows with equal
+ * keys keep the order they are read in, so the output of a sort in memory does not depend on the number of threads.
  */
 
 #ifndef WSDB_EXECUTOR_SORT_H
 #define WSDB_EXECUTOR_SORT_H
-#include <functional>
-#include <fstream>
+#include <cstring>
+#include <deque>
 #include <utility>
+#include "common/config.h"
 #include "executor_abstract.h"
+#include "loser_tree.h"
+#include "spill_file.h"
+#include "system/handle/key_normalizer.h"
 
 namespace wsdb {
 
 class SortExecutor : public AbstractExecutor
 {
 public:
-  SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc);
-
-  ~SortExecutor() override;
+  /**
+   * @param mem_budget bytes of rows and their keys sorted in memory at a time, also bounds the blocks read by a merge
+   * @param thread_num workers of the WorkerPool sorting the rows in memory, 0 takes WorkerPool::GetMaxWorkers()
+   */
+  SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc,
+      size_t mem_budget = SORT_BUFFER_SIZE, size_t thread_num = SORT_THREAD_NUM);
 
   void Init() override;
 
@@ -48,101 +62,102 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
-private:
-  /// @brief  Sort heap node for merge sort algorithm, ignore it in l2.t1
-  class SortHeapNode
-  {
-  public:
-    SortHeapNode() = delete;
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
 
-    SortHeapNode(std::shared_ptr<std::ifstream> file_handle, const RecordSchema *schema, size_t rec_idx)
-        : file_handle_(std::move(file_handle)), schema_(schema), rec_idx_(rec_idx), record_(nullptr)
-    {}
+  /// batches reference the rows sorted in memory without copying them, rows of a merge are copied
+  auto NextBatch(RecordBatch &batch) -> bool override;
 
-    SortHeapNode(const SortHeapNode &other)
-    {
-      file_handle_ = other.file_handle_;
-      schema_      = other.schema_;
-      rec_idx_     = other.rec_idx_;
-      record_      = std::make_unique<Record>(*other.record_);
-    }
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
 
-    SortHeapNode(SortHeapNode &&other) noexcept
-    {
-      file_handle_ = std::move(other.file_handle_);
-      schema_      = other.schema_;
-      rec_idx_     = other.rec_idx_;
-      record_      = std::move(other.record_);
-    }
+private:
+  /// reads a run block by block and keeps the normalized key of its current row
+  struct RunReader
+  {
+    SpillFile        *run_;
+    RecordBatchUptr   batch_;
+    size_t            pos_{0};
+    std::vector<char> key_;
+    bool              is_end_{false};
+  };
 
-    auto operator=(const SortHeapNode &other) -> SortHeapNode &
-    {
-      if (this == &other) {
-        return *this;
-      }
-      file_handle_ = other.file_handle_;
-      schema_      = other.schema_;
-      rec_idx_     = other.rec_idx_;
-      record_      = std::make_unique<Record>(*other.record_);
-      return *this;
-    }
+  /// orders readers by their current keys for the loser tree, exhausted readers go last
+  struct RunLess
+  {
+    const std::vector<RunReader> *readers_;
+    size_t                        key_size_;
 
-    /**
-     * Load the next record from the file
-     * @param max_rec_num
-     * @return true if the record is loaded successfully, false if the file is end or idx exceeds the max record number
-     */
-    auto LoadNextRecord(size_t max_rec_num) -> bool
+    auto operator()(size_t a, size_t b) const -> bool
     {
-      WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
-      WSDB_ASSERT(file_handle_->is_open(), "file_handle_ is not open");
-
-      WSDB_STUDENT_TODO(l2, f1);
+      const auto &l = (*readers_)[a];
+      const auto &r = (*readers_)[b];
+      if (l.is_end_ || r.is_end_) {
+        return !l.is_end_ && r.is_end_;
+      }
+      return std::memcmp(l.key_.data(), r.key_.data(), key_size_) < 0;
     }
+  };
 
-    [[nodiscard]] auto GetRecord() const -> const RecordUptr & { return record_; }
+  [[nodiscard]] auto GetBufferRow(size_t idx) const -> RecordView
+  {
+    auto slot = rows_.data() + idx * slot_size_;
+    return {child_->GetOutSchema(), slot, slot + BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount()), INVALID_RID};
+  }
 
-    void CloseFile()
-    {
-      WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
-      file_handle_->close();
-      file_handle_ = nullptr;
-    }
+  /// sort the rows in rows_ by normalized keys into order_ with up to thread_num_ threads
+  void SortBuffer();
 
-  private:
-    std::shared_ptr<std::ifstream> file_handle_;
-    const RecordSchema            *schema_;   // schema of the record
-    size_t                         rec_idx_;  // index of the record in the file
-    RecordUptr                     record_;   // record
-  };
+  /// SortBuffer on entries holding the first W words of the keys: keys that fit in them are radix sorted, longer keys
+  /// are sorted by comparing the first word as an integer before falling back to memcmp
+  template <size_t W>
+  void SortRows();
 
-private:
-  [[nodiscard]] inline auto GetSortFileName(size_t file_group, size_t file_idx) const -> std::string;
+  /// write the rows in rows_ to a new run in sorted order and empty the buffer
+  void SpillRun();
 
-  [[nodiscard]] inline auto Compare(const Record &lhs, const Record &rhs) const -> bool;
+  /// start merging runs, the rows come out through the winner of tree_
+  void OpenMerge(std::vector<SpillFileUptr> runs);
 
-  void SortBuffer();
+  /// move reader to its next row, loading the next block of its run if needed
+  void AdvanceReader(RunReader &reader);
 
-  void DumpBufferToFile(size_t file_idx);
+  /// merge the runs fan_in_ at a time into new runs until one merge is left for the parent
+  void MergeRuns();
 
-  void LoadMergeResult();
+  [[nodiscard]] auto GetMergeRow() const -> const RecordView &
+  {
+    const auto &reader = readers_[tree_->GetWinner()];
+    return reader.batch_->GetRow(reader.pos_);
+  }
 
-  inline void Merge();
+  /// advance the merge past its current row
+  void NextMergeRow();
 
 private:
-  AbstractExecutorUptr    child_;
-  RecordSchemaUptr        key_schema_;
-  std::vector<RecordUptr> sort_buffer_;
-  size_t                  buf_idx_;
-  bool                    is_desc_;
-  bool                    is_sorted_;
-  // use for merge sort, if you want to use merge sort, set it to true if the record number is larger than max_rec_num_
-  bool        is_merge_sort_;
-  size_t      max_rec_num_;
-  size_t      tmp_file_num_;
-  std::string merge_result_file_;
-  // we use file stream instead of disk manager to obtain faster sort speed;
-  std::unique_ptr<std::ifstream> merge_result_file_handle_;
+  AbstractExecutorUptr child_;
+  RecordSchemaUptr     key_schema_;
+  // sorts and merges compare normalized keys instead of records
+  KeyNormalizer key_norm_;
+  size_t        slot_size_;
+  // number of rows sorted in memory at a time and number of runs merged at a time, both bounded by the memory budget
+  size_t max_rec_num_;
+  size_t fan_in_;
+  size_t thread_num_;
+  // short keys, e.g. one or two int columns, are radix sorted instead of compared
+  bool is_radix_;
+
+  // rows read from the child, laid out as in Record, and the order they come out in after SortBuffer
+  std::vector<char>   rows_;
+  size_t              row_num_{0};
+  std::vector<size_t> order_;
+  size_t              buf_idx_{0};
+
+  // set when the input does not fit in memory and the rows come out of a merge of runs
+  bool is_merge_sort_{false};
+  // runs waiting to be merged, in the order they are written so that passes merge runs of similar sizes
+  std::deque<SpillFileUptr>           runs_;
+  std::vector<SpillFileUptr>          merge_runs_;
+  std::vector<RunReader>              readers_;
+  std::unique_ptr<LoserTree<RunLess>> tree_;
 };
 
 }  // namespace wsdb
@@ -0,0 +1,119 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/30.
+//
+
+#include <algorithm>
+#include <cstring>
+#include "executor_topn.h"
+
+namespace wsdb {
+TopNExecutor::TopNExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc, size_t limit)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      key_schema_(std::move(key_schema)),
+      key_norm_(key_schema_.get(), child_->GetOutSchema(), is_desc),
+      slot_size_(BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount()) + child_->GetOutSchema()->GetRecordLength()),
+      limit_(limit),
+      key_buf_(key_norm_.GetKeySize())
+{}
+
+void TopNExecutor::Init()
+{
+  rows_.clear();
+  keys_.clear();
+  seqs_.clear();
+  heap_.clear();
+  seq_     = 0;
+  out_idx_ = 0;
+  if (limit_ == 0) {
+    return;
+  }
+  auto batch = RecordBatch(child_->GetOutSchema());
+  for (child_->Init(); child_->NextBatch(batch);) {
+    for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+      Push(batch.GetRow(i));
+    }
+  }
+  std::sort_heap(heap_.begin(), heap_.end(), [this](size_t l, size_t r) { return HeapLess(l, r); });
+}
+
+void TopNExecutor::Next() { out_idx_++; }
+
+auto TopNExecutor::IsEnd() const -> bool { return out_idx_ >= heap_.size(); }
+
+auto TopNExecutor::GetRecordView() const -> RecordView
+{
+  if (IsEnd()) {
+    return {};
+  }
+  return GetRow(heap_[out_idx_]);
+}
+
+auto TopNExecutor::NextBatch(RecordBatch &batch) -> bool
+{
+  batch.Reset();
+  for (; !IsEnd() && !batch.IsFull(); out_idx_++) {
+    batch.AppendView(GetRow(heap_[out_idx_]));
+  }
+  return batch.GetSelSize() > 0;
+}
+
+auto TopNExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+auto TopNExecutor::HeapLess(size_t l, size_t r) const -> bool
+{
+  auto key_size = key_norm_.GetKeySize();
+  auto cmp      = std::memcmp(keys_.data() + l * key_size, keys_.data() + r * key_size, key_size);
+  return cmp < 0 || (cmp == 0 && seqs_[l] < seqs_[r]);
+}
+
+void TopNExecutor::Push(const RecordView &row)
+{
+  auto less = [this](size_t l, size_t r) { return HeapLess(l, r); };
+  key_norm_.Encode(row, key_buf_.data());
+  if (heap_.size() < limit_) {
+    auto idx = heap_.size();
+    rows_.resize((idx + 1) * slot_size_);
+    keys_.resize((idx + 1) * key_norm_.GetKeySize());
+    seqs_.resize(idx + 1);
+    Store(idx, row);
+    heap_.push_back(idx);
+    std::push_heap(heap_.begin(), heap_.end(), less);
+  } else if (std::memcmp(key_buf_.data(), GetKey(heap_.front()), key_norm_.GetKeySize()) < 0) {
+    // the row replaces the worst one kept, a row with the same key as the worst one was read later and loses to it
+    std::pop_heap(heap_.begin(), heap_.end(), less);
+    Store(heap_.back(), row);
+    std::push_heap(heap_.begin(), heap_.end(), less);
+  }
+  seq_++;
+}
+
+void TopNExecutor::Store(size_t idx, const RecordView &row)
+{
+  auto nullmap_size = BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount());
+  auto slot         = GetSlot(idx);
+  memcpy(slot, row.GetNullMap(), nullmap_size);
+  memcpy(slot + nullmap_size, row.GetData(), child_->GetOutSchema()->GetRecordLength());
+  memcpy(GetKey(idx), key_buf_.data(), key_norm_.GetKeySize());
+  seqs_[idx] = seq_;
+}
+
+}  // namespace wsdb
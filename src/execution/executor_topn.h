@@ -0,0 +1,99 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/30.
+//
+
+/**
+ * @brief Return the first limit records of the child in the order of a sort, the result of a LimitExecutor over a
+ * SortExecutor without sorting the whole input
+ * the best limit rows seen so far are kept in a max-heap on their normalized keys, a row of the child either replaces
+ * the worst of them or is dropped after one key comparison. Memory holds at most limit rows, nothing is spilled.
+ * Rows with equal keys keep the order they are read in, as in SortExecutor.
+ */
+
+#ifndef WSDB_EXECUTOR_TOPN_H
+#define WSDB_EXECUTOR_TOPN_H
+#include <vector>
+#include "executor_abstract.h"
+#include "system/handle/key_normalizer.h"
+
+namespace wsdb {
+
+class TopNExecutor : public AbstractExecutor
+{
+public:
+  TopNExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc, size_t limit);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override;
+
+  /// batches reference the rows kept in the heap without copying them
+  auto NextBatch(RecordBatch &batch) -> bool override;
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return child_->IsVectorized(); }
+
+private:
+  [[nodiscard]] auto GetSlot(size_t idx) -> char * { return rows_.data() + idx * slot_size_; }
+
+  [[nodiscard]] auto GetKey(size_t idx) -> char * { return keys_.data() + idx * key_norm_.GetKeySize(); }
+
+  [[nodiscard]] auto GetRow(size_t idx) const -> RecordView
+  {
+    auto slot = rows_.data() + idx * slot_size_;
+    return {child_->GetOutSchema(), slot, slot + BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount()), INVALID_RID};
+  }
+
+  /// order of the heap: rows by their keys, rows with equal keys by the order they are read in
+  [[nodiscard]] auto HeapLess(size_t l, size_t r) const -> bool;
+
+  /// offer a row of the child to the heap
+  void Push(const RecordView &row);
+
+  /// copy row and the key encoded in key_buf_ into slot idx
+  void Store(size_t idx, const RecordView &row);
+
+private:
+  AbstractExecutorUptr child_;
+  RecordSchemaUptr     key_schema_;
+  KeyNormalizer        key_norm_;
+  size_t               slot_size_;
+  size_t               limit_;
+
+  // rows kept so far laid out as in Record, their keys and the order they are read in, which breaks ties of keys
+  std::vector<char>   rows_;
+  std::vector<char>   keys_;
+  std::vector<size_t> seqs_;
+  size_t              seq_{0};
+  std::vector<char>   key_buf_;
+  // slots of rows_ as a max-heap while reading the child, sorted in ascending order afterwards
+  std::vector<size_t> heap_;
+  size_t              out_idx_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_TOPN_H
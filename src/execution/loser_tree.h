@@ -0,0 +1,97 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/29.
+//
+
+/**
+ * @brief Tournament tree of losers for k-way merges
+ * the sources are the leaves of a complete binary tree laid out as a heap, every inner node keeps the source that lost
+ * the match played there, so after the winner advances only the matches on its way to the root are replayed, which
+ * takes log(k) comparisons instead of the 2 log(k) of a binary heap
+ */
+
+#ifndef WSDB_LOSER_TREE_H
+#define WSDB_LOSER_TREE_H
+
+#include <utility>
+#include <vector>
+
+namespace wsdb {
+
+/**
+ * @tparam Less less(a, b) returns whether the current head of source a goes before the one of source b, exhausted
+ * sources should go after all others
+ */
+template <typename Less>
+class LoserTree
+{
+public:
+  LoserTree(size_t source_num, Less less) : source_num_(source_num), less_(std::move(less)) {}
+
+  /// play all matches on the current heads of the sources
+  void Build()
+  {
+    if (source_num_ == 0) {
+      return;
+    }
+    // winners of the subtrees, leaves live at [source_num_, 2 * source_num_)
+    std::vector<size_t> winners(2 * source_num_);
+    tree_.assign(source_num_, 0);
+    for (size_t i = 0; i < source_num_; ++i) {
+      winners[source_num_ + i] = i;
+    }
+    for (size_t node = source_num_ - 1; node >= 1; --node) {
+      auto l        = winners[2 * node];
+      auto r        = winners[2 * node + 1];
+      auto l_wins   = Before(l, r);
+      winners[node] = l_wins ? l : r;
+      tree_[node]   = l_wins ? r : l;
+    }
+    tree_[0] = winners[1 % (2 * source_num_)];
+  }
+
+  /// the source whose head goes first
+  [[nodiscard]] auto GetWinner() const -> size_t { return tree_[0]; }
+
+  /// replay the matches of the winner after its head changed
+  void Replay()
+  {
+    auto winner = tree_[0];
+    for (auto node = (winner + source_num_) / 2; node >= 1; node /= 2) {
+      if (Before(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+private:
+  /// ties go to the earlier source so that equal heads come out in the order of the sources
+  auto Before(size_t a, size_t b) -> bool { return less_(a, b) || (!less_(b, a) && a < b); }
+
+private:
+  size_t              source_num_;
+  Less                less_;
+  std::vector<size_t> tree_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_LOSER_TREE_H
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+/**
+ * @brief Morsels, the ranges of pages of a table the workers of a parallel scan take one at a time
+ * morsels are numbered in page order and handed out in that order by an atomic counter, so an exchange can put the
+ * output of the workers back in the order of a sequential scan
+ */
+
+#ifndef WSDB_MORSEL_H
+#define WSDB_MORSEL_H
+
+#include <algorithm>
+#include <atomic>
+#include "../../common/micro.h"
+#include "common/config.h"
+#include "common/types.h"
+
+namespace wsdb {
+
+/// pages [begin_, end_) of a table
+struct PageRange
+{
+  page_id_t begin_{INVALID_PAGE_ID};
+  page_id_t end_{INVALID_PAGE_ID};
+};
+
+class MorselQueue
+{
+public:
+  explicit MorselQueue(size_t morsel_pages = MORSEL_PAGE_NUM) : morsel_pages_(morsel_pages) {}
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(MorselQueue)
+
+  /// split pages [begin, end) into morsels, none of which is taken yet, should not be called while workers take them
+  void Reset(page_id_t begin, page_id_t end)
+  {
+    begin_      = begin;
+    end_        = end;
+    morsel_num_ = end > begin ? (static_cast<size_t>(end - begin) + morsel_pages_ - 1) / morsel_pages_ : 0;
+    next_       = 0;
+  }
+
+  /// take the next morsel, returns false when all of them are taken
+  auto Next(size_t &idx) -> bool
+  {
+    idx = next_.fetch_add(1);
+    return idx < morsel_num_;
+  }
+
+  [[nodiscard]] auto GetRange(size_t idx) const -> PageRange
+  {
+    auto begin = begin_ + static_cast<page_id_t>(idx * morsel_pages_);
+    return {begin, std::min(end_, begin + static_cast<page_id_t>(morsel_pages_))};
+  }
+
+  [[nodiscard]] auto GetMorselNum() const -> size_t { return morsel_num_; }
+
+private:
+  page_id_t           begin_{0};
+  page_id_t           end_{0};
+  size_t              morsel_pages_;
+  size_t              morsel_num_{0};
+  std::atomic<size_t> next_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_MORSEL_H
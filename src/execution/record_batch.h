@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/20.
+//
+
+#ifndef WSDB_RECORD_BATCH_H
+#define WSDB_RECORD_BATCH_H
+
+#include <vector>
+#include "common/config.h"
+#include "system/handle/record_handle.h"
+
+namespace wsdb {
+
+/**
+ * A batch of up to capacity rows passed between vectorized executors.
+ * Rows are views, either into memory the batch owns (AppendSlot, AppendCopy) or into memory of the producer
+ * (AppendView), in which case the producer keeps it alive until it fills the batch again.
+ * The selection vector holds the indexes of the rows that are still alive, operators like filter shrink it instead of
+ * moving rows around, consumers should only read GetRow(0) ... GetRow(GetSelSize() - 1).
+ */
+class RecordBatch
+{
+public:
+  RecordBatch() = delete;
+
+  explicit RecordBatch(const RecordSchema *schema, size_t capacity = BATCH_SIZE)
+      : schema_(schema),
+        capacity_(capacity),
+        slot_size_(BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength()),
+        rows_(capacity),
+        sel_(capacity)
+  {}
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(RecordBatch)
+
+  /// drop all rows, memory is kept for the next fill
+  void Reset()
+  {
+    row_num_ = 0;
+    sel_num_ = 0;
+  }
+
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  [[nodiscard]] auto GetCapacity() const -> size_t { return capacity_; }
+
+  [[nodiscard]] auto IsFull() const -> bool { return row_num_ == capacity_; }
+
+  /// number of rows appended, including the ones that are not selected
+  [[nodiscard]] auto GetRowNum() const -> size_t { return row_num_; }
+
+  [[nodiscard]] auto GetRows() const -> const RecordView * { return rows_.data(); }
+
+  [[nodiscard]] auto GetSel() -> uint32_t * { return sel_.data(); }
+
+  [[nodiscard]] auto GetSelSize() const -> size_t { return sel_num_; }
+
+  void SetSelSize(size_t sel_num)
+  {
+    WSDB_ASSERT(sel_num <= sel_num_, "selection can only shrink");
+    sel_num_ = sel_num;
+  }
+
+  /// the i-th selected row
+  [[nodiscard]] auto GetRow(size_t i) const -> const RecordView & { return rows_[sel_[i]]; }
+
+  /// append a row referencing memory of the caller
+  void AppendView(const RecordView &view)
+  {
+    WSDB_ASSERT(!IsFull(), "batch is full");
+    rows_[row_num_]  = view;
+    sel_[sel_num_++] = static_cast<uint32_t>(row_num_++);
+  }
+
+  /**
+   * Append a row stored in the batch, the caller fills the returned memory before reading the row
+   * @return null map of the row followed by its data, laid out as in Record
+   */
+  auto AppendSlot(RID rid) -> char *
+  {
+    if (mem_.empty()) {
+      mem_.resize(capacity_ * slot_size_);
+    }
+    auto slot = mem_.data() + row_num_ * slot_size_;
+    AppendView({schema_, slot, slot + BITMAP_SIZE(schema_->GetFieldCount()), rid});
+    return slot;
+  }
+
+  /// append a copy of view, view should have the same schema as the batch
+  void AppendCopy(const RecordView &view)
+  {
+    auto nullmap_size = BITMAP_SIZE(schema_->GetFieldCount());
+    auto slot         = AppendSlot(view.GetRID());
+    memcpy(slot, view.GetNullMap(), nullmap_size);
+    memcpy(slot + nullmap_size, view.GetData(), schema_->GetRecordLength());
+  }
+
+private:
+  const RecordSchema     *schema_;
+  size_t                  capacity_;
+  size_t                  slot_size_;
+  size_t                  row_num_{0};
+  size_t                  sel_num_{0};
+  std::vector<RecordView> rows_;
+  std::vector<uint32_t>   sel_;
+  // rows appended by AppendSlot, allocated on first use
+  std::vector<char> mem_;
+};
+
+DEFINE_UNIQUE_PTR(RecordBatch);
+
+}  // namespace wsdb
+
+#endif  // WSDB_RECORD_BATCH_H
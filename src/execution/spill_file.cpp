@@ -0,0 +1,123 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/28.
+//
+
+#include "spill_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include "common/config.h"
+
+namespace wsdb {
+
+static std::atomic<size_t> spill_file_fresh_id_{0};
+
+SpillFile::SpillFile(const RecordSchema *schema)
+    : schema_(schema),
+      nullmap_size_(BITMAP_SIZE(schema->GetFieldCount())),
+      slot_size_(nullmap_size_ + schema->GetRecordLength()),
+      path_(FILE_NAME(TMP_DIR, fmt::format("spill_{}_{}", getpid(), spill_file_fresh_id_++), TMP_SUFFIX))
+{
+  std::filesystem::create_directories(TMP_DIR);
+  fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd_ < 0) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, path_);
+  }
+}
+
+SpillFile::~SpillFile()
+{
+  close(fd_);
+  unlink(path_.c_str());
+}
+
+void SpillFile::Append(const RecordView &rec)
+{
+  WSDB_ASSERT(!is_reading_, "rows can not be appended after the file is rewound");
+  if (buf_.empty()) {
+    AllocBuf();
+  }
+  if ((buf_rows_ + 1) * slot_size_ > buf_.size()) {
+    Flush();
+  }
+  auto slot = buf_.data() + buf_rows_ * slot_size_;
+  memcpy(slot, rec.GetNullMap(), nullmap_size_);
+  memcpy(slot + nullmap_size_, rec.GetData(), schema_->GetRecordLength());
+  buf_rows_++;
+  row_num_++;
+}
+
+void SpillFile::AllocBuf() { buf_.resize(std::max(SPILL_BLOCK_SIZE / slot_size_, size_t{1}) * slot_size_); }
+
+void SpillFile::Flush()
+{
+  auto size   = buf_rows_ * slot_size_;
+  auto offset = static_cast<off_t>((row_num_ - buf_rows_) * slot_size_);
+  for (size_t done = 0; done < size;) {
+    auto n = pwrite(fd_, buf_.data() + done, size - done, offset + static_cast<off_t>(done));
+    if (n <= 0) {
+      WSDB_THROW(WSDB_FILE_WRITE_ERROR, path_);
+    }
+    done += n;
+  }
+  buf_rows_ = 0;
+}
+
+void SpillFile::Rewind()
+{
+  if (!is_reading_) {
+    Flush();
+    is_reading_ = true;
+    // files often wait for their turn to be read, the buffer is allocated again by the first Read
+    std::vector<char>().swap(buf_);
+  }
+  read_rows_ = 0;
+}
+
+auto SpillFile::Read(RecordBatch &batch) -> bool
+{
+  WSDB_ASSERT(is_reading_, "the file should be rewound before reading");
+  batch.Reset();
+  if (buf_.empty()) {
+    AllocBuf();
+  }
+  auto rows   = std::min({batch.GetCapacity(), buf_.size() / slot_size_, row_num_ - read_rows_});
+  auto size   = rows * slot_size_;
+  auto offset = static_cast<off_t>(read_rows_ * slot_size_);
+  for (size_t done = 0; done < size;) {
+    auto n = pread(fd_, buf_.data() + done, size - done, offset + static_cast<off_t>(done));
+    if (n <= 0) {
+      WSDB_THROW(WSDB_FILE_READ_ERROR, path_);
+    }
+    done += n;
+  }
+  for (size_t i = 0; i < rows; ++i) {
+    auto slot = buf_.data() + i * slot_size_;
+    batch.AppendView({schema_, slot, slot + nullmap_size_, INVALID_RID});
+  }
+  read_rows_ += rows;
+  return rows > 0;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,84 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/28.
+//
+
+/**
+ * @brief Temp file under TMP_DIR that executors spill rows to when their inputs do not fit in memory
+ * rows are stored back to back in the layout of Record, null map followed by data, and are written and read in blocks
+ * of SPILL_BLOCK_SIZE. A file is first appended to, then read from the beginning after Rewind, possibly several times
+ */
+
+#ifndef WSDB_SPILL_FILE_H
+#define WSDB_SPILL_FILE_H
+
+#include <string>
+#include <vector>
+#include "record_batch.h"
+
+namespace wsdb {
+
+class SpillFile
+{
+public:
+  /// create an empty file for rows of schema, the file is removed when the object is destroyed
+  explicit SpillFile(const RecordSchema *schema);
+
+  ~SpillFile();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(SpillFile)
+
+  void Append(const RecordView &rec);
+
+  /// write out the buffered rows, the next Read starts from the first row
+  void Rewind();
+
+  /// fill batch with views of the next rows, which are valid until the next Read, returns false if all rows are read
+  auto Read(RecordBatch &batch) -> bool;
+
+  [[nodiscard]] auto GetRowNum() const -> size_t { return row_num_; }
+
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+private:
+  void AllocBuf();
+
+  void Flush();
+
+private:
+  const RecordSchema *schema_;
+  size_t              nullmap_size_;
+  size_t              slot_size_;
+  std::string         path_;
+  int                 fd_;
+  // rows waiting to be written, or rows read by the last Read
+  std::vector<char> buf_;
+  size_t            buf_rows_{0};
+  size_t            row_num_{0};
+  // number of rows returned by Read since the last Rewind, rows are appended only before the first Rewind
+  size_t read_rows_{0};
+  bool   is_reading_{false};
+};
+
+DEFINE_UNIQUE_PTR(SpillFile);
+
+}  // namespace wsdb
+
+#endif  // WSDB_SPILL_FILE_H
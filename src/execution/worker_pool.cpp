@@ -0,0 +1,151 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include "common/config.h"
+
+namespace wsdb {
+
+auto WorkerPool::GetInstance() -> WorkerPool &
+{
+  static WorkerPool pool(std::max(std::thread::hardware_concurrency(), 1U));
+  return pool;
+}
+
+auto WorkerPool::GetMaxWorkers() -> size_t
+{
+  auto thread_num = GetInstance().GetThreadNum();
+  return MAX_WORKERS_PER_QUERY == 0 ? thread_num : std::min(MAX_WORKERS_PER_QUERY, thread_num);
+}
+
+WorkerPool::WorkerPool(size_t thread_num)
+{
+  threads_.reserve(thread_num);
+  for (size_t i = 0; i < thread_num; ++i) {
+    threads_.emplace_back([this] { Run(); });
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+auto WorkerPool::Submit(std::function<void()> task) -> size_t
+{
+  size_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ticket = next_ticket_++;
+    tasks_.emplace_back(ticket, std::move(task));
+  }
+  cv_.notify_one();
+  return ticket;
+}
+
+auto WorkerPool::Cancel(size_t ticket) -> bool
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(tasks_.begin(), tasks_.end(), [ticket](const auto &task) { return task.first == ticket; });
+  if (it == tasks_.end()) {
+    return false;
+  }
+  tasks_.erase(it);
+  return true;
+}
+
+void WorkerPool::ParallelFor(size_t task_num, size_t worker_num, const std::function<void(size_t)> &task)
+{
+  // the calling thread is one of the workers
+  auto                    helper_num = std::max(std::min(task_num, worker_num), size_t{1}) - 1;
+  std::atomic<size_t>     next{0};
+  std::mutex              mutex;
+  std::condition_variable cv;
+  size_t                  running = helper_num;
+  std::exception_ptr      error;
+
+  auto work = [&] {
+    try {
+      for (size_t i; (i = next.fetch_add(1)) < task_num;) {
+        task(i);
+      }
+    } catch (...) {
+      next = task_num;
+      std::lock_guard<std::mutex> lock(mutex);
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+  };
+  std::vector<size_t> tickets;
+  for (size_t i = 0; i < helper_num; ++i) {
+    tickets.push_back(Submit([&] {
+      work();
+      std::lock_guard<std::mutex> lock(mutex);
+      running--;
+      cv.notify_all();
+    }));
+  }
+  work();
+  // the tasks not taken by the pool yet may be queued behind tasks waiting for this thread
+  for (auto ticket : tickets) {
+    if (Cancel(ticket)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      running--;
+    }
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&] { return running == 0; });
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void WorkerPool::Run()
+{
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      // tasks left at exit belong to executors that wait for them, they are run before stopping
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front().second);
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace wsdb
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+/**
+ * @brief Threads shared by the executors of all queries to run the parallel parts of their plans
+ * a task is any callable, tasks run in the order they are submitted on one thread per hardware thread. Tasks may wait
+ * for the thread of their query, e.g. a worker of an exchange waits for room in its buffer, but never for other tasks,
+ * so every task finishes as long as the threads of the queries keep running. A query that waits for its own tasks
+ * cancels the ones not started yet instead, they may be queued behind tasks waiting for that query.
+ */
+
+#ifndef WSDB_WORKER_POOL_H
+#define WSDB_WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../../common/micro.h"
+
+namespace wsdb {
+
+class WorkerPool
+{
+public:
+  /// the pool of the process, its threads are started on first use
+  static auto GetInstance() -> WorkerPool &;
+
+  /// max number of workers a query runs its parallel parts on, MAX_WORKERS_PER_QUERY bounded by the pool size
+  static auto GetMaxWorkers() -> size_t;
+
+  ~WorkerPool();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(WorkerPool)
+
+  /// returns the ticket of task
+  auto Submit(std::function<void()> task) -> size_t;
+
+  /// remove the task of ticket if no thread has taken it yet, returns false if it is running or done
+  auto Cancel(size_t ticket) -> bool;
+
+  /**
+   * run task(i) for every i in [0, task_num) on up to worker_num threads, the calling thread being one of them, and
+   * wait for them. The tasks left are skipped after one throws, the exception is rethrown to the caller
+   */
+  void ParallelFor(size_t task_num, size_t worker_num, const std::function<void(size_t)> &task);
+
+  [[nodiscard]] auto GetThreadNum() const -> size_t { return threads_.size(); }
+
+private:
+  explicit WorkerPool(size_t thread_num);
+
+  void Run();
+
+private:
+  std::vector<std::thread> threads_;
+  std::mutex               mutex_;
+  std::condition_variable  cv_;
+  // tasks with their tickets in the order they are submitted
+  std::deque<std::pair<size_t, std::function<void()>>> tasks_;
+  size_t                                               next_ticket_{0};
+  bool                                                 stop_{false};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_WORKER_POOL_H
@@ -0,0 +1,337 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/26.
+//
+
+#include "column_kernel.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WSDB_X86
+#endif
+
+namespace wsdb {
+
+namespace {
+
+/// values are compared as int32_t only when both sides are int32_t
+template <typename L, typename R>
+using CmpType = std::conditional_t<std::is_same_v<L, int32_t> && std::is_same_v<R, int32_t>, int32_t, float>;
+
+/// clear the bits of the last byte that do not belong to any of the n rows
+inline void ClearTail(char *bitmap, size_t n)
+{
+  if (n % BITMAP_WIDTH != 0) {
+    bitmap[n / BITMAP_WIDTH] &= static_cast<char>((1 << (n % BITMAP_WIDTH)) - 1);
+  }
+}
+
+/// rows [begin, n), begin should be a multiple of BITMAP_WIDTH
+template <CompOp op, typename L, typename R, bool rhs_is_col>
+void CompareScalar(const L *lhs, const R *rhs, R rconst, size_t begin, size_t n, char *bitmap)
+{
+  for (size_t i = begin; i < n; i += BITMAP_WIDTH) {
+    unsigned bits = 0;
+    for (size_t j = 0; j < BITMAP_WIDTH && i + j < n; ++j) {
+      bits |= static_cast<unsigned>(CompareValues<op>(lhs[i + j], rhs_is_col ? rhs[i + j] : rconst)) << j;
+    }
+    bitmap[i / BITMAP_WIDTH] = static_cast<char>(bits);
+  }
+}
+
+#ifdef WSDB_X86
+
+/// 1. AVX2, 8 rows per compare, one byte of the bitmap
+
+template <typename C, typename T>
+__attribute__((target("avx2"))) inline auto Load8(const T *mem)
+{
+  if constexpr (std::is_same_v<C, int32_t>) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mem));
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(mem)));
+  } else {
+    return _mm256_loadu_ps(mem);
+  }
+}
+
+template <typename C, typename T>
+__attribute__((target("avx2"))) inline auto Broadcast8(T v)
+{
+  if constexpr (std::is_same_v<C, int32_t>) {
+    return _mm256_set1_epi32(v);
+  } else {
+    return _mm256_set1_ps(static_cast<float>(v));
+  }
+}
+
+template <CompOp op>
+__attribute__((target("avx2"))) inline auto Mask8(__m256i l, __m256i r) -> unsigned
+{
+  // only == and > exist for integers, the other ops swap the operands and/or negate the result
+  __m256i m;
+  if constexpr (op == OP_EQ || op == OP_NE) {
+    m = _mm256_cmpeq_epi32(l, r);
+  } else if constexpr (op == OP_GT || op == OP_LE) {
+    m = _mm256_cmpgt_epi32(l, r);
+  } else {
+    m = _mm256_cmpgt_epi32(r, l);
+  }
+  auto bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+  return op == OP_NE || op == OP_LE || op == OP_GE ? ~bits & 0xff : bits;
+}
+
+template <CompOp op>
+__attribute__((target("avx2"))) inline auto Mask8(__m256 l, __m256 r) -> unsigned
+{
+  // ordered predicates are false on NaN and the unordered != is true, the same as the C++ operators
+  constexpr int pred = op == OP_EQ   ? _CMP_EQ_OQ
+                       : op == OP_NE ? _CMP_NEQ_UQ
+                       : op == OP_LT ? _CMP_LT_OQ
+                       : op == OP_LE ? _CMP_LE_OQ
+                       : op == OP_GT ? _CMP_GT_OQ
+                                     : _CMP_GE_OQ;
+  return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(l, r, pred)));
+}
+
+template <CompOp op, typename L, typename R, bool rhs_is_col>
+__attribute__((target("avx2"))) void CompareAVX2(const L *lhs, const R *rhs, R rconst, size_t n, char *bitmap)
+{
+  using C     = CmpType<L, R>;
+  auto   rvec = Broadcast8<C>(rconst);
+  size_t i    = 0;
+  for (; i + 8 <= n; i += 8) {
+    if constexpr (rhs_is_col) {
+      bitmap[i / BITMAP_WIDTH] = static_cast<char>(Mask8<op>(Load8<C>(lhs + i), Load8<C>(rhs + i)));
+    } else {
+      bitmap[i / BITMAP_WIDTH] = static_cast<char>(Mask8<op>(Load8<C>(lhs + i), rvec));
+    }
+  }
+  CompareScalar<op, L, R, rhs_is_col>(lhs, rhs, rconst, i, n, bitmap);
+}
+
+/// 2. SSE2, part of x86-64, 4 rows per compare, two compares fill one byte of the bitmap
+
+template <typename C, typename T>
+inline auto Load4(const T *mem)
+{
+  if constexpr (std::is_same_v<C, int32_t>) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(mem));
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(mem)));
+  } else {
+    return _mm_loadu_ps(mem);
+  }
+}
+
+template <typename C, typename T>
+inline auto Broadcast4(T v)
+{
+  if constexpr (std::is_same_v<C, int32_t>) {
+    return _mm_set1_epi32(v);
+  } else {
+    return _mm_set1_ps(static_cast<float>(v));
+  }
+}
+
+template <CompOp op>
+inline auto Mask4(__m128i l, __m128i r) -> unsigned
+{
+  __m128i m;
+  if constexpr (op == OP_EQ || op == OP_NE) {
+    m = _mm_cmpeq_epi32(l, r);
+  } else if constexpr (op == OP_GT || op == OP_LE) {
+    m = _mm_cmpgt_epi32(l, r);
+  } else {
+    m = _mm_cmplt_epi32(l, r);
+  }
+  auto bits = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+  return op == OP_NE || op == OP_LE || op == OP_GE ? ~bits & 0xf : bits;
+}
+
+template <CompOp op>
+inline auto Mask4(__m128 l, __m128 r) -> unsigned
+{
+  __m128 m;
+  if constexpr (op == OP_EQ) {
+    m = _mm_cmpeq_ps(l, r);
+  } else if constexpr (op == OP_NE) {
+    m = _mm_cmpneq_ps(l, r);
+  } else if constexpr (op == OP_LT) {
+    m = _mm_cmplt_ps(l, r);
+  } else if constexpr (op == OP_LE) {
+    m = _mm_cmple_ps(l, r);
+  } else if constexpr (op == OP_GT) {
+    m = _mm_cmpgt_ps(l, r);
+  } else {
+    m = _mm_cmpge_ps(l, r);
+  }
+  return static_cast<unsigned>(_mm_movemask_ps(m));
+}
+
+template <CompOp op, typename L, typename R, bool rhs_is_col>
+void CompareSSE2(const L *lhs, const R *rhs, R rconst, size_t n, char *bitmap)
+{
+  using C     = CmpType<L, R>;
+  auto   rvec = Broadcast4<C>(rconst);
+  size_t i    = 0;
+  for (; i + 8 <= n; i += 8) {
+    unsigned lo;
+    unsigned hi;
+    if constexpr (rhs_is_col) {
+      lo = Mask4<op>(Load4<C>(lhs + i), Load4<C>(rhs + i));
+      hi = Mask4<op>(Load4<C>(lhs + i + 4), Load4<C>(rhs + i + 4));
+    } else {
+      lo = Mask4<op>(Load4<C>(lhs + i), rvec);
+      hi = Mask4<op>(Load4<C>(lhs + i + 4), rvec);
+    }
+    bitmap[i / BITMAP_WIDTH] = static_cast<char>(lo | hi << 4);
+  }
+  CompareScalar<op, L, R, rhs_is_col>(lhs, rhs, rconst, i, n, bitmap);
+}
+
+#endif
+
+template <CompOp op, typename L, typename R, bool rhs_is_col>
+void Compare(const L *lhs, const R *rhs, R rconst, size_t n, char *bitmap)
+{
+#ifdef WSDB_X86
+  if (ColumnKernel::HasAVX2()) {
+    CompareAVX2<op, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap);
+  } else {
+    CompareSSE2<op, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap);
+  }
+#else
+  CompareScalar<op, L, R, rhs_is_col>(lhs, rhs, rconst, 0, n, bitmap);
+#endif
+}
+
+template <typename L, typename R, bool rhs_is_col>
+void Compare(CompOp op, const L *lhs, const R *rhs, R rconst, size_t n, char *bitmap)
+{
+  switch (op) {
+    case OP_EQ: Compare<OP_EQ, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap); break;
+    case OP_NE: Compare<OP_NE, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap); break;
+    case OP_LT: Compare<OP_LT, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap); break;
+    case OP_LE: Compare<OP_LE, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap); break;
+    case OP_GT: Compare<OP_GT, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap); break;
+    case OP_GE: Compare<OP_GE, L, R, rhs_is_col>(lhs, rhs, rconst, n, bitmap); break;
+    default: WSDB_FETAL(CompOpToString(op));
+  }
+  ClearTail(bitmap, n);
+}
+
+}  // namespace
+
+template <typename L, typename R>
+void ColumnKernel::CompareConst(CompOp op, const L *lhs, R rhs, size_t n, char *bitmap)
+{
+  Compare<L, R, false>(op, lhs, nullptr, rhs, n, bitmap);
+}
+
+template <typename L, typename R>
+void ColumnKernel::CompareColumn(CompOp op, const L *lhs, const R *rhs, size_t n, char *bitmap)
+{
+  Compare<L, R, true>(op, lhs, rhs, R{}, n, bitmap);
+}
+
+template void ColumnKernel::CompareConst<int32_t, int32_t>(CompOp, const int32_t *, int32_t, size_t, char *);
+template void ColumnKernel::CompareConst<int32_t, float>(CompOp, const int32_t *, float, size_t, char *);
+template void ColumnKernel::CompareConst<float, int32_t>(CompOp, const float *, int32_t, size_t, char *);
+template void ColumnKernel::CompareConst<float, float>(CompOp, const float *, float, size_t, char *);
+template void ColumnKernel::CompareColumn<int32_t, int32_t>(CompOp, const int32_t *, const int32_t *, size_t, char *);
+template void ColumnKernel::CompareColumn<int32_t, float>(CompOp, const int32_t *, const float *, size_t, char *);
+template void ColumnKernel::CompareColumn<float, int32_t>(CompOp, const float *, const int32_t *, size_t, char *);
+template void ColumnKernel::CompareColumn<float, float>(CompOp, const float *, const float *, size_t, char *);
+
+void ColumnKernel::MaskNulls(CompOp op, const char *lnull, const char *rnull, size_t n, char *bitmap)
+{
+  // byte-wise loops without branches on the data, compilers vectorize them
+  auto bytes = BITMAP_SIZE(n);
+  if (rnull == nullptr) {
+    if (op == OP_NE) {
+      for (size_t i = 0; i < bytes; ++i) {
+        bitmap[i] |= lnull[i];
+      }
+    } else {
+      for (size_t i = 0; i < bytes; ++i) {
+        bitmap[i] &= ~lnull[i];
+      }
+    }
+  } else {
+    for (size_t i = 0; i < bytes; ++i) {
+      char any  = lnull[i] | rnull[i];
+      char both = lnull[i] & rnull[i];
+      char res  = bitmap[i] & ~any;
+      if (op == OP_EQ) {
+        res |= both;
+      } else if (op == OP_NE) {
+        res |= any & ~both;
+      }
+      bitmap[i] = res;
+    }
+  }
+  ClearTail(bitmap, n);
+}
+
+void ColumnKernel::SelectAll(char *bitmap, size_t n)
+{
+  BitMap::Set(bitmap, n);
+  ClearTail(bitmap, n);
+}
+
+auto ColumnKernel::And(char *bitmap, const char *other, size_t n) -> size_t
+{
+  size_t cnt = 0;
+  for (size_t i = 0; i < BITMAP_SIZE(n); ++i) {
+    bitmap[i] &= other[i];
+    cnt += std::popcount(static_cast<unsigned char>(bitmap[i]));
+  }
+  return cnt;
+}
+
+auto ColumnKernel::ToSelection(const char *bitmap, size_t n, uint32_t *sel) -> size_t
+{
+  size_t out   = 0;
+  size_t bytes = BITMAP_SIZE(n);
+  for (size_t i = 0; i < bytes; i += sizeof(uint64_t)) {
+    // bit j of byte k is bit 8 * k + j of the word on little endian machines
+    uint64_t word = 0;
+    std::memcpy(&word, bitmap + i, std::min(sizeof(uint64_t), bytes - i));
+    for (; word != 0; word &= word - 1) {
+      sel[out++] = static_cast<uint32_t>(i * BITMAP_WIDTH + std::countr_zero(word));
+    }
+  }
+  return out;
+}
+
+auto ColumnKernel::HasAVX2() -> bool
+{
+#ifdef WSDB_X86
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+}  // namespace wsdb
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/26.
+//
+
+#ifndef WSDB_COLUMN_KERNEL_H
+#define WSDB_COLUMN_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include "common/bitmap.h"
+#include "common/condition.h"
+#include "../../common/micro.h"
+
+namespace wsdb {
+
+/// lhs op rhs, int against float compares as float by the usual arithmetic conversions, like ValueFactory::AlignTypes
+template <CompOp op, typename L, typename R>
+inline auto CompareValues(const L &l, const R &r) -> bool
+{
+  if constexpr (op == OP_EQ) {
+    return l == r;
+  } else if constexpr (op == OP_NE) {
+    return l != r;
+  } else if constexpr (op == OP_LT) {
+    return l < r;
+  } else if constexpr (op == OP_LE) {
+    return l <= r;
+  } else if constexpr (op == OP_GT) {
+    return l > r;
+  } else {
+    return l >= r;
+  }
+}
+
+/**
+ * Comparison kernels over contiguous column arrays, e.g. the field regions of a PAX page copied into a ColumnVector.
+ * The result is a selection bitmap in the layout of BitMap: bit i is set iff row i passes. 8 rows are compared per
+ * AVX2 instruction when the cpu supports it (checked once at runtime), 4 per SSE2 instruction otherwise, and a scalar
+ * loop handles the tail and other architectures. Only int32_t and float columns are supported, int against float is
+ * compared as float. Nulls are not looked at, see MaskNulls.
+ */
+class ColumnKernel
+{
+public:
+  ColumnKernel()  = delete;
+  ~ColumnKernel() = delete;
+  DISABLE_COPY_MOVE_AND_ASSIGN(ColumnKernel);
+
+  /// bitmap[i] = lhs[i] op rhs for i in [0, n), the unused bits of the last byte are cleared
+  template <typename L, typename R>
+  static void CompareConst(CompOp op, const L *lhs, R rhs, size_t n, char *bitmap);
+
+  /// bitmap[i] = lhs[i] op rhs[i] for i in [0, n), the unused bits of the last byte are cleared
+  template <typename L, typename R>
+  static void CompareColumn(CompOp op, const L *lhs, const R *rhs, size_t n, char *bitmap);
+
+  /**
+   * Fix up the comparison result of n rows with the null semantics of Scalar::Eval: two nulls are equal, any other
+   * comparison involving a null is false except !=
+   * @param lnull null map of the lhs column
+   * @param rnull null map of the rhs column, nullptr if rhs is a non-null constant
+   */
+  static void MaskNulls(CompOp op, const char *lnull, const char *rnull, size_t n, char *bitmap);
+
+  /// select all of the n rows, the unused bits of the last byte are cleared
+  static void SelectAll(char *bitmap, size_t n);
+
+  /// bitmap &= other, returns the number of bits set in the result
+  static auto And(char *bitmap, const char *other, size_t n) -> size_t;
+
+  /// write the indexes of the set bits in bitmap to sel in ascending order, returns how many are written
+  static auto ToSelection(const char *bitmap, size_t n, uint32_t *sel) -> size_t;
+
+  [[nodiscard]] static auto HasAVX2() -> bool;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_COLUMN_KERNEL_H
@@ -23,39 +23,35 @@
 
 namespace wsdb {
 
-auto ConditionExpr::Eval(const ConditionVec &condition, const wsdb::Record &record) -> bool
+auto ConditionExpr::Eval(const ConditionVec &condition, const RecordView &record) -> bool
 {
   return std::all_of(
       condition.begin(), condition.end(), [&record](const Condition &cond) { return EvalCond(cond, record); });
 }
 
-auto ConditionExpr::EvalCond(const Condition &condition, const wsdb::Record &record) -> bool
+auto ConditionExpr::EvalCond(const Condition &condition, const RecordView &record) -> bool
 {
   // first get the lhs value according to condition
   auto idx = record.GetSchema()->GetRTFieldIndex(condition.GetLCol());
   WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-  auto lhs = record.GetValueAt(idx);
+  auto lhs = record.GetScalarAt(idx);
   WSDB_ASSERT(condition.GetRhsType() == kValue || condition.GetRhsType() == kColumn, "Invalid condition type");
-  ValueSptr rhs;
+  if (condition.GetOp() == OP_IN) {
+    auto list = std::dynamic_pointer_cast<ArrayValue>(condition.GetRVal());
+    WSDB_ASSERT(list != nullptr, "IN should be followed by a value list");
+    return std::any_of(list->Get().begin(), list->Get().end(), [&lhs](const ValueSptr &v) {
+      return Scalar::Eval(OP_EQ, lhs, Scalar::FromValue(*v));
+    });
+  }
+  Scalar rhs;
   if (condition.GetRhsType() == kValue) {
-    rhs = condition.GetRVal();
+    rhs = condition.GetRScalar();
   } else {
     idx = record.GetSchema()->GetRTFieldIndex(condition.GetRCol());
     WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-    rhs = record.GetValueAt(idx);
-  }
-  ValueFactory::AlignTypes(lhs, rhs);
-  switch (condition.GetOp()) {
-    case OP_EQ: return *lhs == *rhs;
-    case OP_NE: return *lhs != *rhs;
-    case OP_LT: return *lhs < *rhs;
-    case OP_LE: return *lhs <= *rhs;
-    case OP_GT: return *lhs > *rhs;
-    case OP_GE: return *lhs >= *rhs;
-    case OP_IN: return std::dynamic_pointer_cast<ArrayValue>(rhs)->Contains(lhs);
-    default: WSDB_FETAL(CompOpToString(condition.GetOp()));
+    rhs = record.GetScalarAt(idx);
   }
-  // should never reach here
+  return Scalar::Eval(condition.GetOp(), lhs, rhs);
 }
 
 }  // namespace wsdb
\ No newline at end of file
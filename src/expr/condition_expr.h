@@ -33,10 +33,10 @@ public:
   ConditionExpr() = delete;
   DISABLE_COPY_MOVE_AND_ASSIGN(ConditionExpr);
 
-  static auto Eval(const ConditionVec &condition, const Record &record)-> bool;
+  static auto Eval(const ConditionVec &condition, const RecordView &record) -> bool;
 
 private:
-  static auto EvalCond(const Condition &condition, const Record &record) -> bool;
+  static auto EvalCond(const Condition &condition, const RecordView &record) -> bool;
 };
 
 }  // namespace wsdb
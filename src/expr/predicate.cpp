@@ -0,0 +1,325 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/24.
+//
+
+#include "predicate.h"
+#include "column_kernel.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace wsdb {
+
+namespace {
+
+using Term    = Predicate::Term;
+using Operand = Predicate::Operand;
+
+auto BindColumn(const RecordSchema *schema, const RTField &field, FieldType *type) -> Operand
+{
+  auto idx = schema->GetRTFieldIndex(field);
+  WSDB_ASSERT(idx != schema->GetFieldCount(), "Invalid field");
+  auto &f = schema->GetFieldAt(idx).field_;
+  *type   = f.field_type_;
+  return {idx, schema->GetFieldOffset(idx), f.field_size_};
+}
+
+template <typename T>
+inline auto Load(const char *mem, size_t size) -> T
+{
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    return {mem, strnlen(mem, size)};
+  } else {
+    T v;
+    std::memcpy(&v, mem, sizeof(T));
+    return v;
+  }
+}
+
+template <typename T>
+inline auto Const(const Term &term) -> T
+{
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return term.rconst_.int_;
+  } else if constexpr (std::is_same_v<T, float>) {
+    return term.rconst_.float_;
+  } else if constexpr (std::is_same_v<T, bool>) {
+    return term.rconst_.bool_;
+  } else {
+    return term.rconst_str_;
+  }
+}
+
+/// comparison involving a null: two nulls are equal, any other comparison except != is false
+template <CompOp op>
+inline auto CompareNull(bool both_null) -> bool
+{
+  if constexpr (op == OP_EQ) {
+    return both_null;
+  } else if constexpr (op == OP_NE) {
+    return !both_null;
+  } else {
+    return false;
+  }
+}
+
+/**
+ * The kernel family, one instantiation per (lhs type, rhs type, op, constant/column rhs). The loop writes the index of
+ * every row back into sel and only advances the output cursor for rows that pass, so there is no branch on the result.
+ */
+template <typename L, typename R, CompOp op, bool rhs_is_col>
+auto FilterKernel(const Term &term, const RecordView *rows, uint32_t *sel, size_t n) -> size_t
+{
+  const auto lidx = term.lhs_.idx_;
+  const auto loff = term.lhs_.off_;
+  const auto lsz  = term.lhs_.size_;
+  size_t     out  = 0;
+  if constexpr (rhs_is_col) {
+    const auto ridx = term.rhs_.idx_;
+    const auto roff = term.rhs_.off_;
+    const auto rsz  = term.rhs_.size_;
+    for (size_t i = 0; i < n; ++i) {
+      const auto &row   = rows[sel[i]];
+      auto        lnull = row.IsNull(lidx);
+      auto        rnull = row.IsNull(ridx);
+      auto        keep  = lnull || rnull ? CompareNull<op>(lnull && rnull)
+                                         : CompareValues<op>(Load<L>(row.GetData() + loff, lsz),
+                                                 Load<R>(row.GetData() + roff, rsz));
+      sel[out]          = sel[i];
+      out += keep;
+    }
+  } else {
+    const auto rval = Const<R>(term);
+    for (size_t i = 0; i < n; ++i) {
+      const auto &row  = rows[sel[i]];
+      auto        keep = row.IsNull(lidx) ? CompareNull<op>(false)
+                                          : CompareValues<op>(Load<L>(row.GetData() + loff, lsz), rval);
+      sel[out]         = sel[i];
+      out += keep;
+    }
+  }
+  return out;
+}
+
+/// rare shapes: constant null and IN lists, evaluated with Scalar
+auto GenericKernel(const Term &term, const RecordView *rows, uint32_t *sel, size_t n) -> size_t
+{
+  size_t out = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto lhs  = rows[sel[i]].GetScalarAt(term.lhs_.idx_);
+    auto keep = false;
+    if (term.op_ == OP_IN) {
+      keep = std::any_of(term.in_list_.begin(), term.in_list_.end(), [&lhs](const Scalar &v) {
+        return Scalar::Eval(OP_EQ, lhs, v);
+      });
+    } else {
+      keep = Scalar::Eval(term.op_, lhs, Scalar::Null(lhs.GetType()));
+    }
+    sel[out] = sel[i];
+    out += keep;
+  }
+  return out;
+}
+
+template <typename L, typename R, bool rhs_is_col>
+auto SelectKernel(CompOp op) -> Predicate::Kernel
+{
+  switch (op) {
+    case OP_EQ: return FilterKernel<L, R, OP_EQ, rhs_is_col>;
+    case OP_NE: return FilterKernel<L, R, OP_NE, rhs_is_col>;
+    case OP_LT: return FilterKernel<L, R, OP_LT, rhs_is_col>;
+    case OP_LE: return FilterKernel<L, R, OP_LE, rhs_is_col>;
+    case OP_GT: return FilterKernel<L, R, OP_GT, rhs_is_col>;
+    case OP_GE: return FilterKernel<L, R, OP_GE, rhs_is_col>;
+    default: WSDB_FETAL(CompOpToString(op));
+  }
+}
+
+template <bool rhs_is_col>
+auto SelectKernel(FieldType ltype, FieldType rtype, CompOp op) -> Predicate::Kernel
+{
+  using S = std::string_view;
+  if (ltype == FieldType::TYPE_INT && rtype == FieldType::TYPE_INT) {
+    return SelectKernel<int32_t, int32_t, rhs_is_col>(op);
+  } else if (ltype == FieldType::TYPE_INT && rtype == FieldType::TYPE_FLOAT) {
+    return SelectKernel<int32_t, float, rhs_is_col>(op);
+  } else if (ltype == FieldType::TYPE_FLOAT && rtype == FieldType::TYPE_INT) {
+    return SelectKernel<float, int32_t, rhs_is_col>(op);
+  } else if (ltype == FieldType::TYPE_FLOAT && rtype == FieldType::TYPE_FLOAT) {
+    return SelectKernel<float, float, rhs_is_col>(op);
+  } else if (ltype == FieldType::TYPE_BOOL && rtype == FieldType::TYPE_BOOL) {
+    return SelectKernel<bool, bool, rhs_is_col>(op);
+  } else if (ltype == FieldType::TYPE_STRING && rtype == FieldType::TYPE_STRING) {
+    return SelectKernel<S, S, rhs_is_col>(op);
+  }
+  WSDB_THROW(WSDB_TYPE_MISSMATCH,
+      fmt::format("Type mismatch: {} != {}", FieldTypeToString(ltype), FieldTypeToString(rtype)));
+}
+
+/// int and float comparisons: whole columns are compared by the SIMD kernels, then the null rows are fixed up
+template <typename L, typename R, bool rhs_is_col>
+void NumericChunkKernel(const Term &term, const Chunk &chunk, const char * /*selected*/, char *bitmap)
+{
+  const auto &lcol = chunk.GetColumn(term.lhs_.idx_);
+  auto        n    = chunk.GetRowCount();
+  if constexpr (rhs_is_col) {
+    const auto &rcol = chunk.GetColumn(term.rhs_.idx_);
+    ColumnKernel::CompareColumn(term.op_, lcol.GetData<L>(), rcol.GetData<R>(), n, bitmap);
+    ColumnKernel::MaskNulls(term.op_, lcol.GetNullMap(), rcol.GetNullMap(), n, bitmap);
+  } else {
+    ColumnKernel::CompareConst(term.op_, lcol.GetData<L>(), Const<R>(term), n, bitmap);
+    ColumnKernel::MaskNulls(term.op_, lcol.GetNullMap(), nullptr, n, bitmap);
+  }
+}
+
+/// strings, bools, IN lists and constant nulls, evaluated with Scalar on the selected rows only
+template <bool rhs_is_col>
+void GenericChunkKernel(const Term &term, const Chunk &chunk, const char *selected, char *bitmap)
+{
+  const auto &lcol = chunk.GetColumn(term.lhs_.idx_);
+  auto        n    = chunk.GetRowCount();
+  BitMap::Clear(bitmap, n);
+  for (size_t i = 0; i < n; ++i) {
+    if (!BitMap::GetBit(selected, i)) {
+      continue;
+    }
+    auto lhs  = lcol.GetScalarAt(i);
+    auto keep = false;
+    if (term.op_ == OP_IN) {
+      keep = std::any_of(term.in_list_.begin(), term.in_list_.end(), [&lhs](const Scalar &v) {
+        return Scalar::Eval(OP_EQ, lhs, v);
+      });
+    } else if constexpr (rhs_is_col) {
+      keep = Scalar::Eval(term.op_, lhs, chunk.GetColumn(term.rhs_.idx_).GetScalarAt(i));
+    } else {
+      keep = Scalar::Eval(term.op_, lhs, term.rscalar_);
+    }
+    BitMap::SetBit(bitmap, i, keep);
+  }
+}
+
+template <bool rhs_is_col>
+auto SelectChunkKernel(FieldType ltype, FieldType rtype) -> Predicate::ChunkKernel
+{
+  if (ltype == FieldType::TYPE_INT && rtype == FieldType::TYPE_INT) {
+    return NumericChunkKernel<int32_t, int32_t, rhs_is_col>;
+  } else if (ltype == FieldType::TYPE_INT && rtype == FieldType::TYPE_FLOAT) {
+    return NumericChunkKernel<int32_t, float, rhs_is_col>;
+  } else if (ltype == FieldType::TYPE_FLOAT && rtype == FieldType::TYPE_INT) {
+    return NumericChunkKernel<float, int32_t, rhs_is_col>;
+  } else if (ltype == FieldType::TYPE_FLOAT && rtype == FieldType::TYPE_FLOAT) {
+    return NumericChunkKernel<float, float, rhs_is_col>;
+  }
+  return GenericChunkKernel<rhs_is_col>;
+}
+
+}  // namespace
+
+Predicate::Predicate(const ConditionVec &conds, const RecordSchema *schema)
+{
+  terms_.reserve(conds.size());
+  for (const auto &cond : conds) {
+    WSDB_ASSERT(cond.GetRhsType() == kValue || cond.GetRhsType() == kColumn, "Invalid condition type");
+    Term      term{};
+    FieldType ltype;
+    FieldType rtype;
+    term.op_  = cond.GetOp();
+    term.lhs_ = BindColumn(schema, cond.GetLCol(), &ltype);
+    if (cond.GetRhsType() == kColumn) {
+      term.rhs_    = BindColumn(schema, cond.GetRCol(), &rtype);
+      term.kernel_       = SelectKernel<true>(ltype, rtype, term.op_);
+      term.chunk_kernel_ = SelectChunkKernel<true>(ltype, rtype);
+      terms_.push_back(std::move(term));
+      continue;
+    }
+    term.rval_holder_ = cond.GetRVal();
+    if (cond.GetOp() == OP_IN) {
+      auto list = std::dynamic_pointer_cast<ArrayValue>(cond.GetRVal());
+      WSDB_ASSERT(list != nullptr, "IN should be followed by a value list");
+      for (const auto &v : list->Get()) {
+        term.in_list_.push_back(Scalar::FromValue(*v));
+      }
+      term.kernel_       = GenericKernel;
+      term.chunk_kernel_ = GenericChunkKernel<false>;
+      terms_.push_back(std::move(term));
+      continue;
+    }
+    auto rval = cond.GetRScalar();
+    if (rval.IsNull()) {
+      term.kernel_       = GenericKernel;
+      term.chunk_kernel_ = GenericChunkKernel<false>;
+      term.rscalar_      = rval;
+      terms_.push_back(std::move(term));
+      continue;
+    }
+    // cast the constant once instead of for every record
+    rtype = rval.GetType();
+    if (ltype == FieldType::TYPE_FLOAT && rtype == FieldType::TYPE_INT) {
+      rval  = Scalar::Float(static_cast<float>(rval.GetInt()));
+      rtype = FieldType::TYPE_FLOAT;
+    }
+    switch (rtype) {
+      case FieldType::TYPE_INT: term.rconst_.int_ = rval.GetInt(); break;
+      case FieldType::TYPE_FLOAT: term.rconst_.float_ = rval.GetFloat(); break;
+      case FieldType::TYPE_BOOL: term.rconst_.bool_ = rval.GetBool(); break;
+      case FieldType::TYPE_STRING: term.rconst_str_ = rval.GetString(); break;
+      default: WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(rtype));
+    }
+    term.rscalar_      = rval;
+    term.kernel_       = SelectKernel<false>(ltype, rtype, term.op_);
+    term.chunk_kernel_ = SelectChunkKernel<false>(ltype, rtype);
+    terms_.push_back(std::move(term));
+  }
+}
+
+auto Predicate::Eval(const RecordView &record) const -> bool
+{
+  uint32_t sel = 0;
+  return Filter(&record, &sel, 1) == 1;
+}
+
+auto Predicate::Filter(const RecordView *rows, uint32_t *sel, size_t n) const -> size_t
+{
+  for (const auto &term : terms_) {
+    if (n == 0) {
+      break;
+    }
+    n = term.kernel_(term, rows, sel, n);
+  }
+  return n;
+}
+
+auto Predicate::Filter(const Chunk &chunk, char *bitmap) const -> size_t
+{
+  auto n = chunk.GetRowCount();
+  ColumnKernel::SelectAll(bitmap, n);
+  auto term_bitmap = std::vector<char>(BITMAP_SIZE(n));
+  auto cnt         = n;
+  for (const auto &term : terms_) {
+    if (cnt == 0) {
+      break;
+    }
+    term.chunk_kernel_(term, chunk, bitmap, term_bitmap.data());
+    cnt = ColumnKernel::And(bitmap, term_bitmap.data(), n);
+  }
+  return cnt;
+}
+
+}  // namespace wsdb
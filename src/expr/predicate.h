@@ -0,0 +1,113 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/24.
+//
+
+#ifndef WSDB_PREDICATE_H
+#define WSDB_PREDICATE_H
+
+#include <string_view>
+#include "common/condition.h"
+#include "system/handle/record_handle.h"
+
+namespace wsdb {
+
+/**
+ * A ConditionVec compiled against the schema of the records it is evaluated on. Field indexes, offsets and types are
+ * resolved and constants are cast to the type of the comparison once. Every term is then bound to a filter kernel, a
+ * loop over a selection of rows instantiated for its (lhs type, rhs type, comparison op, constant/column rhs), so
+ * evaluation reads record bytes directly without any per-row dispatch on types or ops.
+ * Semantics are the same as ConditionExpr::Eval.
+ */
+class Predicate
+{
+public:
+  Predicate() = default;
+
+  /**
+   * @param conds conditions on columns and constants, all of them should hold
+   * @param schema schema of the records to evaluate
+   */
+  Predicate(const ConditionVec &conds, const RecordSchema *schema);
+
+  [[nodiscard]] auto Eval(const RecordView &record) const -> bool;
+
+  /**
+   * Evaluate the predicate on a batch of rows, each term runs its kernel once over the rows that passed the previous
+   * terms
+   * @param rows
+   * @param sel indexes into rows to evaluate, overwritten with the indexes of the rows that pass, order is kept
+   * @param n number of indexes in sel
+   * @return number of rows that pass
+   */
+  auto Filter(const RecordView *rows, uint32_t *sel, size_t n) const -> size_t;
+
+  /**
+   * Evaluate the predicate column at a time on a chunk of the schema the predicate is bound to, e.g. the rows of a
+   * PAX page read by TableHandle::GetChunk. Terms comparing int and float columns run the SIMD kernels of
+   * ColumnKernel over whole columns, the others are evaluated with Scalar on the rows that passed the previous terms
+   * @param chunk
+   * @param bitmap selection bitmap of BITMAP_SIZE(chunk.GetRowCount()) bytes, bit i is set iff row i passes
+   * @return number of rows that pass
+   */
+  auto Filter(const Chunk &chunk, char *bitmap) const -> size_t;
+
+  struct Term;
+  /// keep the rows in sel that satisfy term, returns how many are kept
+  using Kernel = size_t (*)(const Term &term, const RecordView *rows, uint32_t *sel, size_t n);
+  /// write the result of term on the rows of chunk to bitmap, rows not in selected may be skipped and left unset
+  using ChunkKernel = void (*)(const Term &term, const Chunk &chunk, const char *selected, char *bitmap);
+
+  struct Operand
+  {
+    size_t idx_;
+    size_t off_;
+    size_t size_;
+  };
+
+  struct Term
+  {
+    CompOp      op_;
+    Kernel      kernel_;
+    ChunkKernel chunk_kernel_;
+    Operand     lhs_;
+    Operand     rhs_;
+    // constant rhs, already cast to the type of the comparison
+    union
+    {
+      int32_t int_;
+      float   float_;
+      bool    bool_;
+    } rconst_;
+    std::string_view rconst_str_;
+    // constant rhs for the kernels evaluating with Scalar
+    Scalar rscalar_;
+    // IN lists
+    std::vector<Scalar> in_list_;
+    // keeps the memory rconst_str_ and in_list_ reference alive
+    ValueSptr rval_holder_;
+  };
+
+private:
+  std::vector<Term> terms_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_PREDICATE_H
@@ -20,11 +20,15 @@
 //
 
 #include "optimizer.h"
+#include "execution/worker_pool.h"
 namespace wsdb {
 auto Optimizer::Optimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
   plan = LogicalOptimize(plan, db);
-  plan = PhysicalOptimize(plan, db);
+  // the pipelines of exchanges keep their pages pinned while they wait for the reader, half of the buffer pool is
+  // left to the serial parts of the plan
+  auto budget = ParallelBudget{WorkerPool::GetMaxWorkers(), BUFFER_POOL_SIZE / 2};
+  plan        = PhysicalOptimize(plan, db, budget);
   return plan;
 }
 
@@ -39,6 +43,10 @@ auto Optimizer::LogicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHand
   } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
     if (auto scan = std::dynamic_pointer_cast<ScanPlan>(filter->child_)) {
       filter->child_ = LogicalOptimizeScan(scan, filter->conds_, db);
+      // the conditions are pushed down into a sequential scan, the filter is no longer needed
+      if (filter->child_ == scan) {
+        return scan;
+      }
     } else {
       filter->child_ = LogicalOptimize(filter->child_, db);
     }
@@ -48,21 +56,39 @@ auto Optimizer::LogicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHand
     return sort;
   } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
     proj->child_ = LogicalOptimize(proj->child_, db);
-    return proj;
+    return LogicalOptimizeProject(proj, db);
   } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
     join->left_  = LogicalOptimize(join->left_, db);
     join->right_ = LogicalOptimize(join->right_, db);
-    return LogicalOptimizeJoin(join);
+    return LogicalOptimizeJoin(join, db);
   } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
     agg->child_ = LogicalOptimize(agg->child_, db);
     return agg;
   } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
     lim->child_ = LogicalOptimize(lim->child_, db);
-    return lim;
+    return LogicalOptimizeLimit(lim, db);
   }
   return plan;
 }
 
+auto Optimizer::LogicalOptimizeLimit(
+    const std::shared_ptr<LimitPlan> &lim, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
+  // a projection keeps the number and order of rows, so the limit can be taken below it
+  auto proj = std::dynamic_pointer_cast<ProjectPlan>(lim->child_);
+  auto sort = std::dynamic_pointer_cast<SortPlan>(proj == nullptr ? lim->child_ : proj->child_);
+  if (sort == nullptr) {
+    return lim;
+  }
+  auto top_n =
+      std::make_shared<TopNPlan>(std::move(sort->child_), std::move(sort->key_schema_), sort->is_desc_, lim->limit_);
+  if (proj == nullptr) {
+    return top_n;
+  }
+  proj->child_ = top_n;
+  return proj;
+}
+
 auto Optimizer::LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, ConditionVec conds,
     wsdb::DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
@@ -73,20 +99,68 @@ auto Optimizer::LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, Condi
   std::shared_ptr<AbstractPlan> new_scan = scan;
   if (index != nullptr) {
     new_scan = std::make_shared<IdxScanPlan>(scan->table_name_, index->GetIndexId(), index_conds, max_matched_fields);
+  } else {
+    scan->conds_.insert(scan->conds_.end(), conds.begin(), conds.end());
   }
   return new_scan;
 }
 
-auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>
+auto Optimizer::LogicalOptimizeProject(
+    const std::shared_ptr<ProjectPlan> &proj, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
-  if (join->strategy_ == NESTED_LOOP) {
-    return join;
+  // the scan can output the projected fields directly, or the fields projected and sorted on below a sort
+  auto sort = std::dynamic_pointer_cast<SortPlan>(proj->child_);
+  auto scan = std::dynamic_pointer_cast<ScanPlan>(sort == nullptr ? proj->child_ : sort->child_);
+  if (scan == nullptr || !scan->fields_.empty()) {
+    return proj;
   }
-  WSDB_ASSERT(join->strategy_ == SORT_MERGE, "Unknown join strategy");
-  // try to generate SortMergeJoin
+  const auto          &tab_schema = db->GetTable(scan->table_name_)->GetSchema();
+  std::vector<RTField> fields;
+  auto                 add_field = [&fields, &tab_schema](const RTField &field) -> bool {
+    if (field.is_agg_ || tab_schema.GetRTFieldIndex(field) == tab_schema.GetFieldCount()) {
+      return false;
+    }
+    auto dup = std::any_of(fields.begin(), fields.end(), [&field](const RTField &f) { return f.field_ == field.field_; });
+    if (!dup) {
+      fields.push_back(field);
+    }
+    return true;
+  };
+  for (const auto &field : proj->schema_->GetFields()) {
+    if (!add_field(field)) {
+      return proj;
+    }
+  }
+  if (sort != nullptr) {
+    for (const auto &field : sort->key_schema_->GetFields()) {
+      if (!add_field(field)) {
+        return proj;
+      }
+    }
+  }
+  auto is_exact = sort == nullptr && fields.size() == proj->schema_->GetFieldCount();
+  scan->fields_  = std::move(fields);
+  // the scan already outputs exactly the projected fields in order
+  return is_exact ? std::static_pointer_cast<AbstractPlan>(scan) : proj;
+}
+
+auto Optimizer::LogicalOptimizeJoin(
+    std::shared_ptr<JoinPlan> join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
   // check if all conditions are equality comparison
   auto all_eq =
       std::all_of(join->conds_.begin(), join->conds_.end(), [](const auto &cond) { return cond.GetOp() == OP_EQ; });
+  if (join->strategy_ == NESTED_LOOP) {
+    // keys of different types, e.g. int and float, can be equal without hashing to the same value
+    auto same_type = std::all_of(join->conds_.begin(), join->conds_.end(), [](const auto &cond) {
+      return cond.GetLCol().field_.field_type_ == cond.GetRCol().field_.field_type_;
+    });
+    if (join->conds_.empty() || !all_eq || !same_type) {
+      return join;
+    }
+    join->strategy_ = HASH;
+  }
+  WSDB_ASSERT(join->strategy_ == SORT_MERGE || join->strategy_ == HASH, "Unknown join strategy");
   if (!all_eq) {
     join->strategy_ = NESTED_LOOP;
     return join;
@@ -101,6 +175,14 @@ auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shar
     left_key_fields.push_back(cond.GetLCol());
     right_key_fields.push_back(cond.GetRCol());
   }
+  if (join->strategy_ == HASH) {
+    // keep the smaller child in memory, ties build on the right so that rows come out in the order of nested loop
+    join->build_left_       = EstimateRows(join->left_, db) < EstimateRows(join->right_, db);
+    join->left_key_schema_  = std::make_unique<RecordSchema>(left_key_fields);
+    join->right_key_schema_ = std::make_unique<RecordSchema>(right_key_fields);
+    return join;
+  }
+  // try to generate SortMergeJoin
   std::shared_ptr<AbstractPlan> left = std::dynamic_pointer_cast<IdxScanPlan>(join->left_);
   // generate sort plan
   if (left == nullptr) {
@@ -118,12 +200,176 @@ auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shar
   return join;
 }
 
-auto Optimizer::PhysicalOptimize(
-    std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+auto Optimizer::EstimateRows(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t
+{
+  if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    return db->GetTable(scan->table_name_)->GetTableHeader().rec_num_;
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    return db->GetTable(idx_scan->table_name_)->GetTableHeader().rec_num_;
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    return EstimateRows(filter->child_, db);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    return EstimateRows(sort->child_, db);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    return std::min(top_n->limit_, EstimateRows(top_n->child_, db));
+  } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    return EstimateRows(proj->child_, db);
+  } else if (auto mat = std::dynamic_pointer_cast<MaterializePlan>(plan)) {
+    return EstimateRows(mat->child_, db);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    return std::max(EstimateRows(join->left_, db), EstimateRows(join->right_, db));
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    return EstimateRows(agg->child_, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    return std::min(lim->limit_, EstimateRows(lim->child_, db));
+  } else if (auto exchange = std::dynamic_pointer_cast<ExchangePlan>(plan)) {
+    return EstimateRows(exchange->child_, db);
+  }
+  return 0;
+}
+
+auto Optimizer::EstimateRowSize(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t
 {
+  auto record_size = [db](const std::string &table_name) {
+    const auto &schema = db->GetTable(table_name)->GetSchema();
+    return BITMAP_SIZE(schema.GetFieldCount()) + schema.GetRecordLength();
+  };
+  if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    return record_size(scan->table_name_);
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    return record_size(idx_scan->table_name_);
+  } else if (auto mat = std::dynamic_pointer_cast<MaterializePlan>(plan)) {
+    return record_size(mat->table_name_);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    return EstimateRowSize(join->left_, db) + EstimateRowSize(join->right_, db);
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    return EstimateRowSize(filter->child_, db);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    return EstimateRowSize(sort->child_, db);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    return EstimateRowSize(top_n->child_, db);
+  } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    return EstimateRowSize(proj->child_, db);
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    return EstimateRowSize(agg->child_, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    return EstimateRowSize(lim->child_, db);
+  } else if (auto exchange = std::dynamic_pointer_cast<ExchangePlan>(plan)) {
+    return EstimateRowSize(exchange->child_, db);
+  }
+  return 0;
+}
+
+auto Optimizer::PhysicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db, ParallelBudget &budget)
+    -> std::shared_ptr<AbstractPlan>
+{
+  // updates and deletes keep scanning whole records of the table
+  if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    filter->child_ = PhysicalOptimize(filter->child_, db, budget);
+    return PushIntoExchange(filter, filter->child_);
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    sort->child_ = PhysicalOptimize(sort->child_, db, budget);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    top_n->child_ = PhysicalOptimize(top_n->child_, db, budget);
+  } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    proj->child_ = PhysicalOptimize(proj->child_, db, budget);
+    return PushIntoExchange(proj, proj->child_);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    // the probe side of a hash join goes first, its exchange is the one the join can run in
+    auto &first  = join->strategy_ == HASH && join->build_left_ ? join->right_ : join->left_;
+    auto &second = join->strategy_ == HASH && join->build_left_ ? join->left_ : join->right_;
+    first        = PhysicalOptimize(first, db, budget);
+    second       = PhysicalOptimize(second, db, budget);
+    return PhysicalOptimizeParallelJoin(join, db);
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    agg->child_ = PhysicalOptimize(agg->child_, db, budget);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    lim->child_ = PhysicalOptimize(lim->child_, db, budget);
+  } else if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    return PhysicalOptimizeParallel(PhysicalOptimizeScan(scan, db), scan->table_name_, db, budget);
+  }
   return plan;
 }
 
+auto Optimizer::PhysicalOptimizeParallel(std::shared_ptr<AbstractPlan> plan, const std::string &table_name,
+    DatabaseHandle *db, ParallelBudget &budget) -> std::shared_ptr<AbstractPlan>
+{
+  auto page_num = db->GetTable(table_name)->GetTableHeader().page_num_ - FILE_HEADER_PAGE_ID - 1;
+  // every pipeline pins the page it scans and the page it materializes from
+  size_t pinned_pages = std::dynamic_pointer_cast<MaterializePlan>(plan) != nullptr ? 2 : 1;
+  auto   worker_num   = std::min({budget.workers_,
+      budget.pinned_pages_ / pinned_pages,
+      static_cast<size_t>(page_num) / MORSEL_PAGE_NUM});
+  if (worker_num <= 1) {
+    return plan;
+  }
+  budget.workers_ -= worker_num;
+  budget.pinned_pages_ -= worker_num * pinned_pages;
+  return std::make_shared<ExchangePlan>(std::move(plan), table_name, worker_num);
+}
+
+auto Optimizer::PhysicalOptimizeParallelJoin(
+    const std::shared_ptr<JoinPlan> &join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
+  // the unmatched build rows of an outer join that builds on the left are only known once every probe row is read
+  if (join->strategy_ != HASH || (join->type_ == OUTER_JOIN && join->build_left_)) {
+    return join;
+  }
+  auto &probe    = join->build_left_ ? join->right_ : join->left_;
+  auto &build    = join->build_left_ ? join->left_ : join->right_;
+  auto  exchange = std::dynamic_pointer_cast<ExchangePlan>(probe);
+  if (exchange == nullptr) {
+    return join;
+  }
+  // a shared table is never spilled, a row takes its slot, its chain and two buckets of the table
+  auto row_cost = EstimateRowSize(build, db) + 5 * sizeof(size_t);
+  if (EstimateRows(build, db) * row_cost > HASH_JOIN_BUFFER_SIZE) {
+    return join;
+  }
+  probe            = exchange->child_;
+  exchange->child_ = join;
+  return exchange;
+}
+
+auto Optimizer::PushIntoExchange(
+    std::shared_ptr<AbstractPlan> plan, std::shared_ptr<AbstractPlan> &child) -> std::shared_ptr<AbstractPlan>
+{
+  auto exchange = std::dynamic_pointer_cast<ExchangePlan>(child);
+  if (exchange == nullptr) {
+    return plan;
+  }
+  child            = exchange->child_;
+  exchange->child_ = std::move(plan);
+  return exchange;
+}
+
+auto Optimizer::PhysicalOptimizeScan(
+    const std::shared_ptr<ScanPlan> &scan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
+{
+  // NARY pages are filtered in place before anything is copied, PAX pages are copied out column by column, so only
+  // PAX scans gain from reading just the columns of the conditions and fetching the others for the rows that pass
+  auto tab = db->GetTable(scan->table_name_);
+  if (scan->conds_.empty() || tab->GetStorageModel() != StorageModel::PAX_MODEL) {
+    return scan;
+  }
+  const auto &tab_schema = tab->GetSchema();
+  auto        out_fields = scan->fields_.empty() ? tab_schema.GetFields() : scan->fields_;
+  auto        is_cond    = [&scan, &tab_schema](const RTField &field) {
+    auto idx = tab_schema.GetRTFieldIndex(field);
+    return std::any_of(scan->conds_.begin(), scan->conds_.end(), [&tab_schema, idx](const Condition &cond) {
+      return tab_schema.GetRTFieldIndex(cond.GetLCol()) == idx ||
+             (cond.GetRhsType() == kColumn && tab_schema.GetRTFieldIndex(cond.GetRCol()) == idx);
+    });
+  };
+  if (std::all_of(out_fields.begin(), out_fields.end(), is_cond)) {
+    return scan;
+  }
+  std::vector<RTField> cond_fields;
+  std::copy_if(tab_schema.GetFields().begin(), tab_schema.GetFields().end(), std::back_inserter(cond_fields), is_cond);
+  scan->fields_ = std::move(cond_fields);
+  return std::make_shared<MaterializePlan>(scan, scan->table_name_, std::move(out_fields));
+}
+
 auto Optimizer::CanIndexScan(ConditionVec &conds, ConditionVec &index_conds, const std::list<IndexHandle *> &indexes,
     size_t &max_matched_fields) -> IndexHandle *
 {
@@ -34,14 +34,99 @@ public:
   static auto Optimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
 private:
+  /**
+   * workers and pinned pages of the buffer pool shared by all the exchanges of a plan, each parallel scan takes its
+   * workers out of what the scans before it left, so a query never runs more than MAX_WORKERS_PER_QUERY workers and
+   * its exchanges never pin more than half of the buffer pool, whatever the number of tables it scans
+   */
+  struct ParallelBudget
+  {
+    size_t workers_;
+    size_t pinned_pages_;
+  };
+
   static auto LogicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
   static auto LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, ConditionVec conds,
       wsdb::DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
-  static auto LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>;
+  /**
+   * push the fields a projection needs down into the sequential scan below it, possibly through a sort
+   * @param proj
+   * @param db
+   * @return the projection, or the scan itself if it outputs exactly the projected fields
+   */
+  static auto LogicalOptimizeProject(
+      const std::shared_ptr<ProjectPlan> &proj, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * replace a sort under a limit, possibly through a projection, by a top-n that only keeps the first rows
+   * @param lim
+   * @param db
+   * @return the top-n, or the projection over it, or the limit if there is no sort below it
+   */
+  static auto LogicalOptimizeLimit(
+      const std::shared_ptr<LimitPlan> &lim, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * generate the key schemas of sort merge join and hash join, nested loop joins on equal keys are turned into hash
+   * joins that build on the smaller child
+   * @param join
+   * @param db
+   * @return
+   */
+  static auto LogicalOptimizeJoin(
+      std::shared_ptr<JoinPlan> join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /// rough number of rows plan outputs, conditions are assumed to keep all rows
+  static auto EstimateRows(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t;
 
-  static auto PhysicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+  /// bytes of a row plan outputs at most, the fields of the tables are assumed to be kept
+  static auto EstimateRowSize(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t;
+
+  static auto PhysicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db, ParallelBudget &budget)
+      -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * late materialization: a PAX scan with conditions only outputs the fields of the conditions, the other fields are
+   * fetched by a MaterializePlan above it for the rows that pass
+   * @param scan
+   * @param db
+   * @return the scan, or the materialization over it
+   */
+  static auto PhysicalOptimizeScan(
+      const std::shared_ptr<ScanPlan> &scan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * morsel-driven parallel scan: plan, the physical plan of a sequential scan of table_name, is run by the workers of
+   * an exchange if the table has enough pages and the budget has enough workers left for more than one of them
+   * @param plan
+   * @param table_name
+   * @param db
+   * @param budget the workers and pages left to the plan, the exchange takes its share out of it
+   * @return the exchange over plan, or plan itself
+   */
+  static auto PhysicalOptimizeParallel(std::shared_ptr<AbstractPlan> plan, const std::string &table_name,
+      DatabaseHandle *db, ParallelBudget &budget) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * parallel hash join probe: a hash join whose probe side is an exchange is moved into its pipelines, which share
+   * the table built from the build side, if the table is expected to fit in the budget, as it is never spilled
+   * @param join
+   * @param db
+   * @return the exchange over join, or join itself
+   */
+  static auto PhysicalOptimizeParallelJoin(
+      const std::shared_ptr<JoinPlan> &join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * move plan, a filter or a projection, below child if child is an exchange, so that the workers run it
+   * @param plan
+   * @param child the child of plan
+   * @return the exchange, or plan itself
+   */
+  static auto PushIntoExchange(
+      std::shared_ptr<AbstractPlan> plan, std::shared_ptr<AbstractPlan> &child) -> std::shared_ptr<AbstractPlan>;
 
   /**
    * check if there is an index that can be used to scan the table,
@@ -268,11 +268,11 @@ struct GroupBy : public TreeNode
 
 struct InsertStmt : public TreeNode
 {
-  std::string                         tab_name;
-  std::vector<std::shared_ptr<Value>> vals;
+  std::string                                      tab_name;
+  std::vector<std::vector<std::shared_ptr<Value>>> rows;
 
-  InsertStmt(std::string tab_name_, std::vector<std::shared_ptr<Value>> vals_)
-      : tab_name(std::move(tab_name_)), vals(std::move(vals_))
+  InsertStmt(std::string tab_name_, std::vector<std::vector<std::shared_ptr<Value>>> rows_)
+      : tab_name(std::move(tab_name_)), rows(std::move(rows_))
   {}
 };
 
@@ -378,8 +378,9 @@ struct SemValue
 
   std::shared_ptr<Expr> sv_expr;
 
-  std::shared_ptr<Value>              sv_val;
-  std::vector<std::shared_ptr<Value>> sv_vals;
+  std::shared_ptr<Value>                           sv_val;
+  std::vector<std::shared_ptr<Value>>              sv_vals;
+  std::vector<std::vector<std::shared_ptr<Value>>> sv_val_rows;
 
   std::shared_ptr<AggCol>           sv_agg_col;
   std::shared_ptr<Col>              sv_col;
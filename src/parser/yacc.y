@@ -32,7 +32,7 @@ using namespace ast;
 %define parse.error verbose
 
 // keywords
-%token EXPLAIN SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN
+%token EXPLAIN SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN HASH_JOIN
 WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY ENABLE_NESTLOOP ENABLE_SORTMERGE STORAGE PAX NARY LIMIT
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
@@ -55,6 +55,7 @@ WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EX
 %type <sv_expr> expr
 %type <sv_val> value
 %type <sv_vals> valueList
+%type <sv_val_rows> valueRows
 %type <sv_str> tbName colName optAlias
 %type <sv_strs> colNameList
 %type <sv_node_arr> tableList
@@ -187,9 +188,9 @@ optStorageModel:
     ;
 
 dml:
-        INSERT INTO tbName VALUES '(' valueList ')'
+        INSERT INTO tbName VALUES valueRows
     {
-        $$ = std::make_shared<InsertStmt>($3, $6);
+        $$ = std::make_shared<InsertStmt>($3, $5);
     }
     |   DELETE FROM tbName optWhereClause
     {
@@ -268,6 +269,17 @@ type:
     }
     ;
 
+valueRows:
+        '(' valueList ')'
+    {
+        $$ = std::vector<std::vector<std::shared_ptr<Value>>>{$2};
+    }
+    |   valueRows ',' '(' valueList ')'
+    {
+        $$.push_back($4);
+    }
+    ;
+
 valueList:
         value
     {
@@ -355,6 +367,8 @@ optUsingJoinClause:
     {   $$ = NESTED_LOOP;  }
     |   USING SORT_MERGE_JOIN
     {   $$ = SORT_MERGE;}
+    |   USING HASH_JOIN
+    {   $$ = HASH;}
 
 conditionAgg:
         aggCol op value
@@ -116,21 +116,25 @@ class ShowTablesPlan : public AbstractPlan
 class InsertPlan : public AbstractPlan
 {
 public:
-  InsertPlan(std::string table_name, std::vector<ValueSptr> values)
+  InsertPlan(std::string table_name, std::vector<std::vector<ValueSptr>> values)
       : table_name_(std::move(table_name)), values_(std::move(values))
   {}
   auto ToString(int level) const -> std::string override
   {
-    std::string value_str;
-    for (const auto &value : values_) {
-      value_str += value->ToString() + ", ";
+    std::string rows_str;
+    for (const auto &row : values_) {
+      std::string value_str;
+      for (const auto &value : row) {
+        value_str += value->ToString() + ", ";
+      }
+      value_str.back() = ')';
+      rows_str += (rows_str.empty() ? "(" : ", (") + value_str;
     }
-    value_str.back() = ')';
-    value_str        = "(" + value_str;
-    return fmt::format("{}InsertPlan [{}] <{}>", TAB_STR(level), table_name_, value_str);
+    return fmt::format("{}InsertPlan [{}] <{}>", TAB_STR(level), table_name_, rows_str);
   }
-  std::string            table_name_;
-  std::vector<ValueSptr> values_;
+  std::string table_name_;
+  // rows of a multi-row VALUES, inserted as one batch
+  std::vector<std::vector<ValueSptr>> values_;
 };
 
 class UpdatePlan : public AbstractPlan
@@ -195,9 +199,61 @@ public:
   explicit ScanPlan(std::string table_name) : table_name_(std::move(table_name)) {}
   auto ToString(int level) const -> std::string override
   {
-    return fmt::format("{}ScanPlan [{}]", TAB_STR(level), table_name_);
+    std::string cond_str;
+    if (!conds_.empty()) {
+      cond_str += conds_.front().ToString();
+      for (size_t i = 1; i < conds_.size(); i++) {
+        cond_str += " AND " + conds_[i].ToString();
+      }
+    }
+    std::string field_str;
+    for (const auto &field : fields_) {
+      field_str += field_str.empty() ? field.ToString() : ", " + field.ToString();
+    }
+    return fmt::format("{}ScanPlan [{}] <{}> <{}>", TAB_STR(level), table_name_, cond_str, field_str);
   }
   std::string table_name_;
+  // set by the optimizer: conditions evaluated by the scan and the fields it outputs, empty means all fields
+  ConditionVec         conds_;
+  std::vector<RTField> fields_;
+};
+
+class MaterializePlan : public AbstractPlan
+{
+public:
+  MaterializePlan(std::shared_ptr<AbstractPlan> child, std::string table_name, std::vector<RTField> fields)
+      : child_(std::move(child)), table_name_(std::move(table_name)), fields_(std::move(fields))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    std::string field_str;
+    for (const auto &field : fields_) {
+      field_str += field_str.empty() ? field.ToString() : ", " + field.ToString();
+    }
+    return fmt::format(
+        "{}MaterializePlan [{}] <{}>\n{}", TAB_STR(level), table_name_, field_str, child_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> child_;
+  std::string                   table_name_;
+  std::vector<RTField>          fields_;
+};
+
+/// run child over morsels of the pages of table_name_ on worker_num_ workers, child is a scan of table_name_ with
+/// filters, projections and hash joins probed by its rows above it. An aggregation over it is run by the workers too
+class ExchangePlan : public AbstractPlan
+{
+public:
+  ExchangePlan(std::shared_ptr<AbstractPlan> child, std::string table_name, size_t worker_num)
+      : child_(std::move(child)), table_name_(std::move(table_name)), worker_num_(worker_num)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format(
+        "{}ExchangePlan [{}] <{} workers>\n{}", TAB_STR(level), table_name_, worker_num_, child_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> child_;
+  std::string                   table_name_;
+  size_t                        worker_num_;
 };
 
 class IdxScanPlan : public AbstractPlan
@@ -281,9 +337,11 @@ public:
   ConditionVec                  conds_;
   JoinType                      type_;
   JoinStrategy                  strategy_;
-  // below is available when strategy == SortMerge
+  // below is available when strategy == SortMerge or Hash
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  // below is available when strategy == Hash, build the hash table on the left child
+  bool build_left_{false};
 };
 
 class AggregatePlan : public AbstractPlan
@@ -335,6 +393,27 @@ public:
   size_t                        limit_;
 };
 
+/// a LimitPlan over a SortPlan, only the first limit_ rows of the sort are kept
+class TopNPlan : public AbstractPlan
+{
+public:
+  TopNPlan(std::shared_ptr<AbstractPlan> child, RecordSchemaUptr key_schema, bool is_desc, size_t limit)
+      : child_(std::move(child)), key_schema_(std::move(key_schema)), is_desc_(is_desc), limit_(limit)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}TopNPlan <{}> <limit to {}>\n{}",
+        TAB_STR(level),
+        key_schema_->ToString(),
+        limit_,
+        child_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> child_;
+  RecordSchemaUptr              key_schema_;
+  bool                          is_desc_;
+  size_t                        limit_;
+};
+
 }  // namespace wsdb
 
 #endif  // WSDB_PLAN_H
@@ -52,12 +52,16 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   }
   /// insert
   if (const auto ins = std::dynamic_pointer_cast<ast::InsertStmt>(ast)) {
-    std::vector<ValueSptr> values;
-    values.reserve(ins->vals.size());
-    for (const auto &v : ins->vals) {
-      values.push_back(TransformValue(v));
+    std::vector<std::vector<ValueSptr>> rows;
+    rows.reserve(ins->rows.size());
+    for (const auto &row : ins->rows) {
+      auto &values = rows.emplace_back();
+      values.reserve(row.size());
+      for (const auto &v : row) {
+        values.push_back(TransformValue(v));
+      }
     }
-    return std::make_shared<InsertPlan>(ins->tab_name, values);
+    return std::make_shared<InsertPlan>(ins->tab_name, std::move(rows));
   }
   /// update
   if (const auto upd = std::dynamic_pointer_cast<ast::UpdateStmt>(ast)) {
@@ -80,11 +80,30 @@ auto BufferPoolManager::UnpinPage(file_id_t fid, page_id_t pid, bool is_dirty) -
     }
     fid_pid_t key = {fid, pid};
     frame_id_t frameId = page_frame_lookup_[key];
-    frame->SetDirty(is_dirty);
-    replacer_->Unpin(frameId);
+    // a page unpinned with UnpinPageDeferred stays dirty until it is written
+    frame->SetDirty(frame->IsDirty() || is_dirty);
+    // the page may still be pinned by someone else, e.g. a scan and a PageGuard over it
+    if (!frame->InUse()) {
+        replacer_->Unpin(frameId);
+    }
     return true;
 }
 
+auto BufferPoolManager::UnpinPageDeferred(file_id_t fid, page_id_t pid) -> bool
+{
+  std::lock_guard<std::mutex> lock(latch_);
+  auto frame = GetFrame(fid, pid);
+  if (frame == nullptr || !frame->InUse()) {
+    return false;
+  }
+  frame->Unpin();
+  frame->SetDirty(true);
+  if (!frame->InUse()) {
+    replacer_->Unpin(page_frame_lookup_[{fid, pid}]);
+  }
+  return true;
+}
+
 
 auto BufferPoolManager::DeletePage(file_id_t fid, page_id_t pid) -> bool {
 //    WSDB_STUDENT_TODO(l1, t2);
@@ -90,6 +90,15 @@ public:
    */
   auto UnpinPage(file_id_t fid, page_id_t pid, bool is_dirty) -> bool;
 
+  /**
+   * Unpin a page changed in the buffer without writing it to disk, the frame is marked dirty and the page is written
+   * when it is evicted, deleted or flushed, for pages whose loss in a crash is harmless, e.g. those of a free space map
+   * @param fid
+   * @param pid
+   * @return true if the page is unpinned successfully
+   */
+  auto UnpinPageDeferred(file_id_t fid, page_id_t pid) -> bool;
+
   /**
    * Delete the page from the buffer pool
    * 1. grant the latch
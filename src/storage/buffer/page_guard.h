@@ -0,0 +1,94 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/16.
+//
+
+#ifndef WSDB_PAGE_GUARD_H
+#define WSDB_PAGE_GUARD_H
+
+#include "buffer_pool_manager.h"
+
+namespace wsdb {
+
+/**
+ * RAII holder of a pinned page, the page is unpinned when the guard is released, reset or destroyed.
+ * Anything referencing the page memory, e.g. a RecordView, is only valid while the guard holds the page.
+ */
+class PageGuard
+{
+public:
+  PageGuard() = default;
+
+  /**
+   * Take over a page that has already been pinned by FetchPage
+   */
+  PageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page)
+  {}
+
+  ~PageGuard() { Release(); }
+
+  DISABLE_COPY_AND_ASSIGN(PageGuard)
+
+  PageGuard(PageGuard &&other) noexcept
+      : buffer_pool_manager_(other.buffer_pool_manager_), page_(other.page_), is_dirty_(other.is_dirty_)
+  {
+    other.page_ = nullptr;
+  }
+
+  auto operator=(PageGuard &&other) noexcept -> PageGuard &
+  {
+    if (this != &other) {
+      Release();
+      buffer_pool_manager_ = other.buffer_pool_manager_;
+      page_                = other.page_;
+      is_dirty_            = other.is_dirty_;
+      other.page_          = nullptr;
+    }
+    return *this;
+  }
+
+  [[nodiscard]] auto GetPage() const -> Page * { return page_; }
+
+  /// page id of the guarded page, INVALID_PAGE_ID if the guard is empty
+  [[nodiscard]] auto GetPageId() const -> page_id_t { return page_ == nullptr ? INVALID_PAGE_ID : page_->GetPageId(); }
+
+  [[nodiscard]] auto IsEmpty() const -> bool { return page_ == nullptr; }
+
+  void SetDirty() { is_dirty_ = true; }
+
+  /// unpin the page, the guard becomes empty
+  void Release()
+  {
+    if (page_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(page_->GetFileId(), page_->GetPageId(), is_dirty_);
+      page_     = nullptr;
+      is_dirty_ = false;
+    }
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  Page              *page_{nullptr};
+  bool               is_dirty_{false};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_PAGE_GUARD_H
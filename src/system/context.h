@@ -25,6 +25,7 @@
 #include "log/log_manager.h"
 #include "handle/database_handle.h"
 #include "net/net_controller.h"
+#include "common/arena.h"
 
 namespace wsdb {
 struct Context
@@ -34,6 +35,8 @@ struct Context
   DatabaseHandle *db_;
   NetController  *nt_ctl_;
   int             client_fd_;
+  // records and values of the running statement's executor tree, reset once the statement is done
+  Arena           arena_;
 
   Context(Transaction *txn, LogManager *log_manager, DatabaseHandle *db_hdl, NetController *nt_ctl_, int client_fd)
       : txn(txn), log_manager(log_manager), db_(db_hdl), nt_ctl_(nt_ctl_), client_fd_(client_fd)
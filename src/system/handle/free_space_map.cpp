@@ -0,0 +1,132 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/15.
+//
+
+#include "free_space_map.h"
+#include <algorithm>
+#include <thread>
+
+#define FSM_PAGE_ID(pid) (static_cast<page_id_t>((pid) / PAGE_SIZE))
+#define FSM_SLOT_ID(pid) (static_cast<size_t>((pid) % PAGE_SIZE))
+
+namespace wsdb {
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, file_id_t fsm_id, const TableHeader *tab_hdr)
+    : buffer_pool_manager_(buffer_pool_manager), fsm_id_(fsm_id), tab_hdr_(tab_hdr), low_(FILE_HEADER_PAGE_ID + 1)
+{
+  for (auto &hint : hints_) {
+    hint = FILE_HEADER_PAGE_ID + 1;
+  }
+}
+
+auto FreeSpaceMap::FindFreePage(size_t page_num) -> page_id_t
+{
+  auto      end = static_cast<page_id_t>(page_num);
+  page_id_t low;
+  uint64_t  freed;
+  {
+    std::lock_guard<std::mutex> lock(low_latch_);
+    low   = low_;
+    freed = freed_;
+  }
+  if (low >= end) {
+    return INVALID_PAGE_ID;
+  }
+  auto &hint  = GetHint();
+  auto  start = std::clamp(hint.load(std::memory_order_relaxed), low, end);
+  auto  pid   = FindFreePage(start, end);
+  if (pid == INVALID_PAGE_ID) {
+    // wrap around, the pages in [low, pid) are full if a page is found there, and all of them otherwise
+    pid = FindFreePage(low, start);
+    RaiseLow(pid == INVALID_PAGE_ID ? end : pid, freed);
+  }
+  if (pid != INVALID_PAGE_ID) {
+    hint.store(pid, std::memory_order_relaxed);
+  }
+  return pid;
+}
+
+void FreeSpaceMap::Update(page_id_t pid, size_t free_slots)
+{
+  WSDB_ASSERT(pid > FILE_HEADER_PAGE_ID, "invalid data page");
+  auto level    = ToLevel(free_slots);
+  auto fsm_page = buffer_pool_manager_->FetchPage(fsm_id_, FSM_PAGE_ID(pid));
+  // levels of other pages in the same fsm page are read and written concurrently
+  auto slot = std::atomic_ref<uint8_t>(reinterpret_cast<uint8_t *>(fsm_page->GetData())[FSM_SLOT_ID(pid)]);
+  auto old  = slot.load(std::memory_order_relaxed);
+  if (level != 0) {
+    GetHint().store(pid, std::memory_order_relaxed);
+  }
+  if (old == level) {
+    buffer_pool_manager_->UnpinPage(fsm_id_, FSM_PAGE_ID(pid), false);
+    return;
+  }
+  slot.store(level, std::memory_order_relaxed);
+  buffer_pool_manager_->UnpinPageDeferred(fsm_id_, FSM_PAGE_ID(pid));
+  if (old == 0) {
+    std::lock_guard<std::mutex> lock(low_latch_);
+    low_ = std::min(low_, pid);
+    freed_++;
+  }
+}
+
+auto FreeSpaceMap::FindFreePage(page_id_t begin, page_id_t end) -> page_id_t
+{
+  auto pid = begin;
+  while (pid < end) {
+    auto fsm_pid  = FSM_PAGE_ID(pid);
+    auto fsm_page = buffer_pool_manager_->FetchPage(fsm_id_, fsm_pid);
+    auto levels   = reinterpret_cast<uint8_t *>(fsm_page->GetData());
+    // scan until the end of this fsm page or the end of the range
+    auto fsm_end = std::min(end, static_cast<page_id_t>((fsm_pid + 1) * PAGE_SIZE));
+    for (; pid < fsm_end; ++pid) {
+      if (std::atomic_ref<uint8_t>(levels[FSM_SLOT_ID(pid)]).load(std::memory_order_relaxed) != 0) {
+        buffer_pool_manager_->UnpinPage(fsm_id_, fsm_pid, false);
+        return pid;
+      }
+    }
+    buffer_pool_manager_->UnpinPage(fsm_id_, fsm_pid, false);
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::RaiseLow(page_id_t pid, uint64_t freed)
+{
+  std::lock_guard<std::mutex> lock(low_latch_);
+  if (freed_ == freed) {
+    low_ = std::max(low_, pid);
+  }
+}
+
+auto FreeSpaceMap::GetHint() -> std::atomic<page_id_t> &
+{
+  return hints_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % FSM_HINT_NUM];
+}
+
+auto FreeSpaceMap::ToLevel(size_t free_slots) const -> uint8_t
+{
+  if (free_slots == 0) {
+    return 0;
+  }
+  // round up so that a page with any free slot never maps to level 0
+  return static_cast<uint8_t>((free_slots * UINT8_MAX + tab_hdr_->rec_per_page_ - 1) / tab_hdr_->rec_per_page_);
+}
+
+}  // namespace wsdb
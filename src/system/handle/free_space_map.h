@@ -0,0 +1,104 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/15.
+//
+
+#ifndef WSDB_FREE_SPACE_MAP_H
+#define WSDB_FREE_SPACE_MAP_H
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include "common/meta.h"
+#include "common/page.h"
+#include "storage/buffer/buffer_pool_manager.h"
+
+namespace wsdb {
+
+/**
+ * Free space map of a table, stored in a separate file (table_name.fsm) next to the table file.
+ * Each data page of the table owns one byte in the map recording its fill level, 0 means the page is full,
+ * any other value means the page has at least one free slot, the larger the value the more free slots.
+ * | fsm page 0: level of data page 0 ... PAGE_SIZE - 1 | fsm page 1: level of data page PAGE_SIZE ... |
+ * The map is only a hint, inserters should double-check the bitmap of the page they get. Its pages are written back
+ * when they are evicted or the table is closed, not on every change, so a crash may leave stale levels behind.
+ * Searches skip the pages below a low-water mark, which are known to be full, and start from the page the thread last
+ * found free slots in, so filling a table does not scan its full pages again for every insert.
+ */
+class FreeSpaceMap
+{
+public:
+  FreeSpaceMap() = delete;
+
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, file_id_t fsm_id, const TableHeader *tab_hdr);
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(FreeSpaceMap)
+
+  /**
+   * Find a data page that has at least one free slot
+   * the search starts from the hint of the calling thread and wraps around to the low-water mark, a search from the
+   * mark raises it over the full pages it passed
+   * @param page_num number of pages of the table, which may be growing concurrently
+   * @return page id, or INVALID_PAGE_ID if all data pages are full
+   */
+  auto FindFreePage(size_t page_num) -> page_id_t;
+
+  /**
+   * Record the number of free slots of a data page, the caller should hold the latch of the page
+   * a page with free slots becomes the hint of the calling thread, and lowers the low-water mark if it was full
+   * @param pid
+   * @param free_slots
+   */
+  void Update(page_id_t pid, size_t free_slots);
+
+  [[nodiscard]] auto GetFileId() const -> file_id_t { return fsm_id_; }
+
+private:
+  /**
+   * Search data pages in [begin, end) for a page with free slots
+   * @return page id, or INVALID_PAGE_ID if not found
+   */
+  auto FindFreePage(page_id_t begin, page_id_t end) -> page_id_t;
+
+  [[nodiscard]] auto ToLevel(size_t free_slots) const -> uint8_t;
+
+  /// raise the low-water mark to pid, unless a page got free slots since freed_ was read as freed
+  void RaiseLow(page_id_t pid, uint64_t freed);
+
+  /// hint of the calling thread
+  auto GetHint() -> std::atomic<page_id_t> &;
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  file_id_t          fsm_id_;
+  const TableHeader *tab_hdr_;
+
+  // every data page below low_ is full, freed_ counts the pages that got free slots after being full
+  std::mutex low_latch_;
+  page_id_t  low_;
+  uint64_t   freed_{0};
+  // page the threads of each hash of the thread id last found free slots in
+  std::array<std::atomic<page_id_t>, FSM_HINT_NUM> hints_;
+};
+
+DEFINE_UNIQUE_PTR(FreeSpaceMap);
+
+}  // namespace wsdb
+
+#endif  // WSDB_FREE_SPACE_MAP_H
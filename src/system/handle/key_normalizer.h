@@ -0,0 +1,165 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/23.
+//
+
+#ifndef WSDB_KEY_NORMALIZER_H
+#define WSDB_KEY_NORMALIZER_H
+
+#include <bit>
+#include <cstring>
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * Encode the key fields of a record into a fixed-size byte string whose memcmp order is the order of RecordComparator
+ * (or its inverse for descending keys), so that sorting and index lookups compare keys without any per-field dispatch.
+ *
+ * Every key field takes 1 + field_size bytes:
+ *   - a null byte, 0x00 for null and 0x01 otherwise, so that nulls come first, followed by
+ *   - int: big-endian with the sign bit flipped
+ *   - float: big-endian IEEE bits, sign bit flipped for positive numbers and all bits flipped for negative ones
+ *   - bool: one byte
+ *   - string: the bytes up to the first '\0', padded with '\0' to the field size, e.g. "ab" < "ab\1" < "abc"
+ * Descending keys invert every byte of the encoding, nulls come last then.
+ */
+class KeyNormalizer
+{
+public:
+  KeyNormalizer() = default;
+
+  /**
+   * @param key_schema fields to encode
+   * @param schema schema of the records to encode, key_schema == schema encodes key records directly
+   * @param is_desc invert the order of the encoded keys
+   */
+  KeyNormalizer(const RecordSchema *key_schema, const RecordSchema *schema, bool is_desc = false) : is_desc_(is_desc)
+  {
+    fields_.reserve(key_schema->GetFieldCount());
+    for (size_t i = 0; i < key_schema->GetFieldCount(); ++i) {
+      auto idx = schema->GetRTFieldIndex(key_schema->GetFieldAt(i));
+      if (idx == schema->GetFieldCount()) {
+        WSDB_FETAL("Key field not found in record schema");
+      }
+      auto &field = schema->GetFieldAt(idx).field_;
+      WSDB_ASSERT(field.field_type_ == FieldType::TYPE_STRING || field.field_type_ == FieldType::TYPE_BOOL ||
+                      field.field_size_ == 4,
+          "numeric key fields should be 4 bytes");
+      fields_.push_back({idx, schema->GetFieldOffset(idx), field.field_size_, field.field_type_});
+      key_size_ += 1 + field.field_size_;
+    }
+  }
+
+  /// size of an encoded key
+  [[nodiscard]] auto GetKeySize() const -> size_t { return key_size_; }
+
+  /**
+   * Encode the key of rec
+   * @param rec
+   * @param out at least GetKeySize() bytes
+   */
+  void Encode(const RecordView &rec, char *out) const
+  {
+    auto *dst = reinterpret_cast<uint8_t *>(out);
+    for (const auto &f : fields_) {
+      if (rec.IsNull(f.idx_)) {
+        std::memset(dst, 0, 1 + f.size_);
+        dst += 1 + f.size_;
+        continue;
+      }
+      *dst++   = 1;
+      auto src = rec.GetData() + f.off_;
+      switch (f.type_) {
+        case FieldType::TYPE_BOOL:
+          std::memset(dst, 0, f.size_);
+          *dst = *reinterpret_cast<const bool *>(src) ? 1 : 0;
+          break;
+        case FieldType::TYPE_INT: {
+          int32_t v;
+          std::memcpy(&v, src, sizeof(v));
+          StoreBigEndian(static_cast<uint32_t>(v) ^ 0x80000000U, dst);
+          break;
+        }
+        case FieldType::TYPE_FLOAT: {
+          float v;
+          std::memcpy(&v, src, sizeof(v));
+          // -0.0 == 0.0, they must share an encoding
+          auto bits = v == 0.0F ? 0U : std::bit_cast<uint32_t>(v);
+          StoreBigEndian((bits & 0x80000000U) != 0 ? ~bits : bits ^ 0x80000000U, dst);
+          break;
+        }
+        case FieldType::TYPE_STRING: {
+          auto len = strnlen(src, f.size_);
+          std::memcpy(dst, src, len);
+          std::memset(dst + len, 0, f.size_ - len);
+          break;
+        }
+        default: WSDB_FETAL("Unsupported field type to normalize");
+      }
+      dst += f.size_;
+    }
+    if (is_desc_) {
+      for (auto *p = reinterpret_cast<uint8_t *>(out); p != dst; ++p) {
+        *p = ~*p;
+      }
+    }
+  }
+
+  /// the first 8 bytes of an encoded key as an integer with the same order, padded with 0 for shorter keys
+  [[nodiscard]] auto Prefix(const char *key) const -> uint64_t
+  {
+    uint64_t prefix = 0;
+    std::memcpy(&prefix, key, std::min(key_size_, sizeof(prefix)));
+    if constexpr (std::endian::native == std::endian::little) {
+      prefix = __builtin_bswap64(prefix);
+    }
+    return prefix;
+  }
+
+  [[nodiscard]] auto Compare(const char *lkey, const char *rkey) const -> int
+  {
+    return std::memcmp(lkey, rkey, key_size_);
+  }
+
+private:
+  static void StoreBigEndian(uint32_t v, uint8_t *dst)
+  {
+    if constexpr (std::endian::native == std::endian::little) {
+      v = __builtin_bswap32(v);
+    }
+    std::memcpy(dst, &v, sizeof(v));
+  }
+
+  struct KeyField
+  {
+    size_t    idx_;
+    size_t    off_;
+    size_t    size_;
+    FieldType type_;
+  };
+
+  std::vector<KeyField> fields_;
+  size_t                key_size_{0};
+  bool                  is_desc_{false};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_KEY_NORMALIZER_H
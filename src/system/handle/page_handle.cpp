@@ -35,6 +35,17 @@ void PageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *dat
 }
 
 void PageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
+auto PageHandle::ViewSlot(size_t slot_id, char *buf) -> const char *
+{
+  ReadSlot(slot_id, buf, buf + tab_hdr_->nullmap_size_);
+  return buf;
+}
+
+auto PageHandle::ViewField(size_t slot_id, const RecordSchema *schema, size_t field_idx, bool *is_null) -> const char *
+{
+  WSDB_THROW(WSDB_EXCEPTION_EMPTY, "");
+}
+
 auto PageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
 
 NAryPageHandle::NAryPageHandle(const TableHeader *tab_hdr, Page *page)
@@ -61,6 +72,22 @@ void NAryPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
   memcpy(data, slots_mem_ + slot_id * rec_full_size + tab_hdr_->nullmap_size_, tab_hdr_->rec_size_);
 }
 
+auto NAryPageHandle::ViewSlot(size_t slot_id, char *buf) -> const char *
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+  // null map and data are stored next to each other, so the slot can be viewed in place
+  return slots_mem_ + slot_id * (tab_hdr_->nullmap_size_ + tab_hdr_->rec_size_);
+}
+
+auto NAryPageHandle::ViewField(
+    size_t slot_id, const RecordSchema *schema, size_t field_idx, bool *is_null) -> const char *
+{
+  auto slot = ViewSlot(slot_id, nullptr);
+  *is_null  = BitMap::GetBit(slot, field_idx);
+  return slot + tab_hdr_->nullmap_size_ + schema->GetFieldOffset(field_idx);
+}
+
 PAXPageHandle::PAXPageHandle(
     const TableHeader *tab_hdr, Page *page, const RecordSchema *schema, const std::vector<size_t> &offsets)
     : PageHandle(tab_hdr, page, page->GetData() + PAGE_HEADER_SIZE,
@@ -79,17 +106,74 @@ PAXPageHandle::~PAXPageHandle() = default;
 // | field_m_1, field_m_2, ... , field_m_n |
 void PAXPageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update)
 {
-  WSDB_STUDENT_TODO(l1, f2);
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == update, fmt::format("update: {}", update));
+  memcpy(slots_mem_ + slot_id * tab_hdr_->nullmap_size_, null_map, tab_hdr_->nullmap_size_);
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto field_size = schema_->GetFieldAt(i).field_.field_size_;
+    memcpy(slots_mem_ + offsets_[i] + slot_id * field_size, data + schema_->GetFieldOffset(i), field_size);
+  }
 }
 
-void PAXPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { WSDB_STUDENT_TODO(l1, f2); }
+void PAXPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+  memcpy(null_map, slots_mem_ + slot_id * tab_hdr_->nullmap_size_, tab_hdr_->nullmap_size_);
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto field_size = schema_->GetFieldAt(i).field_.field_size_;
+    memcpy(data + schema_->GetFieldOffset(i), slots_mem_ + offsets_[i] + slot_id * field_size, field_size);
+  }
+}
+
+auto PAXPageHandle::ViewField(
+    size_t slot_id, const RecordSchema *schema, size_t field_idx, bool *is_null) -> const char *
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+  *is_null = BitMap::GetBit(slots_mem_ + slot_id * tab_hdr_->nullmap_size_, field_idx);
+  return slots_mem_ + offsets_[field_idx] + slot_id * schema->GetFieldAt(field_idx).field_.field_size_;
+}
 
 auto PAXPageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr
 {
-  std::vector<ArrayValueSptr> col_arrs;
-  col_arrs.reserve(chunk_schema->GetFieldCount());
-  // read data each field and construct ArrayValue
-  WSDB_STUDENT_TODO(l1, f2);
-  return std::make_unique<Chunk>(chunk_schema, std::move(col_arrs));
+  // 1. collect the occupied slots as runs of consecutive slot ids, a full page is a single run
+  std::vector<std::pair<size_t, size_t>> runs;
+  std::vector<RID>                       rids;
+  rids.reserve(page_->GetRecordNum());
+  for (size_t slot = 0; slot < tab_hdr_->rec_per_page_; ++slot) {
+    if (!BitMap::GetBit(bitmap_, slot)) {
+      continue;
+    }
+    if (!runs.empty() && runs.back().first + runs.back().second == slot) {
+      runs.back().second++;
+    } else {
+      runs.emplace_back(slot, 1);
+    }
+    rids.emplace_back(page_->GetPageId(), slot);
+  }
+  // 2. copy each run of a column region with a single memcpy, null bits are gathered from the slot null maps
+  std::vector<ColumnVector> cols;
+  cols.reserve(chunk_schema->GetFieldCount());
+  for (const auto &field : chunk_schema->GetFields()) {
+    auto field_idx = schema_->GetRTFieldIndex(field);
+    WSDB_ASSERT(field_idx < schema_->GetFieldCount(), fmt::format("field {} not in table", field.field_.field_name_));
+    auto  field_size = field.field_.field_size_;
+    auto  region     = slots_mem_ + offsets_[field_idx];
+    auto &col        = cols.emplace_back(field, rids.size());
+    auto  out        = col.GetRawData();
+    for (const auto &[start, len] : runs) {
+      memcpy(out, region + start * field_size, len * field_size);
+      out += len * field_size;
+    }
+    for (size_t row = 0; row < rids.size(); ++row) {
+      auto null_map = slots_mem_ + rids[row].SlotID() * tab_hdr_->nullmap_size_;
+      if (BitMap::GetBit(null_map, field_idx)) {
+        BitMap::SetBit(col.GetNullMap(), row, true);
+      }
+    }
+    col.SetSize(rids.size());
+  }
+  return std::make_unique<Chunk>(chunk_schema, std::move(cols), std::move(rids));
 }
 }  // namespace wsdb
@@ -45,6 +45,24 @@ public:
 
   virtual void ReadSlot(size_t slot_id, char *null_map, char *data);
 
+  /**
+   * Get the memory of a slot without copying when possible, the null map is followed by the data
+   * @param slot_id
+   * @param buf used when the slot is not stored contiguously in the page, at least nullmap_size_ + rec_size_ bytes
+   * @return pointer to the null map of the slot, either inside the page or buf
+   */
+  virtual auto ViewSlot(size_t slot_id, char *buf) -> const char *;
+
+  /**
+   * Get the memory of a single field of a slot without copying, the other fields are not touched
+   * @param slot_id
+   * @param schema schema of the table
+   * @param field_idx index of the field in schema
+   * @param is_null set to the null bit of the field
+   * @return pointer to the value of the field inside the page
+   */
+  virtual auto ViewField(size_t slot_id, const RecordSchema *schema, size_t field_idx, bool *is_null) -> const char *;
+
   virtual auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr;
 
   virtual ~PageHandle() = default;
@@ -70,6 +88,10 @@ public:
   void WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update) override;
 
   void ReadSlot(size_t slot_id, char *null_map, char *data) override;
+
+  auto ViewSlot(size_t slot_id, char *buf) -> const char * override;
+
+  auto ViewField(size_t slot_id, const RecordSchema *schema, size_t field_idx, bool *is_null) -> const char * override;
 };
 
 /**
@@ -96,6 +118,8 @@ public:
 
   void ReadSlot(size_t slot_id, char *null_map, char *data) override;
 
+  auto ViewField(size_t slot_id, const RecordSchema *schema, size_t field_idx, bool *is_null) -> const char * override;
+
   auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr override;
 
 private:
@@ -0,0 +1,262 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/22.
+//
+
+#ifndef WSDB_RECORD_COMPARATOR_H
+#define WSDB_RECORD_COMPARATOR_H
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include "record_handle.h"
+
+namespace wsdb {
+
+namespace detail {
+
+/// compare two fields in place, returns negative, 0 or positive like memcmp
+using FieldCmpFn = int (*)(const char *lhs, size_t lsize, const char *rhs, size_t rsize);
+
+using FieldHashFn = size_t (*)(const char *mem, size_t size);
+
+template <typename T>
+inline auto LoadField(const char *mem) -> T
+{
+  // fields are packed without padding, avoid unaligned dereference
+  T value;
+  std::memcpy(&value, mem, sizeof(T));
+  return value;
+}
+
+/// numeric fields, int and float are compared as float when the types differ like ValueFactory::AlignTypes
+template <typename L, typename R>
+inline auto CompareNumeric(const char *lhs, size_t, const char *rhs, size_t) -> int
+{
+  using C = std::conditional_t<std::is_same_v<L, R>, L, float>;
+  auto l  = static_cast<C>(LoadField<L>(lhs));
+  auto r  = static_cast<C>(LoadField<R>(rhs));
+  return (l > r) - (l < r);
+}
+
+/// strings are cut at the first '\0' like StringValue
+inline auto CompareString(const char *lhs, size_t lsize, const char *rhs, size_t rsize) -> int
+{
+  auto cmp = std::string_view(lhs, strnlen(lhs, lsize)).compare(std::string_view(rhs, strnlen(rhs, rsize)));
+  return (cmp > 0) - (cmp < 0);
+}
+
+template <typename T>
+inline auto HashNumeric(const char *mem, size_t) -> size_t
+{
+  return std::hash<T>{}(LoadField<T>(mem));
+}
+
+inline auto HashString(const char *mem, size_t size) -> size_t
+{
+  return std::hash<std::string_view>{}(std::string_view(mem, strnlen(mem, size)));
+}
+
+inline auto SelectCmpFn(FieldType ltype, FieldType rtype) -> FieldCmpFn
+{
+  if (ltype == FieldType::TYPE_INT && rtype == FieldType::TYPE_FLOAT) {
+    return CompareNumeric<int32_t, float>;
+  }
+  if (ltype == FieldType::TYPE_FLOAT && rtype == FieldType::TYPE_INT) {
+    return CompareNumeric<float, int32_t>;
+  }
+  if (ltype != rtype) {
+    WSDB_THROW(WSDB_TYPE_MISSMATCH,
+        fmt::format("Type mismatch: {} != {}", FieldTypeToString(ltype), FieldTypeToString(rtype)));
+  }
+  switch (ltype) {
+    case FieldType::TYPE_BOOL: return CompareNumeric<bool, bool>;
+    case FieldType::TYPE_INT: return CompareNumeric<int32_t, int32_t>;
+    case FieldType::TYPE_FLOAT: return CompareNumeric<float, float>;
+    case FieldType::TYPE_STRING: return CompareString;
+    default: WSDB_FETAL("Unsupported field type to compare");
+  }
+}
+
+inline auto SelectHashFn(FieldType type) -> FieldHashFn
+{
+  switch (type) {
+    case FieldType::TYPE_BOOL: return HashNumeric<bool>;
+    case FieldType::TYPE_INT: return HashNumeric<int32_t>;
+    case FieldType::TYPE_FLOAT: return HashNumeric<float>;
+    case FieldType::TYPE_STRING: return HashString;
+    default: WSDB_FETAL("Unsupported field type to hash");
+  }
+}
+
+/// position of a key field inside the records being compared
+inline auto KeyFieldIndex(const RecordSchema *key_schema, size_t key_idx, const RecordSchema *schema) -> size_t
+{
+  auto idx = schema->GetRTFieldIndex(key_schema->GetFieldAt(key_idx));
+  if (idx == schema->GetFieldCount()) {
+    WSDB_FETAL("Key field not found in record schema");
+  }
+  return idx;
+}
+
+}  // namespace detail
+
+/**
+ * Compare records on key fields in place, without building key records or values. The comparator is compiled once
+ * for a key schema and the schemas of the compared records: key fields are resolved to offsets and a comparison
+ * function specialized for their types. Nulls are equal to each other and smaller than anything else like
+ * Record::Compare.
+ */
+class RecordComparator
+{
+public:
+  RecordComparator() = default;
+
+  /**
+   * compare records of schema on the fields of key_schema, key_schema == schema compares key records directly
+   * @param key_schema
+   * @param schema
+   */
+  RecordComparator(const RecordSchema *key_schema, const RecordSchema *schema)
+      : RecordComparator(key_schema, schema, key_schema, schema)
+  {}
+
+  /**
+   * compare records of two different schemas, e.g. both sides of a join, key fields are paired by position
+   * @param lkey_schema key fields of the left records
+   * @param lschema schema of the left records
+   * @param rkey_schema key fields of the right records, same field count as lkey_schema
+   * @param rschema schema of the right records
+   */
+  RecordComparator(const RecordSchema *lkey_schema, const RecordSchema *lschema, const RecordSchema *rkey_schema,
+      const RecordSchema *rschema)
+  {
+    WSDB_ASSERT(lkey_schema->GetFieldCount() == rkey_schema->GetFieldCount(), "key field count mismatch");
+    fields_.reserve(lkey_schema->GetFieldCount());
+    for (size_t i = 0; i < lkey_schema->GetFieldCount(); ++i) {
+      auto  lidx   = detail::KeyFieldIndex(lkey_schema, i, lschema);
+      auto  ridx   = detail::KeyFieldIndex(rkey_schema, i, rschema);
+      auto &lfield = lschema->GetFieldAt(lidx).field_;
+      auto &rfield = rschema->GetFieldAt(ridx).field_;
+      fields_.push_back({lidx,
+          ridx,
+          lschema->GetFieldOffset(lidx),
+          rschema->GetFieldOffset(ridx),
+          lfield.field_size_,
+          rfield.field_size_,
+          detail::SelectCmpFn(lfield.field_type_, rfield.field_type_)});
+    }
+  }
+
+  [[nodiscard]] auto Compare(const RecordView &lhs, const RecordView &rhs) const -> int
+  {
+    for (const auto &f : fields_) {
+      auto lnull = lhs.IsNull(f.lidx_);
+      auto rnull = rhs.IsNull(f.ridx_);
+      if (lnull || rnull) {
+        if (lnull && rnull) {
+          continue;
+        }
+        return lnull ? -1 : 1;
+      }
+      if (auto cmp = f.cmp_(lhs.GetData() + f.loff_, f.lsize_, rhs.GetData() + f.roff_, f.rsize_); cmp != 0) {
+        return cmp;
+      }
+    }
+    return 0;
+  }
+
+  [[nodiscard]] auto Equal(const RecordView &lhs, const RecordView &rhs) const -> bool { return Compare(lhs, rhs) == 0; }
+
+private:
+  struct KeyField
+  {
+    size_t             lidx_;
+    size_t             ridx_;
+    size_t             loff_;
+    size_t             roff_;
+    size_t             lsize_;
+    size_t             rsize_;
+    detail::FieldCmpFn cmp_;
+  };
+
+  std::vector<KeyField> fields_;
+};
+
+/**
+ * Hash records on key fields in place, compiled once per key schema like RecordComparator. Records that are equal
+ * under RecordComparator have the same hash, the hash does not depend on the position of the key fields in the record.
+ */
+class RecordHasher
+{
+public:
+  RecordHasher() = default;
+
+  RecordHasher(const RecordSchema *key_schema, const RecordSchema *schema)
+  {
+    fields_.reserve(key_schema->GetFieldCount());
+    for (size_t i = 0; i < key_schema->GetFieldCount(); ++i) {
+      auto  idx   = detail::KeyFieldIndex(key_schema, i, schema);
+      auto &field = schema->GetFieldAt(idx).field_;
+      fields_.push_back({idx, schema->GetFieldOffset(idx), field.field_size_, detail::SelectHashFn(field.field_type_)});
+    }
+  }
+
+  [[nodiscard]] auto Hash(const RecordView &rec) const -> size_t
+  {
+    size_t hash = 0;
+    for (const auto &f : fields_) {
+      // nulls hash to a constant so that they fall into the same group
+      auto h = rec.IsNull(f.idx_) ? 0 : f.hash_(rec.GetData() + f.off_, f.size_);
+      hash ^= h + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+  }
+
+  auto operator()(const RecordView &rec) const -> size_t { return Hash(rec); }
+
+private:
+  struct KeyField
+  {
+    size_t              idx_;
+    size_t              off_;
+    size_t              size_;
+    detail::FieldHashFn hash_;
+  };
+
+  std::vector<KeyField> fields_;
+};
+
+/// equality functor over a RecordComparator for hash containers
+class RecordEqual
+{
+public:
+  RecordEqual() = default;
+
+  explicit RecordEqual(RecordComparator cmp) : cmp_(std::move(cmp)) {}
+
+  auto operator()(const RecordView &lhs, const RecordView &rhs) const -> bool { return cmp_.Equal(lhs, rhs); }
+
+private:
+  RecordComparator cmp_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_RECORD_COMPARATOR_H
@@ -20,6 +20,7 @@
 //
 
 #include "record_handle.h"
+#include <algorithm>
 #include <cstring>
 #include <utility>
 
@@ -99,8 +100,7 @@ auto RecordSchema::HasField(table_id_t tid, const std::string &name) -> bool
 
 Record::Record(const RecordSchema *schema, const char *null_map_mem, const char *data, RID rid) : schema_(schema)
 {
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocMem();
   std::memcpy(data_, data, schema_->GetRecordLength());
   std::memcpy(nullmap_, null_map_mem, BITMAP_SIZE(schema_->GetFieldCount()));
   rid_ = rid;
@@ -109,8 +109,7 @@ Record::Record(const RecordSchema *schema, const char *null_map_mem, const char
 Record::Record(const RecordSchema *schema, const std::vector<ValueSptr> &values, wsdb::RID rid)
 {
   schema_  = schema;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocMem();
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
   size_t cursor = 0;
@@ -175,28 +174,29 @@ Record::Record(const RecordSchema *schema, const std::vector<ValueSptr> &values,
   rid_ = rid;
 }
 
-Record::Record(const RecordSchema *schema, const Record &other) : schema_(schema)
+Record::Record(const RecordSchema *schema, const RecordView &other) : schema_(schema)
 {
-  // new can deal with GetRecordLength() == 0
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocMem();
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
   for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
     auto &field     = schema_->GetFieldAt(i);
-    auto  other_idx = other.schema_->GetRTFieldIndex(field);
-    if (other_idx == other.schema_->GetFieldCount()) {
+    auto  other_idx = other.GetSchema()->GetRTFieldIndex(field);
+    if (other_idx == other.GetSchema()->GetFieldCount()) {
       WSDB_FETAL("Field not found in other record");
     }
-    auto other_offset = other.schema_->offsets_[other_idx];
-    std::memcpy(data_ + schema_->offsets_[i], other.data_ + other_offset, field.field_.field_size_);
-    if (BitMap::GetBit(other.nullmap_, other_idx)) {
+    std::memcpy(data_ + schema_->offsets_[i], other.GetFieldData(other_idx), field.field_.field_size_);
+    if (other.IsNull(other_idx)) {
       BitMap::SetBit(nullmap_, i, true);
     }
   }
   rid_ = INVALID_RID;
 }
 
+Record::Record(const RecordView &view)
+    : Record(view.GetSchema(), view.GetNullMap(), view.GetData(), view.GetRID())
+{}
+
 Record::Record(const RecordSchema *schema, const wsdb::Record &rec1, const wsdb::Record &rec2)
 {
   // do some simple asserts
@@ -205,8 +205,7 @@ Record::Record(const RecordSchema *schema, const wsdb::Record &rec1, const wsdb:
   WSDB_ASSERT(schema->GetRecordLength() == rec1.schema_->GetRecordLength() + rec2.schema_->GetRecordLength(),
       "Record length mismatch");
   schema_  = schema;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocMem();
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
   memcpy(data_, rec1.data_, rec1.schema_->GetRecordLength());
@@ -228,26 +227,18 @@ Record::Record(const RecordSchema *schema, const wsdb::Record &rec1, const wsdb:
 Record::Record(const wsdb::RecordSchema *schema)
 {
   schema_  = schema;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocMem();
   // set nullmap to all 1
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0xff, BITMAP_SIZE(schema_->GetFieldCount()));
   rid_ = INVALID_RID;
 }
 
-Record::~Record()
-{
-  delete[] data_;
-  delete[] nullmap_;
-}
+Record::~Record() { FreeMem(); }
 
-Record::Record(const Record &record)
-    : schema_(record.schema_),
-      data_(new char[schema_->GetRecordLength()]),
-      nullmap_(new char[BITMAP_SIZE(schema_->GetFieldCount())]),
-      rid_(record.rid_)
+Record::Record(const Record &record) : schema_(record.schema_), rid_(record.rid_)
 {
+  AllocMem();
   std::memcpy(data_, record.data_, schema_->GetRecordLength());
   std::memcpy(nullmap_, record.nullmap_, BITMAP_SIZE(schema_->GetFieldCount()));
 }
@@ -257,9 +248,9 @@ Record &Record::operator=(const Record &record)
   if (this == &record) {
     return *this;
   }
-  schema_  = record.schema_;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  FreeMem();
+  schema_ = record.schema_;
+  AllocMem();
   std::memcpy(data_, record.data_, schema_->GetRecordLength());
   std::memcpy(nullmap_, record.nullmap_, BITMAP_SIZE(schema_->GetFieldCount()));
   rid_ = record.rid_;
@@ -267,7 +258,11 @@ Record &Record::operator=(const Record &record)
 }
 
 Record::Record(Record &&record) noexcept
-    : schema_(record.schema_), data_(record.data_), nullmap_(record.nullmap_), rid_(record.rid_)
+    : schema_(record.schema_),
+      data_(record.data_),
+      nullmap_(record.nullmap_),
+      in_arena_(record.in_arena_),
+      rid_(record.rid_)
 {
   record.data_    = nullptr;
   record.schema_  = nullptr;
@@ -279,11 +274,11 @@ Record &Record::operator=(Record &&record) noexcept
   if (this == &record) {
     return *this;
   }
-  delete[] data_;
-  delete[] nullmap_;
+  FreeMem();
   schema_         = record.schema_;
   data_           = record.data_;
   nullmap_        = record.nullmap_;
+  in_arena_       = record.in_arena_;
   rid_            = record.rid_;
   record.data_    = nullptr;
   record.schema_  = nullptr;
@@ -291,6 +286,31 @@ Record &Record::operator=(Record &&record) noexcept
   return *this;
 }
 
+void Record::AllocMem()
+{
+  // data and null map share one allocation, data goes first to keep it aligned
+  auto size = schema_->GetRecordLength() + BITMAP_SIZE(schema_->GetFieldCount());
+  if (auto *arena = Arena::Current(); arena != nullptr) {
+    data_     = arena->Allocate(size);
+    in_arena_ = true;
+  } else {
+    // new can deal with size == 0
+    data_     = new char[size];
+    in_arena_ = false;
+  }
+  nullmap_ = data_ + schema_->GetRecordLength();
+}
+
+void Record::FreeMem()
+{
+  // memory from the arena is released together with the arena
+  if (!in_arena_) {
+    delete[] data_;
+  }
+  data_    = nullptr;
+  nullmap_ = nullptr;
+}
+
 auto Record::operator==(const Record &other) const -> bool
 {
   // check if the two record is defined under the same schema and whether their data are matched，
@@ -338,34 +358,57 @@ auto Record::GetValueAt(size_t index) const -> ValueSptr
       field.field_.field_type_, data_ + schema_->offsets_[index], field.field_.field_size_);
 }
 
+auto Record::GetScalarAt(size_t index) const -> Scalar { return RecordView(*this).GetScalarAt(index); }
+
+auto RecordView::GetValueAt(size_t index) const -> ValueSptr
+{
+  WSDB_ASSERT(index < schema_->GetFieldCount(), "Index out of range");
+  auto &field = schema_->GetFieldAt(index);
+  if (IsNull(index)) {
+    return ValueFactory::CreateNullValue(field.field_.field_type_);
+  }
+  return ValueFactory::CreateValue(field.field_.field_type_, GetFieldData(index), field.field_.field_size_);
+}
+
 auto Record::Compare(const wsdb::Record &lrec, const wsdb::Record &rrec) -> int
 {
   // compare two records,
   //  WSDB_ASSERT(Record, Compare, lrec.GetSchema() == rrec.GetSchema(), "Schema mismatch");
   // more loose assert to support two similar records
   WSDB_ASSERT(lrec.GetSchema()->GetFieldCount() == rrec.GetSchema()->GetFieldCount(), "field count mismatch");
+  RecordView lview(lrec);
+  RecordView rview(rrec);
   for (size_t i = 0; i < lrec.GetSchema()->GetFieldCount(); ++i) {
-    auto lval = lrec.GetValueAt(i);
-    auto rval = rrec.GetValueAt(i);
-    if (lval->IsNull() && rval->IsNull()) {
+    auto lval = lview.GetScalarAt(i);
+    auto rval = rview.GetScalarAt(i);
+    if (lval.IsNull() && rval.IsNull()) {
       continue;
     }
-    if (lval->IsNull() || rval->IsNull()) {
-      return lval->IsNull() ? -1 : 1;
+    if (lval.IsNull() || rval.IsNull()) {
+      return lval.IsNull() ? -1 : 1;
     }
-    if (*lval < *rval) {
-      return -1;
-    }
-    if (*lval > *rval) {
-      return 1;
+    if (auto cmp = Scalar::Compare(lval, rval); cmp != 0) {
+      return cmp < 0 ? -1 : 1;
     }
   }
   return 0;
 }
 
-Chunk::Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols) : schema_(schema), cols_(std::move(cols))
+ColumnVector::ColumnVector(const RTField &field, size_t capacity)
+    : type_(field.field_.field_type_),
+      width_(field.field_.field_size_),
+      capacity_(capacity),
+      data_(capacity * width_),
+      nullmap_(BITMAP_SIZE(capacity))
+{}
+
+Chunk::Chunk(const RecordSchema *schema, std::vector<ColumnVector> cols, std::vector<RID> rids)
+    : schema_(schema), cols_(std::move(cols)), rids_(std::move(rids))
 {
   WSDB_ASSERT(schema_->GetFieldCount() == cols_.size(), "Field count mismatch");
+  WSDB_ASSERT(std::all_of(cols_.begin(), cols_.end(), [this](const ColumnVector &col) {
+    return col.GetSize() == rids_.size();
+  }), "Row count mismatch");
 }
 
 Chunk::~Chunk() = default;
@@ -378,7 +421,14 @@ Chunk &Chunk::operator=(const wsdb::Chunk &chunk) = default;
 
 Chunk &Chunk::operator=(wsdb::Chunk &&chunk) noexcept = default;
 
-auto Chunk::GetCol(int index) -> ArrayValueSptr { return cols_[index]; }
+auto Chunk::GetCol(int index) -> ArrayValueSptr
+{
+  auto arr = ValueFactory::CreateArrayValue();
+  for (size_t i = 0; i < cols_[index].GetSize(); ++i) {
+    arr->Append(cols_[index].GetValueAt(i));
+  }
+  return arr;
+}
 
 auto Chunk::GetColCount() -> size_t { return cols_.size(); }
 }  // namespace wsdb
\ No newline at end of file
@@ -26,11 +26,13 @@
 #include "common/meta.h"
 #include "common/rid.h"
 #include "common/value.h"
+#include "common/scalar.h"
 #include "common/bitmap.h"
 
 namespace wsdb {
 
 class Record;
+class RecordView;
 class Chunk;
 class RecordSchema;
 DEFINE_UNIQUE_PTR(Record);
@@ -41,6 +43,7 @@ DEFINE_UNIQUE_PTR(Chunk);
 class RecordSchema
 {
   friend Record;
+  friend RecordView;
 
 public:
   RecordSchema() = delete;
@@ -99,7 +102,9 @@ private:
 
 /**
  * To prevent unexpected changes to a record, Record class is non-volatile (except rid),
- * if a record-like object is volatile, use RecordSchema + std::vector<ValueSptr> instead
+ * if a record-like object is volatile, use RecordSchema + std::vector<ValueSptr> instead.
+ * The null map and data are allocated from the arena installed on the calling thread if there is one (see ArenaScope),
+ * such a record must be destroyed before the arena is reset, otherwise they are allocated from the heap
  */
 class Record
 {
@@ -126,9 +131,15 @@ public:
   /**
    * Generate a record from another record given the requested schema
    * @param schema should be a subset of the original schema
-   * @param other the original record
+   * @param other the original record, a Record converts to its view implicitly
    */
-  Record(const RecordSchema *schema, const Record &other);
+  Record(const RecordSchema *schema, const RecordView &other);
+
+  /**
+   * Materialize a record view, the null map and data are copied out of the memory referenced by the view
+   * @param view
+   */
+  explicit Record(const RecordView &view);
 
   /**
    * Generate a record from two records given the requested schema
@@ -165,6 +176,9 @@ public:
 
   [[nodiscard]] auto GetValueAt(size_t index) const -> ValueSptr;
 
+  /// Get the field at index without allocating, strings reference the record's memory
+  [[nodiscard]] auto GetScalarAt(size_t index) const -> Scalar;
+
   /// Get the schema of this record
   [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
 
@@ -174,19 +188,145 @@ public:
 
   static auto Compare(const Record &lrec, const Record &rrec) -> int;
 
+private:
+  /// allocate data_ and nullmap_ for schema_, contents are uninitialized
+  void AllocMem();
+
+  void FreeMem();
+
 private:
   const RecordSchema *schema_;
-  char               *data_;
-  char               *nullmap_;
+  char               *data_{nullptr};
+  char               *nullmap_{nullptr};
+  bool                in_arena_{false};
+  RID                 rid_{};
+};
+
+/**
+ * Read-only view of a record whose null map and data live somewhere else, e.g. inside a page pinned by a PageGuard or
+ * a buffer owned by an executor. Views are cheap to copy and never own memory, so a view is only valid as long as the
+ * memory it references, materialize it with Record(view) if the record should outlive that.
+ */
+class RecordView
+{
+public:
+  RecordView() = default;
+
+  RecordView(const RecordSchema *schema, const char *null_map_mem, const char *data, RID rid)
+      : schema_(schema), nullmap_(null_map_mem), data_(data), rid_(rid)
+  {}
+
+  // NOLINTNEXTLINE: implicit conversion so that APIs taking views accept records as well
+  RecordView(const Record &record)
+      : schema_(record.GetSchema()), nullmap_(record.GetNullMap()), data_(record.GetData()), rid_(record.GetRID())
+  {}
+
+  /// whether the view references a record
+  [[nodiscard]] auto IsValid() const -> bool { return schema_ != nullptr; }
+
+  [[nodiscard]] auto GetRID() const -> RID { return rid_; }
+
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  [[nodiscard]] auto GetData() const -> const char * { return data_; }
+
+  [[nodiscard]] auto GetNullMap() const -> const char * { return nullmap_; }
+
+  [[nodiscard]] auto IsNull(size_t index) const -> bool { return BitMap::GetBit(nullmap_, index); }
+
+  /// raw bytes of the field at index, the layout is the same as in Record
+  [[nodiscard]] auto GetFieldData(size_t index) const -> const char * { return data_ + schema_->offsets_[index]; }
+
+  [[nodiscard]] auto GetValueAt(size_t index) const -> ValueSptr;
+
+  /// Get the field at index without allocating, strings reference the viewed memory
+  [[nodiscard]] auto GetScalarAt(size_t index) const -> Scalar
+  {
+    auto &field = schema_->fields_[index].field_;
+    if (IsNull(index)) {
+      return Scalar::Null(field.field_type_);
+    }
+    return Scalar::FromMem(field.field_type_, GetFieldData(index), field.field_size_);
+  }
+
+private:
+  const RecordSchema *schema_{nullptr};
+  const char         *nullmap_{nullptr};
+  const char         *data_{nullptr};
   RID                 rid_{};
 };
 
+/**
+ * A column of fixed width values stored back to back, the memory is int32_t[] for int fields, float[] for float fields
+ * and char[width] for string fields, so it can be scanned as a plain array. The null map has one bit per row, a set bit
+ * means the row is null, the same as the null map of a record.
+ */
+class ColumnVector
+{
+public:
+  ColumnVector() = delete;
+
+  ColumnVector(const RTField &field, size_t capacity);
+
+  [[nodiscard]] auto GetType() const -> FieldType { return type_; }
+
+  /// width of a value in bytes
+  [[nodiscard]] auto GetWidth() const -> size_t { return width_; }
+
+  [[nodiscard]] auto GetSize() const -> size_t { return size_; }
+
+  [[nodiscard]] auto GetCapacity() const -> size_t { return capacity_; }
+
+  void SetSize(size_t size)
+  {
+    WSDB_ASSERT(size <= capacity_, "size exceeds capacity");
+    size_ = size;
+  }
+
+  /// typed access to the values, T should be int32_t for int columns, float for float columns and char for strings
+  template <typename T>
+  [[nodiscard]] auto GetData() const -> const T *
+  {
+    WSDB_ASSERT(type_ == TYPE_STRING || sizeof(T) == width_, "type width mismatch");
+    return reinterpret_cast<const T *>(data_.data());
+  }
+
+  [[nodiscard]] auto GetRawData() -> char * { return data_.data(); }
+
+  [[nodiscard]] auto GetNullMap() const -> const char * { return nullmap_.data(); }
+
+  [[nodiscard]] auto GetNullMap() -> char * { return nullmap_.data(); }
+
+  [[nodiscard]] auto IsNull(size_t row) const -> bool { return BitMap::GetBit(nullmap_.data(), row); }
+
+  [[nodiscard]] auto GetFieldData(size_t row) const -> const char * { return data_.data() + row * width_; }
+
+  [[nodiscard]] auto GetScalarAt(size_t row) const -> Scalar
+  {
+    return IsNull(row) ? Scalar::Null(type_) : Scalar::FromMem(type_, GetFieldData(row), width_);
+  }
+
+  [[nodiscard]] auto GetValueAt(size_t row) const -> ValueSptr { return GetScalarAt(row).ToValue(); }
+
+private:
+  FieldType         type_;
+  size_t            width_;
+  size_t            size_{0};
+  size_t            capacity_;
+  std::vector<char> data_;
+  std::vector<char> nullmap_;
+};
+
+/**
+ * A batch of rows stored column by column, cols_[i] holds the values of the i-th field in schema_ and rids_[j] is
+ * where the j-th row comes from.
+ */
 class Chunk
 {
 public:
   Chunk() = delete;
 
-  Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols);
+  Chunk(const RecordSchema *schema, std::vector<ColumnVector> cols, std::vector<RID> rids);
 
   ~Chunk();
 
@@ -198,13 +338,23 @@ public:
 
   Chunk &operator=(Chunk &&chunk) noexcept;
 
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  [[nodiscard]] auto GetColumn(size_t index) const -> const ColumnVector & { return cols_[index]; }
+
+  [[nodiscard]] auto GetRowCount() const -> size_t { return rids_.size(); }
+
+  [[nodiscard]] auto GetRID(size_t row) const -> RID { return rids_[row]; }
+
+  /// materialize a column as values, prefer GetColumn on hot paths
   auto GetCol(int index) -> ArrayValueSptr;
 
   auto GetColCount() -> size_t;
 
 private:
-  const RecordSchema         *schema_;
-  std::vector<ArrayValueSptr> cols_;
+  const RecordSchema       *schema_;
+  std::vector<ColumnVector> cols_;
+  std::vector<RID>          rids_;
 };
 
 }  // namespace wsdb
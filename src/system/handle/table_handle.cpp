@@ -23,11 +23,12 @@
 namespace wsdb {
 
 TableHandle::TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t table_id,
-    TableHeader &hdr, RecordSchemaUptr &schema, StorageModel storage_model)
+    file_id_t fsm_id, TableHeader &hdr, RecordSchemaUptr &schema, StorageModel storage_model)
     : tab_hdr_(hdr),
       table_id_(table_id),
       disk_manager_(disk_manager),
       buffer_pool_manager_(buffer_pool_manager),
+      fsm_(buffer_pool_manager, fsm_id, &tab_hdr_),
       schema_(std::move(schema)),
       storage_model_(storage_model)
 {
@@ -35,10 +36,10 @@ TableHandle::TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_po
   schema_->SetTableId(table_id_);
   if (storage_model_ == PAX_MODEL) {
     field_offset_.resize(schema_->GetFieldCount());
-    // calculate offsets of fields
-//    WSDB_STUDENT_TODO(l1, f2);
+    // calculate offsets of fields, the null maps of all slots come first, followed by one region per field that holds
+    // the field of every slot, so the region of field i starts after rec_per_page_ copies of the fields before it
     for (size_t i = 0; i < schema_->GetFieldCount(); i++) {
-      field_offset_[i] = schema_->GetFieldOffset(i);
+      field_offset_[i] = tab_hdr_.rec_per_page_ * (tab_hdr_.nullmap_size_ + schema_->GetFieldOffset(i));
     }
   }
 }
@@ -66,34 +67,98 @@ auto TableHandle::GetRecord(const RID &rid) -> RecordUptr
 
 }
 
-auto TableHandle::GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr {
-//    WSDB_STUDENT_TODO(l1, f2);
-    auto page_handle =FetchPageHandle(pid);
-    return page_handle->ReadChunk(chunk_schema);
+auto TableHandle::GetRecordView(const RID &rid, PageGuard &guard, char *buf) -> RecordView
+{
+  if (guard.GetPageId() != rid.PageID()) {
+    guard = PageGuard(buffer_pool_manager_, buffer_pool_manager_->FetchPage(table_id_, rid.PageID()));
+  }
+  // page handles are cheap to build on the stack, avoid the allocation in WrapPageHandle for every record
+  auto view_slot = [&rid, buf](PageHandle &&page_handle) -> const char * {
+    if (!BitMap::GetBit(page_handle.GetBitmap(), rid.SlotID())) {
+      WSDB_THROW(WSDB_RECORD_MISS, fmt::format("Record: {}", rid.SlotID()));
+    }
+    return page_handle.ViewSlot(rid.SlotID(), buf);
+  };
+  const char *slot = nullptr;
+  switch (storage_model_) {
+    case StorageModel::NARY_MODEL: slot = view_slot(NAryPageHandle(&tab_hdr_, guard.GetPage())); break;
+    case StorageModel::PAX_MODEL:
+      slot = view_slot(PAXPageHandle(&tab_hdr_, guard.GetPage(), schema_.get(), field_offset_));
+      break;
+    default: WSDB_FETAL("Unknown storage model");
+  }
+  return {schema_.get(), slot, slot + tab_hdr_.nullmap_size_, rid};
+}
+
+void TableHandle::ViewPage(page_id_t pid, PageGuard &guard, std::vector<RecordView> &views)
+{
+  WSDB_ASSERT(storage_model_ == NARY_MODEL, "only nary pages can be viewed in place");
+  if (guard.GetPageId() != pid) {
+    guard = PageGuard(buffer_pool_manager_, buffer_pool_manager_->FetchPage(table_id_, pid));
+  }
+  auto page_handle = NAryPageHandle(&tab_hdr_, guard.GetPage());
+  auto bitmap      = page_handle.GetBitmap();
+  for (auto slot = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, true); slot < tab_hdr_.rec_per_page_;
+       slot      = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot + 1, true)) {
+    auto mem = page_handle.ViewSlot(slot, nullptr);
+    views.emplace_back(schema_.get(), mem, mem + tab_hdr_.nullmap_size_, RID(pid, static_cast<slot_id_t>(slot)));
+  }
+}
+
+void TableHandle::ReadFields(const RID &rid, PageGuard &guard, const std::vector<std::pair<size_t, size_t>> &fields,
+    const RecordSchema *slot_schema, char *slot)
+{
+  if (guard.GetPageId() != rid.PageID()) {
+    guard = PageGuard(buffer_pool_manager_, buffer_pool_manager_->FetchPage(table_id_, rid.PageID()));
+  }
+  auto read_fields = [&](PageHandle &&page_handle) {
+    if (!BitMap::GetBit(page_handle.GetBitmap(), rid.SlotID())) {
+      WSDB_THROW(WSDB_RECORD_MISS, fmt::format("Record: {}", rid.SlotID()));
+    }
+    auto data = slot + BITMAP_SIZE(slot_schema->GetFieldCount());
+    for (const auto &[src, dst] : fields) {
+      bool is_null = false;
+      auto mem     = page_handle.ViewField(rid.SlotID(), schema_.get(), src, &is_null);
+      BitMap::SetBit(slot, dst, is_null);
+      memcpy(data + slot_schema->GetFieldOffset(dst), mem, slot_schema->GetFieldAt(dst).field_.field_size_);
+    }
+  };
+  switch (storage_model_) {
+    case StorageModel::NARY_MODEL: read_fields(NAryPageHandle(&tab_hdr_, guard.GetPage())); break;
+    case StorageModel::PAX_MODEL:
+      read_fields(PAXPageHandle(&tab_hdr_, guard.GetPage(), schema_.get(), field_offset_));
+      break;
+    default: WSDB_FETAL("Unknown storage model");
+  }
+}
+
+auto TableHandle::GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr
+{
+  WSDB_ASSERT(storage_model_ == PAX_MODEL, "chunks can only be read from pax tables");
+  auto guard = PageGuard(buffer_pool_manager_, buffer_pool_manager_->FetchPage(table_id_, pid));
+  return PAXPageHandle(&tab_hdr_, guard.GetPage(), schema_.get(), field_offset_).ReadChunk(chunk_schema);
 }
 
 auto TableHandle::InsertRecord(const Record &record) -> RID {
 //    WSDB_STUDENT_TODO(l1, t3);
-  auto page_handle = CreatePageHandle();
+  std::unique_lock<std::mutex> latch;
+  auto page_handle = CreatePageHandle(latch);
+  auto page_id     = page_handle->GetPage()->GetPageId();
 //通过页的位掩码来查找空闲位置。
 auto bitmap = page_handle->GetBitmap();
   auto slot_id =BitMap::FindFirst(bitmap,tab_hdr_.rec_per_page_,0,false);
     assert(slot_id!=tab_hdr_.rec_per_page_);
-  tab_hdr_.rec_num_++;
+  AddRecordNum(1);
   page_handle->GetPage()->SetRecordNum(page_handle->GetPage()->GetRecordNum()+1);
   //第3个参数表示是不是更新，因为我们是插入，那里原来是没有值的，所以这里是false
   page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
 //  4. update the bitmap and the number of records in the page header
     BitMap::SetBit(page_handle->GetBitmap(),slot_id,true);
-//    5. if the page is full after inserting the record, update the first free page id in the file header and set the
-//     next page id of the current page
-  if(page_handle->GetPage()->GetRecordNum()==tab_hdr_.rec_per_page_){
-      tab_hdr_.first_free_page_=page_handle->GetPage()->GetNextFreePageId();
+//    5. record the remaining free slots of the page in the free space map
+  fsm_.Update(page_id, tab_hdr_.rec_per_page_ - page_handle->GetPage()->GetRecordNum());
+    buffer_pool_manager_->UnpinPage(table_id_,page_id,true);
 
-  }
-    buffer_pool_manager_->UnpinPage(table_id_,page_handle->GetPage()->GetPageId(),true);
-
-    return RID(page_handle->GetPage()->GetPageId(),slot_id);
+    return RID(page_id,slot_id);
 }
 
 
@@ -102,8 +167,8 @@ void TableHandle::InsertRecord(const RID &rid, const Record &record)
   if (rid.PageID() == INVALID_PAGE_ID) {
     WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Page: {}", rid.PageID()));
   }
-  buffer_pool_manager_->UnpinPage(table_id_,rid.PageID(),false);
   auto page_handle = FetchPageHandle(rid.PageID());
+  std::lock_guard<std::mutex> latch(PageLatch(rid.PageID()));
 //    * 2. fetch the page handle and check the bitmap, if the slot is not empty, throw WSDB_RECORD_EXISTS
   if(BitMap::GetBit(page_handle->GetBitmap(),rid.SlotID())){
       buffer_pool_manager_->UnpinPage(table_id_,rid.PageID(),false);
@@ -114,20 +179,48 @@ void TableHandle::InsertRecord(const RID &rid, const Record &record)
   page_handle->WriteSlot(rid.SlotID(), record.GetNullMap(), record.GetData(), false);
 //    * 4. update the bitmap and the number of records in the page header
   BitMap::SetBit(page_handle->GetBitmap(),rid.SlotID(),true);
-//    * 5. if the page is full after inserting the record, update the first free page id in the file header and set the
-//     next page id of the current page
-  if(page_handle->GetPage()->GetNextFreePageId()==tab_hdr_.rec_per_page_){
-      page_handle->GetPage()->SetNextFreePageId(tab_hdr_.first_free_page_);
-      tab_hdr_.first_free_page_=page_handle->GetPage()->GetPageId();
-  }
+  AddRecordNum(1);
+  page_handle->GetPage()->SetRecordNum(page_handle->GetPage()->GetRecordNum() + 1);
+//    * 5. record the remaining free slots of the page in the free space map
+  fsm_.Update(rid.PageID(), tab_hdr_.rec_per_page_ - page_handle->GetPage()->GetRecordNum());
   buffer_pool_manager_->UnpinPage(table_id_,rid.PageID(),true);
 
 //    WSDB_STUDENT_TODO(l1, t3);
 }
 
+auto TableHandle::InsertRecords(std::span<const Record> records) -> std::vector<RID>
+{
+  std::vector<RID> rids;
+  rids.reserve(records.size());
+  size_t cursor = 0;
+  while (cursor < records.size()) {
+    std::unique_lock<std::mutex> latch;
+    auto                         page_handle = CreatePageHandle(latch);
+    auto                         page        = page_handle->GetPage();
+    auto bitmap      = page_handle->GetBitmap();
+    auto rec_num     = page->GetRecordNum();
+    auto slot_id     = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, false);
+    WSDB_ASSERT(slot_id != tab_hdr_.rec_per_page_, "page from free list is full");
+    while (cursor < records.size() && slot_id != tab_hdr_.rec_per_page_) {
+      const auto &record = records[cursor++];
+      page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
+      BitMap::SetBit(bitmap, slot_id, true);
+      rids.emplace_back(page->GetPageId(), static_cast<slot_id_t>(slot_id));
+      rec_num++;
+      slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot_id + 1, false);
+    }
+    AddRecordNum(static_cast<int64_t>(rec_num - page->GetRecordNum()));
+    page->SetRecordNum(rec_num);
+    fsm_.Update(page->GetPageId(), tab_hdr_.rec_per_page_ - rec_num);
+    buffer_pool_manager_->UnpinPage(table_id_, page->GetPageId(), true);
+  }
+  return rids;
+}
+
 void TableHandle::DeleteRecord(const RID &rid) {
 //    * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
   auto page_handle =FetchPageHandle(rid.PageID());
+  std::lock_guard<std::mutex> latch(PageLatch(rid.PageID()));
   if(!BitMap::GetBit(page_handle->GetBitmap(),rid.SlotID())){
       buffer_pool_manager_->UnpinPage(table_id_,rid.PageID(),false);
       WSDB_THROW(WSDB_RECORD_MISS,fmt::format("Record: {}",rid.SlotID()));
@@ -135,13 +228,10 @@ void TableHandle::DeleteRecord(const RID &rid) {
 //    * 2. update the bitmap and the number of records in the page header
     BitMap::SetBit(page_handle->GetBitmap(),rid.SlotID(),false);
   page_handle->GetPage()->SetRecordNum(page_handle->GetPage()->GetRecordNum()-1);
+  AddRecordNum(-1);
 
-//    * 3. if the page is not full after deleting the record, update the first free page id in the file header and the next
-//    * page id in the page header
-  if(page_handle->GetPage()->GetRecordNum()==tab_hdr_.rec_per_page_-1){
-      page_handle->GetPage()->SetNextFreePageId(tab_hdr_.first_free_page_);
-      tab_hdr_.first_free_page_=page_handle->GetPage()->GetPageId();
-  }
+//    * 3. record the remaining free slots of the page in the free space map
+  fsm_.Update(rid.PageID(), tab_hdr_.rec_per_page_ - page_handle->GetPage()->GetRecordNum());
   buffer_pool_manager_->UnpinPage(table_id_,rid.PageID(),true);
 //    WSDB_STUDENT_TODO(l1, t3);
 }
@@ -150,6 +240,7 @@ void TableHandle::UpdateRecord(const RID &rid, const Record &record) {
 //    WSDB_STUDENT_TODO(l1, t3);
 //   * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
   auto page_handle =FetchPageHandle(rid.PageID());
+  std::lock_guard<std::mutex> latch(PageLatch(rid.PageID()));
   if(!BitMap::GetBit(page_handle->GetBitmap(),rid.SlotID())){
       buffer_pool_manager_->UnpinPage(table_id_,rid.PageID(),false);
       WSDB_THROW(WSDB_RECORD_MISS,fmt::format("Record: {}",rid.SlotID()));
@@ -165,26 +256,55 @@ auto TableHandle::FetchPageHandle(page_id_t page_id) -> PageHandleUptr
   return WrapPageHandle(page);
 }
 
-auto TableHandle::CreatePageHandle() -> PageHandleUptr
+auto TableHandle::CreatePageHandle(std::unique_lock<std::mutex> &latch) -> PageHandleUptr
 {
-  if (tab_hdr_.first_free_page_ == INVALID_PAGE_ID) {
-    return CreateNewPageHandle();
+  for (auto pid = fsm_.FindFreePage(GetPageNum()); pid != INVALID_PAGE_ID;
+       pid      = fsm_.FindFreePage(GetPageNum())) {
+    auto pg_hdl = FetchPageHandle(pid);
+    latch       = std::unique_lock<std::mutex>(PageLatch(pid));
+    // the free space map is only a hint, the page may have been filled by others
+    if (BitMap::FindFirst(pg_hdl->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) != tab_hdr_.rec_per_page_) {
+      return pg_hdl;
+    }
+    fsm_.Update(pid, 0);
+    latch.unlock();
+    buffer_pool_manager_->UnpinPage(table_id_, pid, false);
   }
-  auto page = buffer_pool_manager_->FetchPage(table_id_, tab_hdr_.first_free_page_);
-  return WrapPageHandle(page);
+  return CreateNewPageHandle(latch);
 }
 
-auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
+auto TableHandle::CreateNewPageHandle(std::unique_lock<std::mutex> &latch) -> PageHandleUptr
 {
-  auto page_id = static_cast<page_id_t>(tab_hdr_.page_num_);
-  tab_hdr_.page_num_++;
+  page_id_t page_id;
+  {
+    std::lock_guard<std::mutex> lock(hdr_latch_);
+    page_id = static_cast<page_id_t>(tab_hdr_.page_num_++);
+  }
   auto page   = buffer_pool_manager_->FetchPage(table_id_, page_id);
   auto pg_hdl = WrapPageHandle(page);
-  page->SetNextFreePageId(tab_hdr_.first_free_page_);
-  tab_hdr_.first_free_page_ = page_id;
+  // the page is not in the free space map yet, so no one else can take its slots before the latch is locked
+  latch = std::unique_lock<std::mutex>(PageLatch(page_id));
+  fsm_.Update(page_id, tab_hdr_.rec_per_page_);
   return pg_hdl;
 }
 
+auto TableHandle::PageLatch(page_id_t pid) -> std::mutex &
+{
+  return page_latches_[static_cast<size_t>(pid) % TABLE_PAGE_LATCH_NUM];
+}
+
+auto TableHandle::GetPageNum() -> size_t
+{
+  std::lock_guard<std::mutex> lock(hdr_latch_);
+  return tab_hdr_.page_num_;
+}
+
+void TableHandle::AddRecordNum(int64_t delta)
+{
+  std::lock_guard<std::mutex> lock(hdr_latch_);
+  tab_hdr_.rec_num_ = static_cast<size_t>(static_cast<int64_t>(tab_hdr_.rec_num_) + delta);
+}
+
 auto TableHandle::WrapPageHandle(Page *page) -> PageHandleUptr
 {
   switch (storage_model_) {
@@ -196,6 +316,8 @@ auto TableHandle::WrapPageHandle(Page *page) -> PageHandleUptr
 
 auto TableHandle::GetTableId() const -> table_id_t { return table_id_; }
 
+auto TableHandle::GetFsmId() const -> file_id_t { return fsm_.GetFileId(); }
+
 auto TableHandle::GetTableHeader() const -> const TableHeader & { return tab_hdr_; }
 
 auto TableHandle::GetSchema() const -> const RecordSchema & { return *schema_; }
@@ -243,9 +365,45 @@ auto TableHandle::GetNextRID(const RID &rid) -> RID
   return INVALID_RID;
 }
 
+auto TableHandle::GetNextRID(const RID &rid, PageGuard &guard) -> RID
+{
+  auto page_id = rid.PageID();
+  auto slot_id = static_cast<size_t>(rid.SlotID()) + 1;
+  while (page_id < static_cast<page_id_t>(tab_hdr_.page_num_)) {
+    if (guard.GetPageId() != page_id) {
+      guard = PageGuard(buffer_pool_manager_, buffer_pool_manager_->FetchPage(table_id_, page_id));
+    }
+    // the bitmap is at the same place for all storage models
+    auto bitmap = guard.GetPage()->GetData() + PAGE_HEADER_SIZE;
+    slot_id     = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot_id, true);
+    if (slot_id != tab_hdr_.rec_per_page_) {
+      return {page_id, static_cast<slot_id_t>(slot_id)};
+    }
+    page_id++;
+    slot_id = 0;
+  }
+  return INVALID_RID;
+}
+
 auto TableHandle::HasField(const std::string &field_name) const -> bool
 {
   return schema_->HasField(table_id_, field_name);
 }
 
+void TableHandle::RebuildFreeSpaceMap()
+{
+  tab_hdr_.rec_num_ = 0;
+  for (auto pid = FILE_HEADER_PAGE_ID + 1; pid < static_cast<page_id_t>(tab_hdr_.page_num_); ++pid) {
+    auto   page_handle = FetchPageHandle(pid);
+    size_t rec_num     = 0;
+    for (size_t slot_id = 0; slot_id < tab_hdr_.rec_per_page_; ++slot_id) {
+      rec_num += BitMap::GetBit(page_handle->GetBitmap(), slot_id) ? 1 : 0;
+    }
+    page_handle->GetPage()->SetRecordNum(rec_num);
+    tab_hdr_.rec_num_ += rec_num;
+    fsm_.Update(pid, tab_hdr_.rec_per_page_ - rec_num);
+    buffer_pool_manager_->UnpinPage(table_id_, pid, true);
+  }
+}
+
 }  // namespace wsdb
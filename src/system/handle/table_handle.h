@@ -21,25 +21,33 @@
 
 #ifndef WSDB_TABLE_HANDLE_H
 #define WSDB_TABLE_HANDLE_H
+#include <array>
+#include <mutex>
+#include <span>
 #include <utility>
 
 #include "../../../common/micro.h"
 #include "common/page.h"
 #include "storage/storage.h"
 #include "page_handle.h"
+#include "free_space_map.h"
+#include "storage/buffer/page_guard.h"
 
 namespace wsdb {
 
 /**
  * Table descriptor in memory, including the column schema of the table
+ * Records can be inserted, deleted and updated by concurrent sessions: the slots of a page are claimed and released
+ * under the latch of the page, and the page and record numbers of the table header under a latch of their own. The
+ * pages are not latched for readers.
  */
 class TableHandle
 {
 public:
   TableHandle() = delete;
 
-  TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t table_id, TableHeader &hdr,
-      RecordSchemaUptr &schema, StorageModel storage_model);
+  TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t table_id,
+      file_id_t fsm_id, TableHeader &hdr, RecordSchemaUptr &schema, StorageModel storage_model);
 
   /**
    * Get a record by rid
@@ -52,6 +60,43 @@ public:
    */
   auto GetRecord(const RID &rid) -> RecordUptr;
 
+  /**
+   * Get a read-only view of a record by rid without copying it out of the page
+   * 1. if guard does not hold the page of rid, fetch the page and let guard hold it, the old page is unpinned
+   * 2. check if there is a record in the slot using bitmap, if not, throw WSDB_RECORD_MISS
+   * 3. view the slot using page handle, NARY slots are viewed in place, PAX slots are gathered into buf
+   * @param rid
+   * @param guard keeps the page pinned as long as the view is used, reuse it across calls to save pins
+   * @param buf at least nullmap_size_ + rec_size_ bytes, only touched for PAX tables
+   * @return view valid while guard holds the page and buf is alive
+   */
+  auto GetRecordView(const RID &rid, PageGuard &guard, char *buf) -> RecordView;
+
+  /**
+   * View all records of a NARY page in slot order without copying them
+   * 1. if guard does not hold page pid, fetch the page and let guard hold it, the old page is unpinned
+   * 2. append a view of every occupied slot to views
+   * @param pid
+   * @param guard keeps the page pinned as long as the views are used
+   * @param views
+   */
+  void ViewPage(page_id_t pid, PageGuard &guard, std::vector<RecordView> &views);
+
+  /**
+   * Copy some fields of a record out of its page, the other fields are not touched, so that a PAX slot does not have to
+   * be gathered when only a few of its columns are needed
+   * 1. if guard does not hold the page of rid, fetch the page and let guard hold it, the old page is unpinned
+   * 2. check if there is a record in the slot using bitmap, if not, throw WSDB_RECORD_MISS
+   * 3. for every (src, dst) in fields, copy field src of the record and its null bit to field dst of slot
+   * @param rid
+   * @param guard reuse it across calls to save pins, e.g. when reading the records of a page in slot order
+   * @param fields pairs of (index in the table schema, index in slot_schema)
+   * @param slot_schema
+   * @param slot null map followed by data, laid out as a Record of slot_schema
+   */
+  void ReadFields(const RID &rid, PageGuard &guard, const std::vector<std::pair<size_t, size_t>> &fields,
+      const RecordSchema *slot_schema, char *slot);
+
   /**
    * Get a chunk in page using record schema indicating which columns should be loaded
    * @param pid
@@ -66,8 +111,7 @@ public:
    * 2. get an empty slot in the page
    * 3. write the record into the slot
    * 4. update the bitmap and the number of records in the page header
-   * 5. if the page is full after inserting the record, update the first free page id in the file header and set the
-   * next page id of the current page
+   * 5. record the remaining free slots of the page in the free space map
    * 6. unpin the page
    * @param record
    * @return rid of the inserted record
@@ -84,12 +128,23 @@ public:
    */
   void InsertRecord(const RID &rid, const Record &record);
 
+  /**
+   * Insert a batch of records into the table, filling each page with as many records as fit under one pin
+   * 1. create a page handle using CreatePageHandle
+   * 2. write records into the empty slots of the page until the page is full or the batch is exhausted
+   * 3. update the bitmap per slot, and the number of records in the page header once per page
+   * 4. record the remaining free slots of the page in the free space map
+   * 5. unpin the page and repeat from 1 until all records are inserted
+   * @param records
+   * @return rids of the inserted records, in the same order as records
+   */
+  auto InsertRecords(std::span<const Record> records) -> std::vector<RID>;
+
   /**
    * Delete the record by rid
    * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
    * 2. update the bitmap and the number of records in the page header
-   * 3. if the page is not full after deleting the record, update the first free page id in the file header and the next
-   * page id in the page header
+   * 3. record the remaining free slots of the page in the free space map
    * 4. unpin the page
    * @param rid
    */
@@ -107,6 +162,8 @@ public:
 
   [[nodiscard]] auto GetTableId() const -> table_id_t;
 
+  [[nodiscard]] auto GetFsmId() const -> file_id_t;
+
   [[nodiscard]] auto GetTableHeader() const -> const TableHeader &;
 
   [[nodiscard]] auto GetSchema() const -> const RecordSchema &;
@@ -119,8 +176,20 @@ public:
 
   [[nodiscard]] auto GetNextRID(const RID &rid) -> RID;
 
+  /**
+   * Same as GetNextRID, but pages are fetched through guard so that a scan does not pin and unpin the page for every
+   * record, guard holds the page of the returned rid afterwards (or is left on the last page if there is none)
+   */
+  [[nodiscard]] auto GetNextRID(const RID &rid, PageGuard &guard) -> RID;
+
   [[nodiscard]] auto HasField(const std::string &field_name) const -> bool;
 
+  /**
+   * Record the free slots of every data page in the free space map, for tables created before the map existed
+   * the slots are counted from the bitmaps, and the record numbers of the pages and the table are fixed up with them
+   */
+  void RebuildFreeSpaceMap();
+
 private:
   /**
    * Fetch the page handle by page id
@@ -130,16 +199,27 @@ private:
   auto FetchPageHandle(page_id_t page_id) -> PageHandleUptr;
 
   /**
-   * Create a page handle that has at least one empty slot
+   * Create a page handle that has at least one empty slot, pages with free slots are looked up in the free space map
+   * @param latch locks the latch of the page on return, so that the empty slot can not be taken by others
    * @return
    */
-  auto CreatePageHandle() -> PageHandleUptr;
+  auto CreatePageHandle(std::unique_lock<std::mutex> &latch) -> PageHandleUptr;
 
   /**
-   * Create a fresh new page handle
+   * Create a fresh new page handle, the page number of the table is grown under hdr_latch_
+   * @param latch locks the latch of the page on return
    * @return
    */
-  auto CreateNewPageHandle() -> PageHandleUptr;
+  auto CreateNewPageHandle(std::unique_lock<std::mutex> &latch) -> PageHandleUptr;
+
+  /// latch the slots of page pid are claimed and released under
+  auto PageLatch(page_id_t pid) -> std::mutex &;
+
+  /// number of pages of the table, read under hdr_latch_
+  auto GetPageNum() -> size_t;
+
+  /// add delta to the number of records of the table under hdr_latch_
+  void AddRecordNum(int64_t delta);
 
   /**
    * Wrap the page handle according to the storage model
@@ -154,6 +234,11 @@ private:
 
   DiskManager       *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
+  FreeSpaceMap       fsm_;
+  // guards tab_hdr_.page_num_ and tab_hdr_.rec_num_, which are changed by concurrent inserters
+  std::mutex hdr_latch_;
+  // guard the bitmaps and record numbers of the pages, page pid uses page_latches_[pid % TABLE_PAGE_LATCH_NUM]
+  std::array<std::mutex, TABLE_PAGE_LATCH_NUM> page_latches_;
 
   RecordSchemaUptr schema_;
   StorageModel     storage_model_;
@@ -172,8 +172,10 @@ void SystemManager::ClientHandler(int client_fd)
         net_controller_->SendOK(client_fd);
       } else {
         /// plan is not a db plan
-        plan           = optimizer_->Optimize(plan, context.db_);
-        auto exec_tree = executor_->Translate(plan, context.db_);
+        plan = optimizer_->Optimize(plan, context.db_);
+        // the executor tree and everything it allocates from the arena is gone before the arena is reset
+        ArenaScope arena_scope(&context.arena_);
+        auto       exec_tree = executor_->Translate(plan, context.db_);
         executor_->Execute(exec_tree, &context);
       }
       // commit transaction if this is a single sql statement
@@ -191,6 +193,7 @@ void SystemManager::ClientHandler(int client_fd)
         net_controller_->SendError(client_fd, e.short_what());
       }
     }
+    context.arena_.Reset();
   }  // end of client while loop
   net_controller_->Remove(client_fd);
   if (context.db_ != nullptr) {
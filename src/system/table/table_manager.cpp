@@ -30,8 +30,9 @@ void TableManager::CreateTable(
     WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("{}", schema.GetRecordLength()));
   }
 
-  // 1. create and open table file
+  // 1. create and open table file, the free space map lives in its own file and starts empty
   DiskManager::CreateFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  DiskManager::CreateFile(FILE_NAME(db_name, table_name, FSM_SUFFIX));
   auto table_file = disk_manager_->OpenFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
   // 2. prepare table header
   TableHeader table_header;
@@ -54,6 +55,7 @@ void TableManager::CreateTable(
 void TableManager::DropTable(const std::string &db_name, const std::string &table_name)
 {
   DiskManager::DestroyFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  DiskManager::DestroyFile(FILE_NAME(db_name, table_name, FSM_SUFFIX));
 }
 
 TableHandleUptr TableManager::OpenTable(
@@ -83,7 +85,19 @@ TableHandleUptr TableManager::OpenTable(
   }
   schema = std::make_unique<RecordSchema>(fields);
   delete[] file_hdr_data;
-  return std::make_unique<TableHandle>(disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model);
+  // tables created before the free space map have no map file, it is rebuilt from the bitmaps of their pages
+  auto fsm_name    = FILE_NAME(db_name, table_name, FSM_SUFFIX);
+  auto rebuild_fsm = !DiskManager::FileExists(fsm_name);
+  if (rebuild_fsm) {
+    DiskManager::CreateFile(fsm_name);
+  }
+  auto fsm_file = disk_manager_->OpenFile(fsm_name);
+  auto table    = std::make_unique<TableHandle>(
+      disk_manager_, buffer_pool_manager_, table_file, fsm_file, header, schema, storage_model);
+  if (rebuild_fsm) {
+    table->RebuildFreeSpaceMap();
+  }
+  return table;
 }
 
 void TableManager::CloseTable(const std::string &db_name, const TableHandle &table_handle)
@@ -92,10 +106,13 @@ void TableManager::CloseTable(const std::string &db_name, const TableHandle &tab
   WriteTableHeader(table_handle.GetTableId(), table_handle.GetTableHeader(), table_handle.GetSchema());
   // 2. flush all pages to disk
   buffer_pool_manager_->FlushAllPages(table_handle.GetTableId());
+  buffer_pool_manager_->FlushAllPages(table_handle.GetFsmId());
   // delete all pages
   buffer_pool_manager_->DeleteAllPages(table_handle.GetTableId());
-  // 3. close table file
+  buffer_pool_manager_->DeleteAllPages(table_handle.GetFsmId());
+  // 3. close table file and free space map file
   disk_manager_->CloseFile(table_handle.GetTableId());
+  disk_manager_->CloseFile(table_handle.GetFsmId());
 }
 
 void TableManager::WriteTableHeader(table_id_t tid, const TableHeader &header, const RecordSchema &schema)
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/26.
+//
+
+#include <iostream>
+#include <map>
+#include "executor_test_util.h"
+#include "execution/executor_aggregate.h"
+#include "execution/executor_aggregate_vec.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+constexpr size_t BENCH_ROWS = 1000000;
+
+class AggregateBench : public ::testing::TestWithParam<int>
+{};
+
+TEST_P(AggregateBench, GroupBy)
+{
+  auto group_num = GetParam();
+  auto schema    = std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("g", TYPE_INT, 4),
+      MakeField("tag", TYPE_STRING, 8),
+      MakeField("qty", TYPE_INT, 4),
+      MakeField("price", TYPE_FLOAT, 4)});
+  std::vector<Record> records;
+  records.reserve(BENCH_ROWS);
+  for (size_t i = 0; i < BENCH_ROWS; ++i) {
+    auto tag = fmt::format("t{}", rand() % 1000);
+    records.emplace_back(schema.get(),
+        std::vector<ValueSptr>{group_num == 0 ? ValueFactory::CreateNullValue(TYPE_INT)
+                                              : ValueFactory::CreateIntValue(static_cast<int>(i * 7919 % group_num)),
+            ValueFactory::CreateStringValue(tag.c_str(), tag.size()),
+            i % 10 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(rand() % 1000),
+            ValueFactory::CreateFloatValue(static_cast<float>(rand() % 10000) / 100)},
+        INVALID_RID);
+  }
+  // select g, count(*), count(qty), sum(qty), avg(qty), min(qty), max(price), avg(price), min(tag) group by g
+  // a group number of 0 aggregates the whole input without group by
+  auto make_agg = [&](auto tag) -> AbstractExecutorUptr {
+    using Executor   = typename decltype(tag)::type;
+    auto agg_schema  = std::make_unique<RecordSchema>(std::vector<RTField>{MakeAggField(RTField{}, AGG_COUNT_STAR),
+        MakeAggField(schema->GetFieldAt(2), AGG_COUNT),
+        MakeAggField(schema->GetFieldAt(2), AGG_SUM),
+        MakeAggField(schema->GetFieldAt(2), AGG_AVG),
+        MakeAggField(schema->GetFieldAt(2), AGG_MIN),
+        MakeAggField(schema->GetFieldAt(3), AGG_MAX),
+        MakeAggField(schema->GetFieldAt(3), AGG_AVG),
+        MakeAggField(schema->GetFieldAt(1), AGG_MIN)});
+    auto group_fields = group_num == 0 ? std::vector<RTField>{} : std::vector<RTField>{schema->GetFieldAt(0)};
+    return std::make_unique<Executor>(std::make_unique<VecScanExecutor>(schema.get(), &records),
+        std::move(agg_schema),
+        std::make_unique<RecordSchema>(group_fields));
+  };
+  auto   row_agg = make_agg(std::type_identity<AggregateExecutor>{});
+  auto   vec_agg = make_agg(std::type_identity<AggregateExecutorVec>{});
+  auto   key_num = group_num == 0 ? 0 : 1;
+  std::map<std::string, std::vector<std::string>> row_groups;
+  std::map<std::string, std::vector<std::string>> vec_groups;
+  auto   row_ms  = TimeMs([&] { row_groups = CollectGroups(*row_agg, key_num, false); });
+  auto   vec_ms  = TimeMs([&] { vec_groups = CollectGroups(*vec_agg, key_num, true); });
+  ASSERT_EQ(row_groups.size(), group_num == 0 ? 1 : group_num);
+  ASSERT_EQ(row_groups, vec_groups);
+  std::cout << fmt::format("aggregate {} rows into {} groups: AggregateExecutor {:.1f} ms, AggregateExecutorVec {:.1f} ms",
+                   BENCH_ROWS,
+                   row_groups.size(),
+                   row_ms,
+                   vec_ms)
+            << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(Groups, AggregateBench, ::testing::Values(0, 16, 1000, 100000));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/26.
+//
+
+#include <iostream>
+#include "executor_test_util.h"
+#include "execution/executor_aggregate.h"
+#include "execution/executor_aggregate_vec.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+TEST(AggregateVec, EmptyInput)
+{
+  auto schema     = std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("g", TYPE_INT, 4)});
+  auto records    = std::vector<Record>{};
+  auto make_agg   = [&](bool group_by) {
+    auto agg_schema = std::make_unique<RecordSchema>(std::vector<RTField>{
+        MakeAggField(RTField{}, AGG_COUNT_STAR), MakeAggField(schema->GetFieldAt(0), AGG_SUM)});
+    auto group_fields = group_by ? std::vector<RTField>{schema->GetFieldAt(0)} : std::vector<RTField>{};
+    return AggregateExecutorVec(std::make_unique<VecScanExecutor>(schema.get(), &records),
+        std::move(agg_schema),
+        std::make_unique<RecordSchema>(group_fields));
+  };
+  // count(*) and sum(g) of nothing are 0 and null, but there are no groups to return under group by
+  auto global = make_agg(false);
+  global.Init();
+  ASSERT_FALSE(global.IsEnd());
+  ASSERT_EQ(global.GetRecordView().GetScalarAt(0).GetInt(), 0);
+  ASSERT_TRUE(global.GetRecordView().IsNull(1));
+  global.Next();
+  ASSERT_TRUE(global.IsEnd());
+  auto grouped = make_agg(true);
+  grouped.Init();
+  ASSERT_TRUE(grouped.IsEnd());
+}
+
+/// aggregation with a small memory budget spills partial groups and returns the same groups as in memory
+TEST(AggregateVec, Spill)
+{
+  auto schema = std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("g", TYPE_INT, 4),
+      MakeField("tag", TYPE_STRING, 8),
+      MakeField("qty", TYPE_INT, 4),
+      MakeField("price", TYPE_FLOAT, 4)});
+  std::vector<Record> records;
+  for (size_t i = 0; i < 200000; ++i) {
+    auto g   = static_cast<int>(i * 7919 % 30011);
+    auto tag = fmt::format("t{}", g % 7);
+    records.emplace_back(schema.get(),
+        std::vector<ValueSptr>{
+            i % 1000 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(g),
+            ValueFactory::CreateStringValue(tag.c_str(), tag.size()),
+            i % 10 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(rand() % 1000),
+            ValueFactory::CreateFloatValue(static_cast<float>(rand() % 10000) / 100)},
+        INVALID_RID);
+  }
+  // select g, tag, count(*), count(qty), sum(qty), avg(qty), min(qty), max(price), max(tag) group by g, tag, float
+  // sums are left out as their rounding depends on the order partial sums are added in
+  auto make_agg = [&](auto tag, auto... mem_budget) -> AbstractExecutorUptr {
+    using Executor  = typename decltype(tag)::type;
+    auto agg_schema = std::make_unique<RecordSchema>(std::vector<RTField>{MakeAggField(RTField{}, AGG_COUNT_STAR),
+        MakeAggField(schema->GetFieldAt(2), AGG_COUNT),
+        MakeAggField(schema->GetFieldAt(2), AGG_SUM),
+        MakeAggField(schema->GetFieldAt(2), AGG_AVG),
+        MakeAggField(schema->GetFieldAt(2), AGG_MIN),
+        MakeAggField(schema->GetFieldAt(3), AGG_MAX),
+        MakeAggField(schema->GetFieldAt(1), AGG_MAX)});
+    return std::make_unique<Executor>(std::make_unique<VecScanExecutor>(schema.get(), &records),
+        std::move(agg_schema),
+        std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(0), schema->GetFieldAt(1)}),
+        mem_budget...);
+  };
+  auto row_agg  = make_agg(std::type_identity<AggregateExecutor>{});
+  auto expected = CollectGroups(*row_agg, 2, false);
+  // 30011 values of g, plus the null g of every tag
+  ASSERT_GT(expected.size(), 30011);
+  ASSERT_EQ(CollectGroups(*make_agg(std::type_identity<AggregateExecutorVec>{}), 2, true), expected);
+  // a budget of 1 byte spills every batch and splits the partitions down to AGG_MAX_DEPTH
+  for (size_t mem_budget : {size_t{1}, size_t{64 * 1024}, size_t{1024 * 1024}}) {
+    auto   spilled = make_agg(std::type_identity<AggregateExecutorVec>{}, mem_budget);
+    double ms      = 0;
+    ms += TimeMs([&] { ASSERT_EQ(CollectGroups(*spilled, 2, true), expected); });
+    ms += TimeMs([&] { ASSERT_EQ(CollectGroups(*spilled, 2, false), expected); });
+    std::cout << fmt::format("aggregate {} rows into {} groups with a budget of {} bytes: {:.1f} ms",
+                     records.size(),
+                     expected.size(),
+                     mem_budget,
+                     ms / 2)
+              << std::endl;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
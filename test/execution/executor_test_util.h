@@ -0,0 +1,455 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/24.
+//
+
+#ifndef WSDB_EXECUTOR_TEST_UTIL_H
+#define WSDB_EXECUTOR_TEST_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+#include "../config.h"
+#include "common/config.h"
+#include "execution/executor_abstract.h"
+#include "execution/executor_aggregate_parallel.h"
+#include "execution/executor_aggregate_vec.h"
+#include "execution/executor_exchange.h"
+#include "execution/executor_filter.h"
+#include "execution/executor_join_hash.h"
+#include "execution/executor_materialize.h"
+#include "execution/executor_seqscan.h"
+#include "storage/storage.h"
+#include "system/table/table_manager.h"
+
+#include "gtest/gtest.h"
+
+namespace wsdb {
+
+/**
+ * Leaf executor over records kept in memory, feeds operators under test without going through tables and the buffer
+ * pool
+ */
+class VecScanExecutor : public AbstractExecutor
+{
+public:
+  VecScanExecutor(const RecordSchema *schema, const std::vector<Record> *records)
+      : AbstractExecutor(Basic), schema_(schema), records_(records)
+  {}
+
+  void Init() override { idx_ = 0; }
+
+  void Next() override { idx_++; }
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return idx_ >= records_->size(); }
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override { return schema_; }
+
+  [[nodiscard]] auto GetRecordView() const -> RecordView override
+  {
+    return IsEnd() ? RecordView{} : RecordView((*records_)[idx_]);
+  }
+
+  /// batches reference the records in place
+  auto NextBatch(RecordBatch &batch) -> bool override
+  {
+    batch.Reset();
+    for (; !IsEnd() && !batch.IsFull(); Next()) {
+      batch.AppendView((*records_)[idx_]);
+    }
+    return batch.GetSelSize() > 0;
+  }
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return true; }
+
+private:
+  const RecordSchema        *schema_;
+  const std::vector<Record> *records_;
+  size_t                     idx_{0};
+};
+
+inline auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+/// the aggregate agg_type of field, count(*) takes an empty field
+inline auto MakeAggField(const RTField &field, AggType agg_type) -> RTField
+{
+  auto agg      = field;
+  agg.is_agg_   = true;
+  agg.agg_type_ = agg_type;
+  if (agg_type == AGG_COUNT || agg_type == AGG_COUNT_STAR) {
+    agg.field_.field_type_ = TYPE_INT;
+    agg.field_.field_size_ = sizeof(int);
+  }
+  return agg;
+}
+
+/// run func and return the elapsed wall time in milliseconds
+template <typename Func>
+auto TimeMs(Func &&func) -> double
+{
+  auto begin = std::chrono::steady_clock::now();
+  func();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/// the printed rows in the order the executor returns them, batches hold batch_size rows
+inline auto CollectRows(AbstractExecutor &executor, bool use_batch = true, size_t batch_size = BATCH_SIZE)
+    -> std::vector<std::string>
+{
+  std::vector<std::string> rows;
+  auto                     add = [&rows](const RecordView &row) {
+    std::string str;
+    for (size_t i = 0; i < row.GetSchema()->GetFieldCount(); ++i) {
+      str += row.GetScalarAt(i).ToString() + "|";
+    }
+    rows.push_back(std::move(str));
+  };
+  if (use_batch) {
+    RecordBatch batch(executor.GetOutSchema(), batch_size);
+    for (executor.Init(); executor.NextBatch(batch);) {
+      for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+        add(batch.GetRow(i));
+      }
+    }
+  } else {
+    for (executor.Init(); !executor.IsEnd(); executor.Next()) {
+      add(executor.GetRecordView());
+    }
+  }
+  return rows;
+}
+
+/// drain the executor, rows are keyed by their printed group fields so that group orders do not matter
+inline auto CollectGroups(AbstractExecutor &executor, size_t key_num, bool use_batch)
+    -> std::map<std::string, std::vector<std::string>>
+{
+  std::map<std::string, std::vector<std::string>> groups;
+  auto add = [&](const RecordView &row) {
+    std::string              key;
+    std::vector<std::string> values;
+    for (size_t i = 0; i < row.GetSchema()->GetFieldCount(); ++i) {
+      (i < key_num ? key : values.emplace_back()) += row.GetScalarAt(i).ToString() + "|";
+    }
+    EXPECT_TRUE(groups.emplace(key, std::move(values)).second) << "duplicated group " << key;
+  };
+  if (use_batch) {
+    RecordBatch batch(executor.GetOutSchema());
+    for (executor.Init(); executor.NextBatch(batch);) {
+      for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+        add(batch.GetRow(i));
+      }
+    }
+  } else {
+    for (executor.Init(); !executor.IsEnd(); executor.Next()) {
+      add(executor.GetRecordView());
+    }
+  }
+  return groups;
+}
+
+/// files left in TMP_DIR, executors that spill must remove theirs when they are done
+inline auto CountTmpFiles() -> size_t
+{
+  if (!std::filesystem::exists(TMP_DIR)) {
+    return 0;
+  }
+  auto it = std::filesystem::directory_iterator(TMP_DIR);
+  return std::distance(std::filesystem::begin(it), std::filesystem::end(it));
+}
+
+inline auto MakeJoinSchema(const std::string &prefix) -> RecordSchemaUptr
+{
+  return std::make_unique<RecordSchema>(std::vector<RTField>{MakeField(prefix + "_k", TYPE_INT, 4),
+      MakeField(prefix + "_v", TYPE_FLOAT, 4),
+      MakeField(prefix + "_s", TYPE_STRING, 16)});
+}
+
+/// n rows with keys in [0, key_range), a share of skew_pct percent of them have the key 7, some keys are null if asked
+inline auto GenJoinRecords(const RecordSchema *schema, size_t n, int key_range, int skew_pct, bool with_null)
+    -> std::vector<Record>
+{
+  std::vector<Record> records;
+  records.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto key = rand() % 100 < skew_pct ? 7 : rand() % key_range;
+    auto str = fmt::format("s_{}", i);
+    records.emplace_back(schema,
+        std::vector<ValueSptr>{
+            with_null && i % 97 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(key),
+            ValueFactory::CreateFloatValue(static_cast<float>(i)),
+            ValueFactory::CreateStringValue(str.c_str(), str.size())},
+        INVALID_RID);
+  }
+  return records;
+}
+
+/// hash join on the first field of both sides
+inline auto MakeHashJoin(JoinType join_type, const RecordSchemaUptr &left_schema,
+    const std::vector<Record> &left_records, const RecordSchemaUptr &right_schema,
+    const std::vector<Record> &right_records, bool build_left, size_t mem_budget) -> std::unique_ptr<HashJoinExecutor>
+{
+  return std::make_unique<HashJoinExecutor>(join_type,
+      std::make_unique<VecScanExecutor>(left_schema.get(), &left_records),
+      std::make_unique<VecScanExecutor>(right_schema.get(), &right_records),
+      std::make_unique<RecordSchema>(std::vector<RTField>{left_schema->GetFieldAt(0)}),
+      std::make_unique<RecordSchema>(std::vector<RTField>{right_schema->GetFieldAt(0)}),
+      build_left,
+      mem_budget);
+}
+
+inline auto MakeSortSchema() -> RecordSchemaUptr
+{
+  return std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("k", TYPE_INT, 4),
+      MakeField("v", TYPE_FLOAT, 4),
+      MakeField("s", TYPE_STRING, 16),
+      MakeField("id", TYPE_INT, 4)});
+}
+
+/// rows with many equal keys and some nulls, id keeps the position of the row in the input
+inline auto GenSortRecords(const RecordSchema *schema, size_t n, int key_range) -> std::vector<Record>
+{
+  std::vector<Record> records;
+  records.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto str = fmt::format("s_{}", rand() % 1000);
+    records.emplace_back(schema,
+        std::vector<ValueSptr>{
+            i % 101 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(rand() % key_range),
+            ValueFactory::CreateFloatValue(static_cast<float>(rand() % 1000) / 10),
+            ValueFactory::CreateStringValue(str.c_str(), str.size()),
+            ValueFactory::CreateIntValue(static_cast<int>(i))},
+        INVALID_RID);
+  }
+  return records;
+}
+
+/// schema and rows like the dbcourse table of test/sql/lab02, scores have a few decimals so many of them are equal
+inline auto MakeCourseSchema() -> RecordSchemaUptr
+{
+  return std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("id", TYPE_INT, 4),
+      MakeField("name", TYPE_STRING, 20),
+      MakeField("age", TYPE_INT, 4),
+      MakeField("address", TYPE_STRING, 50),
+      MakeField("gpa", TYPE_FLOAT, 4),
+      MakeField("l1_score", TYPE_FLOAT, 4),
+      MakeField("l2_score", TYPE_FLOAT, 4)});
+}
+
+inline auto GenCourseRecords(const RecordSchema *schema, size_t n) -> std::vector<Record>
+{
+  std::vector<Record> records;
+  records.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto name    = fmt::format("name_{}", rand() % 5000);
+    auto address = fmt::format("city_{}", rand() % 300);
+    records.emplace_back(schema,
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(rand() % static_cast<int>(n) - static_cast<int>(n / 2)),
+            ValueFactory::CreateStringValue(name.c_str(), name.size()),
+            ValueFactory::CreateIntValue(16 + rand() % 40),
+            ValueFactory::CreateStringValue(address.c_str(), address.size()),
+            ValueFactory::CreateFloatValue(static_cast<float>(rand() % 500) / 100),
+            ValueFactory::CreateFloatValue(static_cast<float>(rand() % 10000) / 100),
+            i % 97 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT)
+                        : ValueFactory::CreateFloatValue(static_cast<float>(rand() % 20000 - 10000) / 100)},
+        INVALID_RID);
+  }
+  return records;
+}
+
+/// records are built under schema if it is given, see DrainBatches
+inline auto DrainRows(AbstractExecutor &executor, const RecordSchema *schema = nullptr) -> std::vector<Record>
+{
+  std::vector<Record> records;
+  for (executor.Init(); !executor.IsEnd(); executor.Next()) {
+    auto row = executor.GetRecordView();
+    if (schema == nullptr) {
+      records.emplace_back(row);
+    } else {
+      records.emplace_back(schema, row.GetNullMap(), row.GetData(), row.GetRID());
+    }
+  }
+  return records;
+}
+
+/// records are built under schema so that they compare equal to the ones of another plan of the same shape
+inline auto DrainBatches(AbstractExecutor &executor, size_t capacity, const RecordSchema *schema) -> std::vector<Record>
+{
+  std::vector<Record> records;
+  RecordBatch         batch(executor.GetOutSchema(), capacity);
+  for (executor.Init(); executor.NextBatch(batch);) {
+    EXPECT_GT(batch.GetSelSize(), 0);
+    for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+      const auto &row = batch.GetRow(i);
+      records.emplace_back(schema, row.GetNullMap(), row.GetData(), row.GetRID());
+    }
+  }
+  return records;
+}
+
+/// records in a fixed order, for the outputs whose order is unspecified
+inline auto SortRecords(std::vector<Record> records) -> std::vector<Record>
+{
+  std::sort(records.begin(), records.end(), [](const Record &l, const Record &r) { return Record::Compare(l, r) < 0; });
+  return records;
+}
+
+/// a table of (t_k, t_v, t_s) with page_num pages of random records, with holes in the pages and a few empty pages, or
+/// an empty table
+inline auto MakeTable(
+    TableManager *table_manager, const std::string &table_name, StorageModel model, size_t page_num) -> TableHandleUptr
+{
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  auto tbl_schema = RecordSchema(std::vector<RTField>{
+      MakeField("t_k", TYPE_INT, 4), MakeField("t_v", TYPE_FLOAT, 4), MakeField("t_s", TYPE_STRING, 12)});
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, model);
+  auto                tbl     = table_manager->OpenTable(TEST_DIR, table_name, model);
+  auto                rpp     = tbl->GetTableHeader().rec_per_page_;
+  auto                row_num = page_num == 0 ? 0 : page_num * rpp - rpp / 2;
+  std::vector<Record> records;
+  for (size_t i = 0; i < row_num; ++i) {
+    auto name = fmt::format("name_{}", rand() % 100);
+    records.emplace_back(&tbl->GetSchema(),
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(rand() % 100),
+            i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT)
+                       : ValueFactory::CreateFloatValue(static_cast<float>(rand() % 1000) / 10),
+            ValueFactory::CreateStringValue(name.c_str(), name.size())},
+        INVALID_RID);
+  }
+  auto rids = tbl->InsertRecords(records);
+  for (size_t i = 0; i < rids.size(); ++i) {
+    if (i % 3 == 0 || (i / rpp) % 11 == 4) {
+      tbl->DeleteRecord(rids[i]);
+    }
+  }
+  return tbl;
+}
+
+/// pipelines of t_k < 60 AND t_v >= 20 outputting (t_s, t_k), with the conditions in the scan or in a filter above it,
+/// and with t_s fetched by a materialization above the scan
+class ParallelScanTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+  }
+
+  void TearDown() override
+  {
+    for (const auto &[name, tbl] : tables_) {
+      table_manager_->CloseTable(TEST_DIR, *tbl);
+      table_manager_->DropTable(TEST_DIR, name);
+    }
+    tables_.clear();
+  }
+
+  auto OpenTable(StorageModel model, size_t page_num) -> TableHandle *
+  {
+    auto name = fmt::format("parallel_scan_{}_{}", static_cast<int>(model), tables_.size());
+    tables_.emplace_back(name, MakeTable(table_manager_.get(), name, model, page_num));
+    return tables_.back().second.get();
+  }
+
+  static auto MakePipeline(TableHandle *tbl, int shape, const PageRange *range) -> AbstractExecutorUptr
+  {
+    const auto  &schema = tbl->GetSchema();
+    ValueSptr    k_val  = ValueFactory::CreateIntValue(60);
+    ValueSptr    v_val  = ValueFactory::CreateIntValue(20);
+    ConditionVec conds;
+    conds.emplace_back(OP_LT, schema.GetFieldAt(0), k_val);
+    conds.emplace_back(OP_GE, schema.GetFieldAt(1), v_val);
+    auto out_fields = std::vector<RTField>{schema.GetFieldAt(2), schema.GetFieldAt(0)};
+    if (shape == 0) {
+      return std::make_unique<SeqScanExecutor>(tbl, conds, out_fields, range);
+    }
+    if (shape == 1) {
+      auto scan = std::make_unique<SeqScanExecutor>(tbl, ConditionVec{}, std::vector<RTField>{}, range);
+      auto pred = Predicate(conds, scan->GetOutSchema());
+      return std::make_unique<FilterExecutor>(std::move(scan), std::move(pred));
+    }
+    auto scan = std::make_unique<SeqScanExecutor>(tbl, conds, std::vector<RTField>{schema.GetFieldAt(0)}, range);
+    return std::make_unique<MaterializeExecutor>(std::move(scan), tbl, std::make_unique<RecordSchema>(out_fields));
+  }
+
+  /// aggregates of the rows of the filter pipelines grouped by field group_by of the table, or not grouped if it is
+  /// negative, in parallel over worker_num pipelines or serially if worker_num is 0
+  static auto MakeAggregate(TableHandle *tbl, int group_by, size_t worker_num, size_t morsel_pages,
+      size_t mem_budget = AGG_BUFFER_SIZE) -> AbstractExecutorUptr
+  {
+    const auto &schema     = tbl->GetSchema();
+    auto        agg_fields = std::vector<RTField>{MakeAggField(RTField{}, AGG_COUNT_STAR),
+        MakeAggField(schema.GetFieldAt(1), AGG_COUNT),
+        MakeAggField(schema.GetFieldAt(0), AGG_SUM),
+        MakeAggField(schema.GetFieldAt(0), AGG_AVG),
+        MakeAggField(schema.GetFieldAt(1), AGG_MIN),
+        MakeAggField(schema.GetFieldAt(1), AGG_MAX),
+        MakeAggField(schema.GetFieldAt(2), AGG_MAX)};
+    auto group_fields = group_by < 0 ? std::vector<RTField>{} : std::vector<RTField>{schema.GetFieldAt(group_by)};
+    auto agg_schema   = std::make_unique<RecordSchema>(agg_fields);
+    auto group_schema = std::make_unique<RecordSchema>(group_fields);
+    if (worker_num == 0) {
+      return std::make_unique<AggregateExecutorVec>(
+          MakePipeline(tbl, 1, nullptr), std::move(agg_schema), std::move(group_schema), mem_budget);
+    }
+    std::vector<ExchangePipeline> pipelines(worker_num);
+    for (auto &pipeline : pipelines) {
+      pipeline.range_ = std::make_unique<PageRange>();
+      pipeline.root_  = MakePipeline(tbl, 1, pipeline.range_.get());
+    }
+    return std::make_unique<ParallelAggregateExecutor>(
+        tbl, std::move(pipelines), std::move(agg_schema), std::move(group_schema), morsel_pages, mem_budget);
+  }
+
+  static auto MakeExchange(TableHandle *tbl, int shape, size_t worker_num, size_t morsel_pages)
+      -> std::unique_ptr<ExchangeExecutor>
+  {
+    std::vector<ExchangePipeline> pipelines(worker_num);
+    for (auto &pipeline : pipelines) {
+      pipeline.range_ = std::make_unique<PageRange>();
+      pipeline.root_  = MakePipeline(tbl, shape, pipeline.range_.get());
+    }
+    return std::make_unique<ExchangeExecutor>(tbl, std::move(pipelines), morsel_pages);
+  }
+
+  std::unique_ptr<DiskManager>                         disk_manager_;
+  std::unique_ptr<BufferPoolManager>                   buffer_pool_manager_;
+  std::unique_ptr<TableManager>                        table_manager_;
+  std::vector<std::pair<std::string, TableHandleUptr>> tables_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_TEST_UTIL_H
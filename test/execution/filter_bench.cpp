@@ -0,0 +1,264 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/8/24.
+//
+
+#include <iostream>
+#include "executor_test_util.h"
+#include "execution/executor_filter.h"
+#include "expr/column_kernel.h"
+#include "expr/condition_expr.h"
+#include "expr/predicate.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+constexpr size_t BENCH_ROWS = 1000000;
+
+auto RunFilter(const RecordSchema *schema, const std::vector<Record> &records,
+    std::function<bool(const RecordView &)> filter) -> size_t
+{
+  FilterExecutor executor(std::make_unique<VecScanExecutor>(schema, &records), std::move(filter));
+  size_t         cnt = 0;
+  for (executor.Init(); !executor.IsEnd(); executor.Next()) {
+    cnt++;
+  }
+  return cnt;
+}
+
+TEST(FilterBench, MillionRows)
+{
+  auto schema = std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("id", TYPE_INT, 4),
+      MakeField("price", TYPE_FLOAT, 4),
+      MakeField("name", TYPE_STRING, 16),
+      MakeField("qty", TYPE_INT, 4)});
+  std::vector<Record> records;
+  records.reserve(BENCH_ROWS);
+  for (size_t i = 0; i < BENCH_ROWS; ++i) {
+    auto name = fmt::format("item_{}", rand() % 1000);
+    records.emplace_back(schema.get(),
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(static_cast<int>(i)),
+            ValueFactory::CreateFloatValue(static_cast<float>(rand() % 10000) / 100),
+            ValueFactory::CreateStringValue(name.c_str(), name.size()),
+            i % 10 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(rand() % 100)},
+        INVALID_RID);
+  }
+  // id > 100000 AND price < 50 (int constant against a float column) AND name >= 'item_3' AND qty <= price
+  ValueSptr    id_val    = ValueFactory::CreateIntValue(100000);
+  ValueSptr    price_val = ValueFactory::CreateIntValue(50);
+  ValueSptr    name_val  = ValueFactory::CreateStringValue("item_3", 6);
+  ConditionVec conds;
+  conds.emplace_back(OP_GT, schema->GetFieldAt(0), id_val);
+  conds.emplace_back(OP_LT, schema->GetFieldAt(1), price_val);
+  conds.emplace_back(OP_GE, schema->GetFieldAt(2), name_val);
+  conds.emplace_back(OP_LE, schema->GetFieldAt(3), schema->GetFieldAt(1));
+
+  auto   predicate   = Predicate(conds, schema.get());
+  size_t generic_cnt = 0;
+  size_t kernel_cnt  = 0;
+  size_t batch_cnt   = 0;
+  auto   generic_ms  = TimeMs([&] {
+    generic_cnt =
+        RunFilter(schema.get(), records, [&conds](const RecordView &rec) { return ConditionExpr::Eval(conds, rec); });
+  });
+  auto   kernel_ms   = TimeMs([&] {
+    FilterExecutor executor(std::make_unique<VecScanExecutor>(schema.get(), &records), predicate);
+    for (executor.Init(); !executor.IsEnd(); executor.Next()) {
+      kernel_cnt++;
+    }
+  });
+  // the kernels running over whole batches through the batch interface of the filter
+  auto batch_ms = TimeMs([&] {
+    FilterExecutor executor(std::make_unique<VecScanExecutor>(schema.get(), &records), predicate);
+    RecordBatch    batch(schema.get());
+    for (executor.Init(); executor.NextBatch(batch);) {
+      batch_cnt += batch.GetSelSize();
+    }
+  });
+  ASSERT_EQ(generic_cnt, kernel_cnt);
+  ASSERT_EQ(generic_cnt, batch_cnt);
+  ASSERT_GT(kernel_cnt, 0);
+  std::cout << fmt::format(
+                   "filter {} rows, {} passed: ConditionExpr {:.1f} ms, Predicate per row {:.1f} ms, per batch {:.1f} ms",
+                   BENCH_ROWS,
+                   kernel_cnt,
+                   generic_ms,
+                   kernel_ms,
+                   batch_ms)
+            << std::endl;
+}
+
+template <typename L, typename R>
+void CheckColumnKernel(const std::vector<L> &lhs, const std::vector<R> &rhs)
+{
+  auto n      = lhs.size();
+  auto bitmap = std::vector<char>(BITMAP_SIZE(n) + 1, static_cast<char>(0xff));
+  auto sel    = std::vector<uint32_t>(n);
+  for (auto op : {OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE}) {
+    auto expect = [op](const L &l, const R &r) {
+      switch (op) {
+        case OP_EQ: return CompareValues<OP_EQ>(l, r);
+        case OP_NE: return CompareValues<OP_NE>(l, r);
+        case OP_LT: return CompareValues<OP_LT>(l, r);
+        case OP_LE: return CompareValues<OP_LE>(l, r);
+        case OP_GT: return CompareValues<OP_GT>(l, r);
+        default: return CompareValues<OP_GE>(l, r);
+      }
+    };
+    ColumnKernel::CompareColumn(op, lhs.data(), rhs.data(), n, bitmap.data());
+    size_t cnt = 0;
+    for (size_t i = 0; i < BITMAP_SIZE(n) * BITMAP_WIDTH; ++i) {
+      auto bit = BitMap::GetBit(bitmap.data(), i);
+      ASSERT_EQ(bit, i < n && expect(lhs[i], rhs[i])) << CompOpToString(op) << " row " << i << " of " << n;
+      cnt += bit;
+    }
+    ASSERT_EQ(ColumnKernel::ToSelection(bitmap.data(), n, sel.data()), cnt);
+    for (size_t i = 0; i < cnt; ++i) {
+      ASSERT_TRUE(BitMap::GetBit(bitmap.data(), sel[i]));
+      ASSERT_TRUE(i == 0 || sel[i - 1] < sel[i]);
+    }
+    auto rconst = n == 0 ? R{} : rhs[n / 2];
+    ColumnKernel::CompareConst(op, lhs.data(), rconst, n, bitmap.data());
+    for (size_t i = 0; i < BITMAP_SIZE(n) * BITMAP_WIDTH; ++i) {
+      ASSERT_EQ(BitMap::GetBit(bitmap.data(), i), i < n && expect(lhs[i], rconst))
+          << CompOpToString(op) << " row " << i << " of " << n;
+    }
+  }
+}
+
+/// the SIMD kernels against the scalar comparison, row counts cover full vectors and partial tails
+TEST(ColumnKernel, MatchesScalar)
+{
+  for (size_t n : {0, 1, 3, 4, 7, 8, 9, 13, 16, 64, 65, 1000}) {
+    std::vector<int32_t> li(n), ri(n);
+    std::vector<float>   lf(n), rf(n);
+    for (size_t i = 0; i < n; ++i) {
+      // small ranges so that all ops see equal values
+      li[i] = rand() % 8 - 4;
+      ri[i] = rand() % 8 - 4;
+      lf[i] = static_cast<float>(rand() % 16 - 8) / 2;
+      rf[i] = static_cast<float>(rand() % 16 - 8) / 2;
+    }
+    CheckColumnKernel(li, ri);
+    CheckColumnKernel(li, rf);
+    CheckColumnKernel(lf, ri);
+    CheckColumnKernel(lf, rf);
+  }
+}
+
+/// store records column by column, like TableHandle::GetChunk does for a PAX page
+auto MakeChunk(const RecordSchema *schema, const std::vector<Record> &records, size_t begin, size_t end) -> Chunk
+{
+  std::vector<ColumnVector> cols;
+  for (size_t c = 0; c < schema->GetFieldCount(); ++c) {
+    const auto &field = schema->GetFieldAt(c);
+    auto        width = field.field_.field_size_;
+    auto        col   = ColumnVector(field, end - begin);
+    for (size_t r = begin; r < end; ++r) {
+      if (BitMap::GetBit(records[r].GetNullMap(), c)) {
+        BitMap::SetBit(col.GetNullMap(), r - begin, true);
+      } else {
+        memcpy(col.GetRawData() + (r - begin) * width, records[r].GetData() + schema->GetFieldOffset(c), width);
+      }
+    }
+    col.SetSize(end - begin);
+    cols.push_back(std::move(col));
+  }
+  std::vector<RID> rids(end - begin, INVALID_RID);
+  return {schema, std::move(cols), std::move(rids)};
+}
+
+TEST(FilterBench, PAXChunk)
+{
+  auto schema = std::make_unique<RecordSchema>(std::vector<RTField>{MakeField("id", TYPE_INT, 4),
+      MakeField("price", TYPE_FLOAT, 4),
+      MakeField("name", TYPE_STRING, 16),
+      MakeField("qty", TYPE_INT, 4)});
+  std::vector<Record> records;
+  records.reserve(BENCH_ROWS);
+  for (size_t i = 0; i < BENCH_ROWS; ++i) {
+    auto name = fmt::format("item_{}", rand() % 1000);
+    records.emplace_back(schema.get(),
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(static_cast<int>(i)),
+            i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT)
+                       : ValueFactory::CreateFloatValue(static_cast<float>(rand() % 10000) / 100),
+            ValueFactory::CreateStringValue(name.c_str(), name.size()),
+            i % 10 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(rand() % 100)},
+        INVALID_RID);
+  }
+  // chunks of an odd size so that every chunk ends with a partial vector
+  constexpr size_t chunk_rows = 1021;
+  std::vector<Chunk> chunks;
+  for (size_t i = 0; i < BENCH_ROWS; i += chunk_rows) {
+    chunks.push_back(MakeChunk(schema.get(), records, i, std::min(i + chunk_rows, BENCH_ROWS)));
+  }
+  ValueSptr    id_val    = ValueFactory::CreateIntValue(100000);
+  ValueSptr    price_val = ValueFactory::CreateIntValue(50);
+  ValueSptr    qty_val   = ValueFactory::CreateIntValue(3);
+  ValueSptr    name_val  = ValueFactory::CreateStringValue("item_3", 6);
+  ConditionVec numeric;
+  numeric.emplace_back(OP_GT, schema->GetFieldAt(0), id_val);
+  numeric.emplace_back(OP_LT, schema->GetFieldAt(1), price_val);
+  numeric.emplace_back(OP_NE, schema->GetFieldAt(3), qty_val);
+  numeric.emplace_back(OP_LE, schema->GetFieldAt(3), schema->GetFieldAt(1));
+  ConditionVec mixed = numeric;
+  mixed.emplace_back(OP_GE, schema->GetFieldAt(2), name_val);
+
+  for (const auto &conds : {numeric, mixed}) {
+    auto   predicate = Predicate(conds, schema.get());
+    size_t row_cnt   = 0;
+    size_t chunk_cnt = 0;
+    auto   row_ms    = TimeMs([&] {
+      FilterExecutor executor(std::make_unique<VecScanExecutor>(schema.get(), &records), predicate);
+      RecordBatch    batch(schema.get());
+      for (executor.Init(); executor.NextBatch(batch);) {
+        row_cnt += batch.GetSelSize();
+      }
+    });
+    auto   bitmap    = std::vector<char>(BITMAP_SIZE(chunk_rows));
+    auto   chunk_ms  = TimeMs([&] {
+      for (const auto &chunk : chunks) {
+        chunk_cnt += predicate.Filter(chunk, bitmap.data());
+      }
+    });
+    ASSERT_EQ(row_cnt, chunk_cnt);
+    ASSERT_GT(chunk_cnt, 0);
+    // row by row agreement with the record kernels
+    for (size_t c = 0; c < chunks.size(); c += 97) {
+      predicate.Filter(chunks[c], bitmap.data());
+      for (size_t r = 0; r < chunks[c].GetRowCount(); ++r) {
+        ASSERT_EQ(BitMap::GetBit(bitmap.data(), r), predicate.Eval(records[c * chunk_rows + r]));
+      }
+    }
+    std::cout << fmt::format("filter {} rows on {} terms, {} passed: record batches {:.1f} ms, columns {:.1f} ms{}",
+                     BENCH_ROWS,
+                     conds.size(),
+                     chunk_cnt,
+                     row_ms,
+                     chunk_ms,
+                     ColumnKernel::HasAVX2() ? " (AVX2)" : "")
+              << std::endl;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
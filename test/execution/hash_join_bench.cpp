@@ -0,0 +1,77 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/28.
+//
+
+#include <iostream>
+#include "common/config.h"
+#include "executor_test_util.h"
+#include "execution/executor_join_hash.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+TEST(HashJoinBench, LargerThanBudget)
+{
+  constexpr size_t BUILD_ROWS = 1000000;
+  constexpr size_t PROBE_ROWS = 2000000;
+  auto             build_schema  = MakeJoinSchema("b");
+  auto             probe_schema  = MakeJoinSchema("p");
+  auto             build_records = GenJoinRecords(build_schema.get(), BUILD_ROWS, BUILD_ROWS, 0, false);
+  auto             probe_records = GenJoinRecords(probe_schema.get(), PROBE_ROWS, BUILD_ROWS * 2, 0, false);
+  // the build side takes about 4 times the budget
+  auto build_size = BUILD_ROWS * (BITMAP_SIZE(3) + build_schema->GetRecordLength());
+  auto mem_budget = build_size / 4;
+  auto run        = [&](size_t budget, size_t &row_num, size_t &checksum) {
+    auto join = MakeHashJoin(INNER_JOIN, probe_schema, probe_records, build_schema, build_records, false, budget);
+    row_num   = 0;
+    checksum  = 0;
+    RecordBatch batch(join->GetOutSchema());
+    for (join->Init(); join->NextBatch(batch);) {
+      for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+        const auto &row = batch.GetRow(i);
+        // the order of rows differs between the runs
+        auto data = std::string_view(row.GetData(), join->GetOutSchema()->GetRecordLength());
+        checksum += std::hash<std::string_view>{}(data);
+        row_num++;
+      }
+    }
+  };
+  size_t mem_rows = 0, mem_sum = 0, spill_rows = 0, spill_sum = 0;
+  auto   mem_ms   = TimeMs([&] { run(HASH_JOIN_BUFFER_SIZE * 16, mem_rows, mem_sum); });
+  auto   spill_ms = TimeMs([&] { run(mem_budget, spill_rows, spill_sum); });
+  ASSERT_GT(mem_rows, 0);
+  ASSERT_EQ(spill_rows, mem_rows);
+  ASSERT_EQ(spill_sum, mem_sum);
+  std::cout << fmt::format("hash join {} x {} rows into {} rows: in memory {:.1f} ms, {} KB budget {:.1f} ms",
+                   PROBE_ROWS,
+                   BUILD_ROWS,
+                   mem_rows,
+                   mem_ms,
+                   mem_budget / 1024,
+                   spill_ms)
+            << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
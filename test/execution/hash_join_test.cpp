@@ -0,0 +1,71 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/28.
+//
+
+#include <algorithm>
+#include "common/config.h"
+#include "executor_test_util.h"
+#include "execution/executor_join_hash.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// joined rows in a canonical order, spilled partitions are joined in another order than the input
+auto CollectJoined(AbstractExecutor &executor, bool use_batch) -> std::vector<std::string>
+{
+  auto rows = CollectRows(executor, use_batch, 500);
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+TEST(HashJoinSpill, MatchesInMemory)
+{
+  auto left_schema   = MakeJoinSchema("l");
+  auto right_schema  = MakeJoinSchema("r");
+  auto left_records  = GenJoinRecords(left_schema.get(), 20000, 5000, 0, true);
+  auto right_records = GenJoinRecords(right_schema.get(), 8000, 6000, 10, true);
+  auto tmp_files     = CountTmpFiles();
+  // a budget of a few hundred rows spills most partitions and partitions them again, the rows of the skewed key can
+  // never be split and end up joined in memory after the max depth
+  for (auto join_type : {INNER_JOIN, OUTER_JOIN}) {
+    for (bool build_left : {false, true}) {
+      auto in_memory = MakeHashJoin(
+          join_type, left_schema, left_records, right_schema, right_records, build_left, HASH_JOIN_BUFFER_SIZE);
+      auto expected = CollectJoined(*in_memory, false);
+      ASSERT_FALSE(expected.empty());
+      for (size_t mem_budget : {size_t{4 * 1024}, size_t{64 * 1024}, size_t{512 * 1024}}) {
+        for (bool use_batch : {false, true}) {
+          auto spilled =
+              MakeHashJoin(join_type, left_schema, left_records, right_schema, right_records, build_left, mem_budget);
+          ASSERT_EQ(CollectJoined(*spilled, use_batch), expected)
+              << JoinTypeToString(join_type) << " build_left " << build_left << " budget " << mem_budget;
+        }
+      }
+    }
+  }
+  ASSERT_EQ(CountTmpFiles(), tmp_files);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
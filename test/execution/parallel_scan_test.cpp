@@ -0,0 +1,210 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+#include <atomic>
+#include "executor_test_util.h"
+#include "execution/executor_exchange.h"
+#include "execution/executor_join_hash.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_seqscan.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+void ExpectSameRIDs(const std::vector<Record> &records, const std::vector<Record> &expected)
+{
+  ASSERT_EQ(records, expected);
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(records[i].GetRID(), expected[i].GetRID());
+  }
+}
+
+/// the exchange returns the rows of a sequential scan in the same order, whatever the workers and the morsels
+TEST_F(ParallelScanTest, MatchesSeqScan)
+{
+  for (auto model : {NARY_MODEL, PAX_MODEL}) {
+    auto tbl = OpenTable(model, 23);
+    for (int shape = 0; shape < 3; ++shape) {
+      auto serial   = MakePipeline(tbl, shape, nullptr);
+      auto schema   = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+      auto expected = DrainBatches(*serial, BATCH_SIZE, schema.get());
+      ASSERT_GT(expected.size(), 0);
+      for (size_t worker_num : {1, 2, 4}) {
+        for (size_t morsel_pages : {1, 3, 64}) {
+          auto exchange = MakeExchange(tbl, shape, worker_num, morsel_pages);
+          ExpectSameRIDs(DrainRows(*exchange, schema.get()), expected);
+          for (size_t capacity : {size_t{3}, BATCH_SIZE}) {
+            ExpectSameRIDs(DrainBatches(*exchange, capacity, schema.get()), expected);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// an exchange destroyed or re-initialized before its end stops its workers first
+TEST_F(ParallelScanTest, EarlyStop)
+{
+  auto tbl      = OpenTable(NARY_MODEL, 40);
+  auto serial   = MakePipeline(tbl, 1, nullptr);
+  auto schema   = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+  auto expected = DrainBatches(*serial, BATCH_SIZE, schema.get());
+  ASSERT_GT(expected.size(), 10);
+  for (int limit : {0, 1, 10}) {
+    LimitExecutor lim(MakeExchange(tbl, 1, 4, 1), limit);
+    auto          rows = DrainRows(lim, schema.get());
+    ExpectSameRIDs(rows, std::vector<Record>(expected.begin(), expected.begin() + limit));
+  }
+  auto exchange = MakeExchange(tbl, 1, 4, 1);
+  for (int round = 0; round < 3; ++round) {
+    exchange->Init();
+    for (int i = 0; i < round * 5 && !exchange->IsEnd(); ++i) {
+      exchange->Next();
+    }
+  }
+  ExpectSameRIDs(DrainRows(*exchange, schema.get()), expected);
+  exchange->Init();
+}
+
+/// a scan of records in memory that counts how many times it is initialized
+class CountingScanExecutor : public VecScanExecutor
+{
+public:
+  CountingScanExecutor(const RecordSchema *schema, const std::vector<Record> *records, std::atomic<int> *init_cnt)
+      : VecScanExecutor(schema, records), init_cnt_(init_cnt)
+  {}
+
+  void Init() override
+  {
+    init_cnt_->fetch_add(1);
+    VecScanExecutor::Init();
+  }
+
+private:
+  std::atomic<int> *init_cnt_;
+};
+
+/// pipelines probing one shared table with the rows of their morsels give the rows of a serial hash join
+TEST_F(ParallelScanTest, HashJoinProbe)
+{
+  auto tbl          = OpenTable(NARY_MODEL, 23);
+  auto build_schema = RecordSchema(std::vector<RTField>{MakeField("b_k", TYPE_INT, 4), MakeField("b_w", TYPE_INT, 4)});
+  std::vector<Record> build_records;
+  for (int i = 0; i < 200; ++i) {
+    // keys 0 to 79 two or three times, the probe keys 80 to 99 find nothing
+    build_records.emplace_back(&build_schema,
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(i % 80), ValueFactory::CreateIntValue(i)},
+        INVALID_RID);
+  }
+  auto probe_key = std::vector<RTField>{tbl->GetSchema().GetFieldAt(0)};
+  auto build_key = std::vector<RTField>{build_schema.GetFieldAt(0)};
+  for (auto [join_type, build_left] : {std::pair{INNER_JOIN, false}, {INNER_JOIN, true}, {OUTER_JOIN, false}}) {
+    std::atomic<int> init_cnt{0};
+    auto             make_join = [&](const PageRange *range, std::shared_ptr<HashJoinExecutor::SharedTable> table) {
+      auto probe = std::make_unique<SeqScanExecutor>(tbl, ConditionVec{}, std::vector<RTField>{}, range);
+      auto build = std::make_unique<CountingScanExecutor>(&build_schema, &build_records, &init_cnt);
+      auto left  = build_left ? AbstractExecutorUptr(std::move(build)) : AbstractExecutorUptr(std::move(probe));
+      auto right = build_left ? AbstractExecutorUptr(std::move(probe)) : AbstractExecutorUptr(std::move(build));
+      return std::make_unique<HashJoinExecutor>(join_type,
+          std::move(left),
+          std::move(right),
+          std::make_unique<RecordSchema>(build_left ? build_key : probe_key),
+          std::make_unique<RecordSchema>(build_left ? probe_key : build_key),
+          build_left,
+          HASH_JOIN_BUFFER_SIZE,
+          std::move(table));
+    };
+    auto serial   = make_join(nullptr, nullptr);
+    auto schema   = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+    auto expected = DrainBatches(*serial, BATCH_SIZE, schema.get());
+    ASSERT_GT(expected.size(), 0);
+    for (size_t worker_num : {1, 2, 4}) {
+      auto                          table = HashJoinExecutor::MakeSharedTable();
+      std::vector<ExchangePipeline> pipelines(worker_num);
+      for (auto &pipeline : pipelines) {
+        pipeline.range_ = std::make_unique<PageRange>();
+        pipeline.root_  = make_join(pipeline.range_.get(), table);
+      }
+      ExchangeExecutor exchange(tbl, std::move(pipelines), 2);
+      init_cnt = 0;
+      ASSERT_EQ(DrainRows(exchange, schema.get()), expected);
+      ASSERT_EQ(DrainBatches(exchange, 3, schema.get()), expected);
+      // built by the first pipeline only, and once for all the morsels
+      ASSERT_EQ(init_cnt, 1);
+    }
+  }
+}
+
+/// the groups merged from the workers are those of a serial aggregation with the same states, in an unspecified order
+TEST_F(ParallelScanTest, ParallelAggregate)
+{
+  auto tbl = OpenTable(NARY_MODEL, 23);
+  for (int group_by : {-1, 0, 2}) {
+    auto serial   = MakeAggregate(tbl, group_by, 0, 0);
+    auto schema   = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+    auto expected = SortRecords(DrainBatches(*serial, BATCH_SIZE, schema.get()));
+    ASSERT_GT(expected.size(), group_by < 0 ? 0 : 1);
+    for (size_t worker_num : {1, 2, 4}) {
+      for (size_t morsel_pages : {1, 3, 64}) {
+        auto parallel = MakeAggregate(tbl, group_by, worker_num, morsel_pages);
+        ASSERT_EQ(SortRecords(DrainRows(*parallel, schema.get())), expected);
+        ASSERT_EQ(SortRecords(DrainBatches(*parallel, 3, schema.get())), expected);
+      }
+    }
+  }
+  // no rows at all, there is still a row without group by
+  auto empty = OpenTable(NARY_MODEL, 0);
+  for (int group_by : {-1, 0}) {
+    auto serial   = MakeAggregate(empty, group_by, 0, 0);
+    auto schema   = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+    auto expected = DrainRows(*serial, schema.get());
+    ASSERT_EQ(expected.size(), group_by < 0 ? 1 : 0);
+    ASSERT_EQ(DrainRows(*MakeAggregate(empty, group_by, 2, 1), schema.get()), expected);
+  }
+}
+
+/// groups spilled by the workers have the same states as those of a serial aggregation
+TEST_F(ParallelScanTest, ParallelAggregateSpill)
+{
+  auto tbl = OpenTable(NARY_MODEL, 23);
+  for (int group_by : {0, 2}) {
+    auto serial   = MakeAggregate(tbl, group_by, 0, 0);
+    auto schema   = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+    auto expected = SortRecords(DrainBatches(*serial, BATCH_SIZE, schema.get()));
+    // the slots of a table take 4KB, so the smaller budgets spill every batch
+    for (size_t mem_budget : {size_t{1}, size_t{4096}, size_t{16 * 1024}}) {
+      auto spilled = MakeAggregate(tbl, group_by, 0, 0, mem_budget);
+      ASSERT_EQ(SortRecords(DrainBatches(*spilled, 3, schema.get())), expected);
+      for (size_t worker_num : {1, 2, 4}) {
+        auto parallel = MakeAggregate(tbl, group_by, worker_num, 3, mem_budget);
+        ASSERT_EQ(SortRecords(DrainRows(*parallel, schema.get())), expected);
+        ASSERT_EQ(SortRecords(DrainBatches(*parallel, 3, schema.get())), expected);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
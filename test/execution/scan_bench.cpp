@@ -0,0 +1,89 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+#include <iostream>
+#include "executor_test_util.h"
+#include "execution/worker_pool.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// SELECT t_s, count(*), ... FROM t WHERE t_k < 60 AND t_v >= 20 GROUP BY t_s with every worker of the pool against a
+/// serial aggregation
+TEST_F(ParallelScanTest, AggregateBench)
+{
+  auto worker_num = std::min(WorkerPool::GetMaxWorkers(), BUFFER_POOL_SIZE / 2);
+  auto tbl        = OpenTable(NARY_MODEL, 1000);
+  auto serial     = MakeAggregate(tbl, 2, 0, 0);
+  auto parallel   = MakeAggregate(tbl, 2, worker_num, MORSEL_PAGE_NUM);
+  auto schema     = std::make_unique<RecordSchema>(serial->GetOutSchema()->GetFields());
+  std::vector<Record> serial_rows;
+  std::vector<Record> parallel_rows;
+  auto                serial_ms   = TimeMs([&] { serial_rows = DrainBatches(*serial, BATCH_SIZE, schema.get()); });
+  auto                parallel_ms = TimeMs([&] { parallel_rows = DrainBatches(*parallel, BATCH_SIZE, schema.get()); });
+  ASSERT_EQ(SortRecords(parallel_rows), SortRecords(serial_rows));
+  std::cout << fmt::format("group {} pages into {} groups: serial {:.1f} ms, {} workers {:.1f} ms",
+                   tbl->GetTableHeader().page_num_,
+                   serial_rows.size(),
+                   serial_ms,
+                   worker_num,
+                   parallel_ms)
+            << std::endl;
+}
+
+/// SELECT count(*) FROM t WHERE t_k < 60 AND t_v >= 20 with every worker of the pool against a sequential scan
+TEST_F(ParallelScanTest, CountBench)
+{
+  auto count = [](AbstractExecutor &executor) {
+    size_t      cnt = 0;
+    RecordBatch batch(executor.GetOutSchema());
+    for (executor.Init(); executor.NextBatch(batch);) {
+      cnt += batch.GetSelSize();
+    }
+    return cnt;
+  };
+  auto worker_num = std::min(WorkerPool::GetMaxWorkers(), BUFFER_POOL_SIZE / 2);
+  for (auto model : {NARY_MODEL, PAX_MODEL}) {
+    auto   tbl          = OpenTable(model, 1000);
+    auto   serial       = MakePipeline(tbl, 0, nullptr);
+    auto   exchange     = MakeExchange(tbl, 0, worker_num, MORSEL_PAGE_NUM);
+    size_t serial_cnt   = 0;
+    size_t parallel_cnt = 0;
+    auto   serial_ms    = TimeMs([&] { serial_cnt = count(*serial); });
+    auto   parallel_ms  = TimeMs([&] { parallel_cnt = count(*exchange); });
+    ASSERT_EQ(parallel_cnt, serial_cnt);
+    std::cout << fmt::format("{} table of {} pages, {} rows: serial {:.1f} ms, exchange of {} workers {:.1f} ms",
+                     model == NARY_MODEL ? "nary" : "pax",
+                     tbl->GetTableHeader().page_num_,
+                     serial_cnt,
+                     serial_ms,
+                     worker_num,
+                     parallel_ms)
+              << std::endl;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,162 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/29.
+//
+
+#include <iostream>
+#include <thread>
+#include "common/config.h"
+#include "executor_test_util.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_sort.h"
+#include "execution/executor_topn.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+TEST(SortBench, LargerThanBudget)
+{
+  constexpr size_t BENCH_ROWS = 2000000;
+  auto             schema     = MakeSortSchema();
+  auto             records    = GenSortRecords(schema.get(), BENCH_ROWS, 1 << 30);
+  auto             row_size   = BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength();
+  auto             run        = [&](size_t mem_budget) {
+    SortExecutor sort(std::make_unique<VecScanExecutor>(schema.get(), &records),
+        std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(0)}),
+        false,
+        mem_budget);
+    RecordBatch batch(sort.GetOutSchema());
+    size_t      row_num = 0;
+    Scalar      last;
+    for (sort.Init(); sort.NextBatch(batch);) {
+      for (size_t i = 0; i < batch.GetSelSize(); ++i, ++row_num) {
+        auto key = batch.GetRow(i).GetScalarAt(0);
+        ASSERT_TRUE(row_num == 0 || last.IsNull() || (!key.IsNull() && Scalar::Compare(last, key) <= 0));
+        last = key;
+      }
+    }
+    ASSERT_EQ(row_num, BENCH_ROWS);
+  };
+  auto mem_ms = TimeMs([&] { run(SORT_BUFFER_SIZE * 4); });
+  std::cout << fmt::format("sort {} rows of {} bytes in memory: {:.1f} ms", BENCH_ROWS, row_size, mem_ms) << std::endl;
+  // tens of runs merged in a few passes
+  for (size_t mem_budget : {BENCH_ROWS * row_size / 16, size_t{2 * 1024 * 1024}}) {
+    auto ms = TimeMs([&] { run(mem_budget); });
+    std::cout << fmt::format("sort {} rows with a {} KB budget: {:.1f} ms", BENCH_ROWS, mem_budget / 1024, ms)
+              << std::endl;
+  }
+}
+
+TEST(SortBench, Parallel)
+{
+  constexpr size_t BENCH_ROWS = 2000000;
+  auto             schema     = MakeSortSchema();
+  auto             records    = GenSortRecords(schema.get(), BENCH_ROWS, 1 << 30);
+  auto             run        = [&](size_t thread_num) {
+    SortExecutor sort(std::make_unique<VecScanExecutor>(schema.get(), &records),
+        std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(0), schema->GetFieldAt(2)}),
+        false,
+        SORT_BUFFER_SIZE * 4,
+        thread_num);
+    RecordBatch batch(sort.GetOutSchema());
+    size_t      row_num = 0;
+    for (sort.Init(); sort.NextBatch(batch);) {
+      row_num += batch.GetSelSize();
+    }
+    ASSERT_EQ(row_num, BENCH_ROWS);
+  };
+  auto base_ms = TimeMs([&] { run(1); });
+  std::cout << fmt::format("sort {} rows in memory with 1 thread: {:.1f} ms", BENCH_ROWS, base_ms) << std::endl;
+  for (size_t thread_num = 2; thread_num <= std::max(std::thread::hardware_concurrency(), 4U); thread_num *= 2) {
+    auto ms = TimeMs([&] { run(thread_num); });
+    std::cout << fmt::format("sort {} rows in memory with {} threads: {:.1f} ms, {:.2f}x",
+                     BENCH_ROWS,
+                     thread_num,
+                     ms,
+                     base_ms / ms)
+              << std::endl;
+  }
+}
+
+TEST(SortBench, TopN)
+{
+  constexpr size_t BENCH_ROWS = 2000000;
+  constexpr size_t LIMIT      = 100;
+  auto             schema     = MakeSortSchema();
+  auto             records    = GenSortRecords(schema.get(), BENCH_ROWS, 1 << 30);
+  auto             key_schema = [&schema] {
+    return std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(0)});
+  };
+
+  std::vector<std::string> sort_rows;
+  std::vector<std::string> top_n_rows;
+
+  auto sort_ms  = TimeMs([&] {
+    LimitExecutor limit(
+        std::make_unique<SortExecutor>(std::make_unique<VecScanExecutor>(schema.get(), &records), key_schema(), false),
+        LIMIT);
+    sort_rows = CollectRows(limit);
+  });
+  auto top_n_ms = TimeMs([&] {
+    TopNExecutor top_n(std::make_unique<VecScanExecutor>(schema.get(), &records), key_schema(), false, LIMIT);
+    top_n_rows = CollectRows(top_n);
+  });
+  ASSERT_EQ(top_n_rows, sort_rows);
+  std::cout << fmt::format("first {} of {} rows, limit over sort: {:.1f} ms, top-n: {:.1f} ms",
+                   LIMIT,
+                   BENCH_ROWS,
+                   sort_ms,
+                   top_n_ms)
+            << std::endl;
+}
+
+TEST(SortBench, CourseKeys)
+{
+  constexpr size_t BENCH_ROWS = 2000000;
+  auto             schema     = MakeCourseSchema();
+  auto             records    = GenCourseRecords(schema.get(), BENCH_ROWS);
+  // the order by clauses of test/sql/lab02, the last key is too long to be radix sorted
+  for (const auto &[name, key_fields] : std::vector<std::pair<std::string, std::vector<RTField>>>{
+           {"id", {schema->GetFieldAt(0)}},
+           {"age, id", {schema->GetFieldAt(2), schema->GetFieldAt(0)}},
+           {"l2_score, id", {schema->GetFieldAt(6), schema->GetFieldAt(0)}},
+           {"name, id", {schema->GetFieldAt(1), schema->GetFieldAt(0)}}}) {
+    auto ms = TimeMs([&] {
+      SortExecutor sort(std::make_unique<VecScanExecutor>(schema.get(), &records),
+          std::make_unique<RecordSchema>(key_fields),
+          false,
+          SORT_BUFFER_SIZE * 4,
+          1);
+      RecordBatch batch(sort.GetOutSchema());
+      size_t      row_num = 0;
+      for (sort.Init(); sort.NextBatch(batch);) {
+        row_num += batch.GetSelSize();
+      }
+      ASSERT_EQ(row_num, BENCH_ROWS);
+    });
+    std::cout << fmt::format("sort {} rows by {}: {:.1f} ms", BENCH_ROWS, name, ms) << std::endl;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
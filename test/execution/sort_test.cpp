@@ -0,0 +1,209 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/29.
+//
+
+#include <algorithm>
+#include "common/config.h"
+#include "executor_test_util.h"
+#include "execution/executor_sort.h"
+#include "execution/executor_topn.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// the key of every row and the multiset of rows, which are the same for any correct sort
+auto CollectSorted(AbstractExecutor &executor, const RecordSchema *key_schema, bool use_batch)
+    -> std::pair<std::vector<std::string>, std::vector<std::string>>
+{
+  std::vector<std::string> keys;
+  std::vector<std::string> rows;
+  auto                     add = [&](const RecordView &row) {
+    std::string key;
+    for (const auto &field : key_schema->GetFields()) {
+      key += row.GetScalarAt(row.GetSchema()->GetRTFieldIndex(field)).ToString() + "|";
+    }
+    keys.push_back(std::move(key));
+    std::string str;
+    for (size_t i = 0; i < row.GetSchema()->GetFieldCount(); ++i) {
+      str += row.GetScalarAt(i).ToString() + "|";
+    }
+    rows.push_back(std::move(str));
+  };
+  if (use_batch) {
+    RecordBatch batch(executor.GetOutSchema(), 333);
+    for (executor.Init(); executor.NextBatch(batch);) {
+      for (size_t i = 0; i < batch.GetSelSize(); ++i) {
+        add(batch.GetRow(i));
+      }
+    }
+  } else {
+    for (executor.Init(); !executor.IsEnd(); executor.Next()) {
+      add(executor.GetRecordView());
+    }
+  }
+  std::sort(rows.begin(), rows.end());
+  return {keys, rows};
+}
+
+TEST(ExternalSort, MatchesInMemory)
+{
+  auto schema    = MakeSortSchema();
+  auto records   = GenSortRecords(schema.get(), 30000, 500);
+  auto tmp_files = CountTmpFiles();
+  // sort on (k, s), and on v alone
+  for (const auto &key_fields : {std::vector<RTField>{schema->GetFieldAt(0), schema->GetFieldAt(2)},
+           std::vector<RTField>{schema->GetFieldAt(1)}}) {
+    for (bool is_desc : {false, true}) {
+      auto make_sort = [&](size_t mem_budget) {
+        return std::make_unique<SortExecutor>(std::make_unique<VecScanExecutor>(schema.get(), &records),
+            std::make_unique<RecordSchema>(key_fields),
+            is_desc,
+            mem_budget);
+      };
+      auto key_schema = std::make_unique<RecordSchema>(key_fields);
+      auto in_memory  = make_sort(SORT_BUFFER_SIZE);
+      auto expected   = CollectSorted(*in_memory, key_schema.get(), false);
+      ASSERT_EQ(expected.first.size(), records.size());
+      // budgets under a block merge 2 runs at a time, a budget of a few hundred rows makes about a hundred runs that
+      // take many passes, the larger ones make a few runs and merge them in one or two passes
+      for (size_t mem_budget : {size_t{16 * 1024}, size_t{256 * 1024}, size_t{1024 * 1024}}) {
+        for (bool use_batch : {false, true}) {
+          auto sort = make_sort(mem_budget);
+          ASSERT_EQ(CollectSorted(*sort, key_schema.get(), use_batch), expected)
+              << "budget " << mem_budget << " desc " << is_desc << " batch " << use_batch;
+        }
+      }
+    }
+  }
+  ASSERT_EQ(CountTmpFiles(), tmp_files);
+}
+
+TEST(ParallelSort, MatchesSingleThread)
+{
+  auto schema  = MakeSortSchema();
+  auto records = GenSortRecords(schema.get(), 200000, 5000);
+  for (bool is_desc : {false, true}) {
+    // in memory the rows are split into a dozen chunks, under the smaller budget every run is split into a few
+    for (size_t mem_budget : {SORT_BUFFER_SIZE, size_t{4 * 1024 * 1024}}) {
+      auto make_sort = [&](size_t thread_num) {
+        return std::make_unique<SortExecutor>(std::make_unique<VecScanExecutor>(schema.get(), &records),
+            std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(0), schema->GetFieldAt(2)}),
+            is_desc,
+            mem_budget,
+            thread_num);
+      };
+      auto expected = CollectRows(*make_sort(1));
+      ASSERT_EQ(expected.size(), records.size());
+      // equal keys keep the order of the input, so any number of threads returns the same sequence of rows
+      for (size_t thread_num : {2, 3, 4, 7, 16}) {
+        ASSERT_EQ(CollectRows(*make_sort(thread_num)), expected)
+            << "threads " << thread_num << " budget " << mem_budget << " desc " << is_desc;
+      }
+    }
+  }
+}
+
+/// the rows sorted on their normalized keys by std::stable_sort
+auto StableSortRows(const std::vector<Record> &records, const RecordSchema *key_schema, bool is_desc)
+    -> std::vector<std::string>
+{
+  KeyNormalizer            key_norm(key_schema, records.front().GetSchema(), is_desc);
+  std::vector<std::string> keys;
+  std::vector<size_t>      order(records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    std::string key(key_norm.GetKeySize(), '\0');
+    key_norm.Encode(records[i], key.data());
+    keys.push_back(std::move(key));
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) { return keys[l] < keys[r]; });
+  std::vector<std::string> rows;
+  for (auto idx : order) {
+    std::string str;
+    for (size_t i = 0; i < records[idx].GetSchema()->GetFieldCount(); ++i) {
+      str += records[idx].GetScalarAt(i).ToString() + "|";
+    }
+    rows.push_back(std::move(str));
+  }
+  return rows;
+}
+
+TEST(RadixSort, MatchesStableSort)
+{
+  auto schema  = MakeCourseSchema();
+  auto records = GenCourseRecords(schema.get(), 100000);
+  // keys of one and two words on the radix path, with nulls, negative numbers and bytes equal in every row, and a key
+  // with a string that is sorted by comparison
+  for (const auto &key_fields : {std::vector<RTField>{schema->GetFieldAt(0)},
+           std::vector<RTField>{schema->GetFieldAt(2)},
+           std::vector<RTField>{schema->GetFieldAt(2), schema->GetFieldAt(0)},
+           std::vector<RTField>{schema->GetFieldAt(6), schema->GetFieldAt(4)},
+           std::vector<RTField>{schema->GetFieldAt(1), schema->GetFieldAt(2)}}) {
+    auto key_schema = std::make_unique<RecordSchema>(key_fields);
+    for (bool is_desc : {false, true}) {
+      auto expected = StableSortRows(records, key_schema.get(), is_desc);
+      for (size_t thread_num : {1, 4}) {
+        SortExecutor sort(std::make_unique<VecScanExecutor>(schema.get(), &records),
+            std::make_unique<RecordSchema>(key_fields),
+            is_desc,
+            SORT_BUFFER_SIZE,
+            thread_num);
+        ASSERT_EQ(CollectRows(sort), expected)
+            << key_schema->ToString() << " desc " << is_desc << " threads " << thread_num;
+      }
+    }
+  }
+}
+
+TEST(TopN, MatchesSortLimit)
+{
+  auto schema    = MakeSortSchema();
+  auto records   = GenSortRecords(schema.get(), 30000, 500);
+  auto tmp_files = CountTmpFiles();
+  for (const auto &key_fields : {std::vector<RTField>{schema->GetFieldAt(0), schema->GetFieldAt(2)},
+           std::vector<RTField>{schema->GetFieldAt(1)}}) {
+    for (bool is_desc : {false, true}) {
+      SortExecutor sort(std::make_unique<VecScanExecutor>(schema.get(), &records),
+          std::make_unique<RecordSchema>(key_fields),
+          is_desc);
+      auto sorted = CollectRows(sort);
+      // many rows share a key, the rows kept at the limit must be the ones read first as in the sort
+      for (size_t limit : {0, 1, 10, 999, 30000, 50000}) {
+        auto expected = std::vector<std::string>(sorted.begin(), sorted.begin() + std::min(limit, sorted.size()));
+        for (bool use_batch : {false, true}) {
+          TopNExecutor top_n(std::make_unique<VecScanExecutor>(schema.get(), &records),
+              std::make_unique<RecordSchema>(key_fields),
+              is_desc,
+              limit);
+          ASSERT_EQ(CollectRows(top_n, use_batch), expected)
+              << "limit " << limit << " desc " << is_desc << " batch " << use_batch;
+        }
+      }
+    }
+  }
+  ASSERT_EQ(CountTmpFiles(), tmp_files);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
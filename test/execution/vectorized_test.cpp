@@ -0,0 +1,382 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/8/25.
+//
+
+#include "../config.h"
+#include "executor_test_util.h"
+#include "execution/executor_filter.h"
+#include "execution/executor_join_hash.h"
+#include "execution/executor_join_nestedloop.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_materialize.h"
+#include "execution/executor_projection.h"
+#include "execution/executor_seqscan.h"
+#include "execution/executor_sort.h"
+#include "storage/storage.h"
+#include "system/table/table_manager.h"
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// a scan that only implements the row interface, batches come from the default adapter
+class RowScanExecutor : public VecScanExecutor
+{
+public:
+  using VecScanExecutor::VecScanExecutor;
+
+  auto NextBatch(RecordBatch &batch) -> bool override { return AbstractExecutor::NextBatch(batch); }
+
+  [[nodiscard]] auto IsVectorized() const -> bool override { return false; }
+};
+
+auto GenRecords(const RecordSchema *schema, size_t n, int key_range) -> std::vector<Record>
+{
+  std::vector<Record> records;
+  for (size_t i = 0; i < n; ++i) {
+    auto name = fmt::format("name_{}", rand() % 100);
+    records.emplace_back(schema,
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(rand() % key_range),
+            i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT)
+                       : ValueFactory::CreateFloatValue(static_cast<float>(rand() % 1000) / 10),
+            ValueFactory::CreateStringValue(name.c_str(), name.size())},
+        INVALID_RID);
+  }
+  return records;
+}
+
+auto MakeSchema(const std::string &prefix) -> RecordSchemaUptr
+{
+  return std::make_unique<RecordSchema>(std::vector<RTField>{MakeField(prefix + "_k", TYPE_INT, 4),
+      MakeField(prefix + "_v", TYPE_FLOAT, 4),
+      MakeField(prefix + "_s", TYPE_STRING, 12)});
+}
+
+TEST(Vectorized, FilterProjectLimit)
+{
+  auto schema  = MakeSchema("t");
+  auto records = GenRecords(schema.get(), 5000, 100);
+  // t_k < 60 AND t_v >= 20, then keep (t_s, t_k) and the first 1234 rows
+  ValueSptr    k_val = ValueFactory::CreateIntValue(60);
+  ValueSptr    v_val = ValueFactory::CreateIntValue(20);
+  ConditionVec conds;
+  conds.emplace_back(OP_LT, schema->GetFieldAt(0), k_val);
+  conds.emplace_back(OP_GE, schema->GetFieldAt(1), v_val);
+  auto make_plan = [&](AbstractExecutorUptr scan) -> AbstractExecutorUptr {
+    auto proj_schema =
+        std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(2), schema->GetFieldAt(0)});
+    auto filter = std::make_unique<FilterExecutor>(std::move(scan), Predicate(conds, schema.get()));
+    auto proj   = std::make_unique<ProjectionExecutor>(std::move(filter), std::move(proj_schema));
+    return std::make_unique<LimitExecutor>(std::move(proj), 1234);
+  };
+  // records reference the out schema of the plan, keep it alive
+  auto row_plan = make_plan(std::make_unique<VecScanExecutor>(schema.get(), &records));
+  auto expected = DrainRows(*row_plan);
+  ASSERT_EQ(expected.size(), 1234);
+  for (size_t capacity : {size_t{1}, size_t{7}, BATCH_SIZE}) {
+    auto plan = make_plan(std::make_unique<VecScanExecutor>(schema.get(), &records));
+    ASSERT_TRUE(plan->IsVectorized());
+    ASSERT_EQ(DrainBatches(*plan, capacity, row_plan->GetOutSchema()), expected);
+  }
+  // a child without native batches is adapted
+  auto plan = make_plan(std::make_unique<RowScanExecutor>(schema.get(), &records));
+  ASSERT_FALSE(plan->IsVectorized());
+  ASSERT_EQ(DrainBatches(*plan, 100, row_plan->GetOutSchema()), expected);
+}
+
+/// rows streamed through the row interface leave nothing behind in the statement arena
+TEST(Vectorized, ProjectionArena)
+{
+  auto schema      = MakeSchema("t");
+  auto records     = GenRecords(schema.get(), 5000, 100);
+  auto proj_schema = std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(2), schema->GetFieldAt(0)});
+  auto proj = std::make_unique<ProjectionExecutor>(
+      std::make_unique<RowScanExecutor>(schema.get(), &records), std::move(proj_schema));
+  Arena      arena;
+  ArenaScope scope(&arena);
+  size_t     row_num = 0;
+  for (proj->Init(); !proj->IsEnd(); proj->Next(), ++row_num) {
+    auto record = proj->GetRecord();
+    ASSERT_EQ(record->GetScalarAt(1).ToString(), records[row_num].GetScalarAt(0).ToString());
+    ASSERT_EQ(record->GetScalarAt(0).ToString(), records[row_num].GetScalarAt(2).ToString());
+  }
+  ASSERT_EQ(row_num, records.size());
+  ASSERT_EQ(arena.GetAllocatedBytes(), 0);
+}
+
+TEST(Vectorized, NestedLoopJoin)
+{
+  auto left_schema   = MakeSchema("l");
+  auto right_schema  = MakeSchema("r");
+  auto left_records  = GenRecords(left_schema.get(), 300, 50);
+  auto right_records = GenRecords(right_schema.get(), 200, 50);
+  // l_k = r_k AND l_v > 30
+  ValueSptr    v_val = ValueFactory::CreateIntValue(30);
+  ConditionVec conds;
+  conds.emplace_back(OP_EQ, left_schema->GetFieldAt(0), right_schema->GetFieldAt(0));
+  conds.emplace_back(OP_GT, left_schema->GetFieldAt(1), v_val);
+  auto make_plan = [&]() {
+    return std::make_unique<NestedLoopJoinExecutor>(INNER_JOIN,
+        std::make_unique<VecScanExecutor>(left_schema.get(), &left_records),
+        std::make_unique<VecScanExecutor>(right_schema.get(), &right_records),
+        conds);
+  };
+  size_t expected_cnt = 0;
+  for (const auto &l : left_records) {
+    for (const auto &r : right_records) {
+      auto lv = l.GetScalarAt(1);
+      expected_cnt += !lv.IsNull() && lv.GetFloat() > 30 && l.GetScalarAt(0).GetInt() == r.GetScalarAt(0).GetInt();
+    }
+  }
+  auto row_plan = make_plan();
+  auto expected = DrainRows(*row_plan);
+  ASSERT_EQ(expected.size(), expected_cnt);
+  for (const auto &rec : expected) {
+    ASSERT_EQ(rec.GetScalarAt(0).GetInt(), rec.GetScalarAt(3).GetInt());
+  }
+  for (size_t capacity : {size_t{5}, BATCH_SIZE}) {
+    auto plan = make_plan();
+    ASSERT_TRUE(plan->IsVectorized());
+    ASSERT_EQ(DrainBatches(*plan, capacity, row_plan->GetOutSchema()), expected);
+  }
+}
+
+TEST(Vectorized, HashJoin)
+{
+  auto left_schema   = MakeSchema("l");
+  auto right_schema  = MakeSchema("r");
+  auto left_records  = GenRecords(left_schema.get(), 500, 80);
+  auto right_records = GenRecords(right_schema.get(), 300, 60);
+  auto make_scan     = [](const RecordSchemaUptr &schema, const std::vector<Record> &records) {
+    return std::make_unique<VecScanExecutor>(schema.get(), &records);
+  };
+  // l_k = r_k, and l_k = r_k AND l_v = r_v where null values are equal
+  for (size_t key_num : {1, 2}) {
+    ConditionVec         conds;
+    std::vector<RTField> left_keys;
+    std::vector<RTField> right_keys;
+    for (size_t i = 0; i < key_num; ++i) {
+      conds.emplace_back(OP_EQ, left_schema->GetFieldAt(i), right_schema->GetFieldAt(i));
+      left_keys.push_back(left_schema->GetFieldAt(i));
+      right_keys.push_back(right_schema->GetFieldAt(i));
+    }
+    auto make_plan = [&](JoinType join_type, bool build_left) {
+      return std::make_unique<HashJoinExecutor>(join_type,
+          make_scan(left_schema, left_records),
+          make_scan(right_schema, right_records),
+          std::make_unique<RecordSchema>(left_keys),
+          std::make_unique<RecordSchema>(right_keys),
+          build_left);
+    };
+    // inner join, building on the right keeps the order of nested loop join
+    NestedLoopJoinExecutor nlj(
+        INNER_JOIN, make_scan(left_schema, left_records), make_scan(right_schema, right_records), conds);
+    auto expected = DrainRows(nlj);
+    ASSERT_FALSE(expected.empty());
+    for (bool build_left : {false, true}) {
+      auto plan = make_plan(INNER_JOIN, build_left);
+      ASSERT_TRUE(plan->IsVectorized());
+      auto rows = DrainRows(*plan, nlj.GetOutSchema());
+      ASSERT_EQ(build_left ? SortRecords(rows) : rows, build_left ? SortRecords(expected) : expected);
+      for (size_t capacity : {size_t{1}, size_t{7}, BATCH_SIZE}) {
+        auto batches = DrainBatches(*plan, capacity, nlj.GetOutSchema());
+        ASSERT_EQ(build_left ? SortRecords(batches) : batches, build_left ? SortRecords(expected) : expected);
+      }
+    }
+    // left outer join, left rows without a match are joined with nulls
+    auto                outer = make_plan(OUTER_JOIN, false);
+    std::vector<Record> outer_expected;
+    Record              null_rec(right_schema.get());
+    for (const auto &l : left_records) {
+      auto matched = false;
+      for (const auto &r : right_records) {
+        auto eq = true;
+        for (size_t i = 0; i < key_num; ++i) {
+          eq = eq && Scalar::Eval(OP_EQ, l.GetScalarAt(i), r.GetScalarAt(i));
+        }
+        if (eq) {
+          outer_expected.emplace_back(outer->GetOutSchema(), l, r);
+          matched = true;
+        }
+      }
+      if (!matched) {
+        outer_expected.emplace_back(outer->GetOutSchema(), l, null_rec);
+      }
+    }
+    ASSERT_GT(outer_expected.size(), expected.size());
+    ASSERT_EQ(DrainRows(*outer), outer_expected);
+    ASSERT_EQ(DrainBatches(*outer, 5, outer->GetOutSchema()), outer_expected);
+    auto outer_left = make_plan(OUTER_JOIN, true);
+    ASSERT_EQ(SortRecords(DrainRows(*outer_left, outer->GetOutSchema())), SortRecords(outer_expected));
+    for (size_t capacity : {size_t{3}, BATCH_SIZE}) {
+      ASSERT_EQ(SortRecords(DrainBatches(*outer_left, capacity, outer->GetOutSchema())), SortRecords(outer_expected));
+    }
+  }
+}
+
+TEST(Vectorized, Sort)
+{
+  auto schema     = MakeSchema("t");
+  auto records    = GenRecords(schema.get(), 3000, 1000);
+  auto make_plan  = [&]() {
+    auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{schema->GetFieldAt(0)});
+    return std::make_unique<SortExecutor>(
+        std::make_unique<VecScanExecutor>(schema.get(), &records), std::move(key_schema), false);
+  };
+  auto expected = DrainRows(*make_plan());
+  ASSERT_EQ(expected.size(), records.size());
+  ASSERT_EQ(DrainBatches(*make_plan(), 64, schema.get()), expected);
+}
+
+TEST(Vectorized, SeqScan)
+{
+  auto disk_manager        = std::make_unique<DiskManager>();
+  auto buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  for (auto model : {NARY_MODEL, PAX_MODEL}) {
+    std::string     table_name = fmt::format("vectorized_seqscan_{}", static_cast<int>(model));
+    auto            tbl        = MakeTable(table_manager.get(), table_name, model, 21);
+    SeqScanExecutor scan(tbl.get());
+    auto            expected = DrainRows(scan);
+    ASSERT_EQ(expected.size(), tbl->GetTableHeader().rec_num_);
+    for (size_t capacity : {size_t{3}, BATCH_SIZE}) {
+      auto batches = DrainBatches(scan, capacity, &tbl->GetSchema());
+      ASSERT_EQ(batches, expected);
+      for (size_t i = 0; i < batches.size(); ++i) {
+        ASSERT_EQ(batches[i].GetRID(), expected[i].GetRID());
+      }
+    }
+    table_manager->CloseTable(TEST_DIR, *tbl);
+    table_manager->DropTable(TEST_DIR, table_name);
+  }
+}
+
+/// conditions and projection evaluated inside the scan give the same rows as filter and projection above it
+TEST(Vectorized, SeqScanPushdown)
+{
+  auto disk_manager        = std::make_unique<DiskManager>();
+  auto buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  for (auto model : {NARY_MODEL, PAX_MODEL}) {
+    std::string table_name = fmt::format("vectorized_pushdown_{}", static_cast<int>(model));
+    auto        tbl        = MakeTable(table_manager.get(), table_name, model, 21);
+    const auto &schema     = tbl->GetSchema();
+    // t_k < 60 AND t_v >= 20 AND t_s <> 'name_7', then keep (t_s, t_k)
+    ValueSptr    k_val = ValueFactory::CreateIntValue(60);
+    ValueSptr    v_val = ValueFactory::CreateIntValue(20);
+    ValueSptr    s_val = ValueFactory::CreateStringValue("name_7", 6);
+    ConditionVec conds;
+    conds.emplace_back(OP_LT, schema.GetFieldAt(0), k_val);
+    conds.emplace_back(OP_GE, schema.GetFieldAt(1), v_val);
+    conds.emplace_back(OP_NE, schema.GetFieldAt(2), s_val);
+    auto fields      = std::vector<RTField>{schema.GetFieldAt(2), schema.GetFieldAt(0)};
+    auto proj_schema = std::make_unique<RecordSchema>(fields);
+
+    FilterExecutor filter(std::make_unique<SeqScanExecutor>(tbl.get()), Predicate(conds, &schema));
+    auto           expected = std::vector<Record>{};
+    for (const auto &rec : DrainRows(filter)) {
+      expected.emplace_back(proj_schema.get(), rec);
+      expected.back().SetRID(rec.GetRID());
+    }
+    ASSERT_GT(expected.size(), 0);
+
+    for (const auto &scan_fields : {fields, std::vector<RTField>{}}) {
+      SeqScanExecutor scan(tbl.get(), conds, scan_fields);
+      auto            rows = std::vector<Record>{};
+      for (scan.Init(); !scan.IsEnd(); scan.Next()) {
+        rows.emplace_back(proj_schema.get(), scan.GetRecordView());
+        ASSERT_LE(rows.size(), expected.size());
+        ASSERT_EQ(scan.GetRecordView().GetRID(), expected[rows.size() - 1].GetRID());
+      }
+      ASSERT_EQ(rows, expected);
+      if (scan_fields.empty()) {
+        continue;
+      }
+      for (size_t capacity : {size_t{3}, BATCH_SIZE}) {
+        auto batches = DrainBatches(scan, capacity, proj_schema.get());
+        ASSERT_EQ(batches, expected);
+        for (size_t i = 0; i < batches.size(); ++i) {
+          ASSERT_EQ(batches[i].GetRID(), expected[i].GetRID());
+        }
+      }
+    }
+    table_manager->CloseTable(TEST_DIR, *tbl);
+    table_manager->DropTable(TEST_DIR, table_name);
+  }
+}
+
+/// the scan and a filter above it only see (t_k, t_v), t_s is fetched by RID for the rows that pass both
+TEST(Vectorized, LateMaterialize)
+{
+  auto disk_manager        = std::make_unique<DiskManager>();
+  auto buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  for (auto model : {NARY_MODEL, PAX_MODEL}) {
+    std::string  table_name = fmt::format("vectorized_late_{}", static_cast<int>(model));
+    auto         tbl        = MakeTable(table_manager.get(), table_name, model, 21);
+    const auto  &schema     = tbl->GetSchema();
+    ValueSptr    k_val      = ValueFactory::CreateIntValue(60);
+    ValueSptr    v_val      = ValueFactory::CreateIntValue(20);
+    ConditionVec scan_conds;
+    scan_conds.emplace_back(OP_LT, schema.GetFieldAt(0), k_val);
+    ConditionVec filter_conds;
+    filter_conds.emplace_back(OP_GE, schema.GetFieldAt(1), v_val);
+    ConditionVec all_conds = scan_conds;
+    all_conds.insert(all_conds.end(), filter_conds.begin(), filter_conds.end());
+    auto narrow_fields = std::vector<RTField>{schema.GetFieldAt(0), schema.GetFieldAt(1)};
+    auto out_fields    = std::vector<RTField>{schema.GetFieldAt(2), schema.GetFieldAt(0), schema.GetFieldAt(1)};
+    auto out_schema    = std::make_unique<RecordSchema>(out_fields);
+
+    SeqScanExecutor early(tbl.get(), all_conds, out_fields);
+    auto            expected = DrainBatches(early, BATCH_SIZE, out_schema.get());
+    ASSERT_GT(expected.size(), 0);
+
+    auto make_plan = [&]() {
+      auto scan   = std::make_unique<SeqScanExecutor>(tbl.get(), scan_conds, narrow_fields);
+      auto pred   = Predicate(filter_conds, scan->GetOutSchema());
+      auto filter = std::make_unique<FilterExecutor>(std::move(scan), std::move(pred));
+      return std::make_unique<MaterializeExecutor>(
+          std::move(filter), tbl.get(), std::make_unique<RecordSchema>(out_fields));
+    };
+    auto late = make_plan();
+    auto rows = std::vector<Record>{};
+    for (late->Init(); !late->IsEnd(); late->Next()) {
+      rows.emplace_back(out_schema.get(), late->GetRecordView());
+      ASSERT_LE(rows.size(), expected.size());
+      ASSERT_EQ(late->GetRecordView().GetRID(), expected[rows.size() - 1].GetRID());
+    }
+    ASSERT_EQ(rows, expected);
+    for (size_t capacity : {size_t{3}, BATCH_SIZE}) {
+      auto batches = DrainBatches(*late, capacity, out_schema.get());
+      ASSERT_EQ(batches, expected);
+      for (size_t i = 0; i < batches.size(); ++i) {
+        ASSERT_EQ(batches[i].GetRID(), expected[i].GetRID());
+      }
+    }
+    table_manager->CloseTable(TEST_DIR, *tbl);
+    table_manager->DropTable(TEST_DIR, table_name);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
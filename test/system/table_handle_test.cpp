@@ -6,9 +6,13 @@
 #include "common/types.h"
 #include "storage/storage.h"
 #include "system/handle/table_handle.h"
+#include "system/handle/record_comparator.h"
+#include "system/handle/key_normalizer.h"
 #include "system/table/table_manager.h"
 
 #include <cassert>
+#include <cmath>
+#include <set>
 #include <unordered_map>
 #include <vector>
 #include <unordered_set>
@@ -68,6 +72,8 @@ TEST(TableHandle, Simple)
     std::filesystem::create_directory(TEST_DIR);
   if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
     std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
   auto tbl_schema = GenTableSchema(10);
   table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
   auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
@@ -106,6 +112,451 @@ TEST(TableHandle, Simple)
   table_manager->DropTable(TEST_DIR, table_name);
 }
 
+TEST(TableHandle, BatchInsert)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_batch_insert";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  // leave some holes in the first pages so that the batch has to fill partially used pages first
+  std::vector<RID> single_rids;
+  for (int i = 0; i < 200; ++i) {
+    auto record = GenRecordUnderSchema(tbl->GetSchema());
+    single_rids.push_back(tbl->InsertRecord(*record));
+  }
+  for (size_t i = 0; i < single_rids.size(); i += 3) {
+    tbl->DeleteRecord(single_rids[i]);
+  }
+  std::vector<Record> records;
+  for (int i = 0; i < 5000; ++i) {
+    records.emplace_back(*GenRecordUnderSchema(tbl->GetSchema()));
+  }
+  auto rec_num = tbl->GetTableHeader().rec_num_;
+  auto rids    = tbl->InsertRecords(records);
+  ASSERT_EQ(rids.size(), records.size());
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, rec_num + records.size());
+  std::unordered_set<RID> rid_set(rids.begin(), rids.end());
+  ASSERT_EQ(rid_set.size(), rids.size());
+  for (size_t i = 0; i < rids.size(); ++i) {
+    auto record = tbl->GetRecord(rids[i]);
+    ASSERT_TRUE(*record == records[i]);
+  }
+  // batch and single inserts should share the free page list
+  auto record = GenRecordUnderSchema(tbl->GetSchema());
+  auto rid    = tbl->InsertRecord(*record);
+  ASSERT_TRUE(rid_set.find(rid) == rid_set.end());
+  ASSERT_TRUE(*tbl->GetRecord(rid) == *record);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, FreeSpaceMap)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_free_space_map";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  // fill whole pages so that the only free slots are the ones deleted below
+  std::vector<Record> records;
+  for (size_t i = 0; i < 20 * tbl->GetTableHeader().rec_per_page_; ++i) {
+    records.emplace_back(*GenRecordUnderSchema(tbl->GetSchema()));
+  }
+  auto rids     = tbl->InsertRecords(records);
+  auto page_num = tbl->GetTableHeader().page_num_;
+  // free slots scattered over all pages should be found again without allocating new pages
+  std::unordered_set<RID> deleted;
+  for (size_t i = 0; i < rids.size(); i += 7) {
+    tbl->DeleteRecord(rids[i]);
+    deleted.insert(rids[i]);
+  }
+  for (size_t i = 0; i < deleted.size(); ++i) {
+    auto record = GenRecordUnderSchema(tbl->GetSchema());
+    auto rid    = tbl->InsertRecord(*record);
+    ASSERT_TRUE(deleted.find(rid) != deleted.end());
+    ASSERT_TRUE(*tbl->GetRecord(rid) == *record);
+  }
+  ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num);
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, records.size());
+  // all pages are full now
+  auto record = GenRecordUnderSchema(tbl->GetSchema());
+  tbl->InsertRecord(*record);
+  ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num + 1);
+  // the map survives reopening the table
+  tbl->DeleteRecord(rids.front());
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  // the search may start past the deleted slot, so fill every free slot left and look for the deleted one
+  bool found = false;
+  for (size_t i = 0; i < tbl->GetTableHeader().rec_per_page_; ++i) {
+    found |= tbl->InsertRecord(*record) == rids.front();
+  }
+  ASSERT_TRUE(found);
+  ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num + 1);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, RebuildFreeSpaceMap)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_rebuild_free_space_map";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  std::vector<Record> records;
+  for (size_t i = 0; i < 5 * tbl->GetTableHeader().rec_per_page_; ++i) {
+    records.emplace_back(*GenRecordUnderSchema(tbl->GetSchema()));
+  }
+  auto                    rids     = tbl->InsertRecords(records);
+  auto                    page_num = tbl->GetTableHeader().page_num_;
+  std::unordered_set<RID> deleted;
+  for (size_t i = 0; i < rids.size(); i += 5) {
+    tbl->DeleteRecord(rids[i]);
+    deleted.insert(rids[i]);
+  }
+  // a table written before the free space map existed has no map file
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_TRUE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)));
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, records.size() - deleted.size());
+  // the deleted slots are found again through the rebuilt map
+  for (size_t i = 0; i < deleted.size(); ++i) {
+    auto record = GenRecordUnderSchema(tbl->GetSchema());
+    auto rid    = tbl->InsertRecord(*record);
+    ASSERT_TRUE(deleted.find(rid) != deleted.end());
+  }
+  ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+/// inserts and deletes of concurrent sessions without any lock of their own never share a slot or lose a count
+TEST(TableHandle, ConcurrentInsert)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_concurrent_insert";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  // every thread pins a page of the table and one of the map at a time, which fits in the buffer pool
+  const size_t                     thread_num = 4;
+  const size_t                     rec_num    = 2000;
+  std::vector<std::vector<Record>> records(thread_num);
+  for (auto &thread_records : records) {
+    for (size_t i = 0; i < rec_num; ++i) {
+      thread_records.emplace_back(*GenRecordUnderSchema(tbl->GetSchema()));
+    }
+  }
+  std::vector<std::vector<std::pair<RID, size_t>>> live(thread_num);
+  std::vector<std::thread>                         threads;
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = 0; i < rec_num;) {
+        // single inserts, batches of a few records, and deletes that leave free slots behind
+        if (i % 7 == 6 && i + 3 <= rec_num) {
+          auto rids = tbl->InsertRecords(std::span<const Record>(records[t].data() + i, 3));
+          for (size_t j = 0; j < rids.size(); ++j) {
+            live[t].emplace_back(rids[j], i + j);
+          }
+          i += 3;
+        } else {
+          live[t].emplace_back(tbl->InsertRecord(records[t][i]), i);
+          i++;
+        }
+        if (i % 5 == 0) {
+          tbl->DeleteRecord(live[t].front().first);
+          live[t].erase(live[t].begin());
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::unordered_set<RID> rids;
+  for (size_t t = 0; t < thread_num; ++t) {
+    for (const auto &[rid, idx] : live[t]) {
+      ASSERT_TRUE(rids.insert(rid).second);
+      ASSERT_TRUE(*tbl->GetRecord(rid) == records[t][idx]);
+    }
+  }
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, rids.size());
+  size_t cnt = 0;
+  for (auto rid = tbl->GetFirstRID(); rid != INVALID_RID; rid = tbl->GetNextRID(rid)) {
+    cnt++;
+  }
+  ASSERT_EQ(cnt, rids.size());
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, RecordView)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_record_view";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  std::vector<Record> records;
+  for (size_t i = 0; i < 5 * tbl->GetTableHeader().rec_per_page_ + 3; ++i) {
+    records.emplace_back(*GenRecordUnderSchema(tbl->GetSchema()));
+  }
+  auto rids = tbl->InsertRecords(records);
+  // scan the table with a single guard, every view should match the copied record
+  const auto &hdr = tbl->GetTableHeader();
+  auto        buf = std::make_unique<char[]>(hdr.nullmap_size_ + hdr.rec_size_);
+  PageGuard   guard;
+  size_t      cnt = 0;
+  for (auto rid = tbl->GetFirstRID(); rid != INVALID_RID; rid = tbl->GetNextRID(rid)) {
+    auto view = tbl->GetRecordView(rid, guard, buf.get());
+    ASSERT_EQ(view.GetRID(), rid);
+    ASSERT_EQ(guard.GetPageId(), rid.PageID());
+    ASSERT_TRUE(Record(view) == *tbl->GetRecord(rid));
+    cnt++;
+  }
+  ASSERT_EQ(cnt, records.size());
+  guard.Release();
+  tbl->DeleteRecord(rids.front());
+  ASSERT_THROW(tbl->GetRecordView(rids.front(), guard, buf.get()), WSDBException_);
+  guard.Release();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, PAXChunk)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_pax_chunk";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
+  // 3 int, 3 string and 3 float fields
+  auto tbl_schema = GenTableSchema(11);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, PAX_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, PAX_MODEL);
+  tbl_schema = nullptr;
+  std::vector<Record> records;
+  for (size_t i = 0; i < 3 * tbl->GetTableHeader().rec_per_page_ + 3; ++i) {
+    auto record = GenRecordUnderSchema(tbl->GetSchema());
+    if (i % 5 == 0) {
+      std::vector<ValueSptr> values;
+      for (size_t j = 0; j < tbl->GetSchema().GetFieldCount(); ++j) {
+        values.push_back(j % 2 == 0 ? ValueFactory::CreateNullValue(tbl->GetSchema().GetFieldAt(j).field_.field_type_)
+                                    : record->GetValueAt(j));
+      }
+      record = std::make_unique<Record>(&tbl->GetSchema(), values, INVALID_RID);
+    }
+    records.push_back(*record);
+  }
+  auto rids = tbl->InsertRecords(records);
+  for (size_t i = 0; i < rids.size(); i += 3) {
+    tbl->DeleteRecord(rids[i]);
+  }
+  // read the pages as chunks with the fields in reverse order, every row should match the record of its rid
+  std::vector<RTField> fields(tbl->GetSchema().GetFields().rbegin(), tbl->GetSchema().GetFields().rend());
+  auto                 chunk_schema = std::make_unique<RecordSchema>(fields);
+  std::set<page_id_t>  pages;
+  size_t               rows = 0;
+  for (const auto &rid : rids) {
+    if (!pages.insert(rid.PageID()).second) {
+      continue;
+    }
+    auto chunk = tbl->GetChunk(rid.PageID(), chunk_schema.get());
+    ASSERT_EQ(chunk->GetColCount(), chunk_schema->GetFieldCount());
+    for (size_t row = 0; row < chunk->GetRowCount(); ++row) {
+      auto record = tbl->GetRecord(chunk->GetRID(row));
+      for (size_t col = 0; col < chunk->GetColCount(); ++col) {
+        auto  field_idx = tbl->GetSchema().GetFieldCount() - 1 - col;
+        auto &column    = chunk->GetColumn(col);
+        ASSERT_EQ(column.IsNull(row), record->GetValueAt(field_idx)->IsNull());
+        if (column.IsNull(row)) {
+          continue;
+        }
+        auto field_data = record->GetData() + tbl->GetSchema().GetFieldOffset(field_idx);
+        ASSERT_EQ(memcmp(column.GetFieldData(row), field_data, column.GetWidth()), 0);
+        if (column.GetType() == TYPE_INT) {
+          ASSERT_EQ(column.GetData<int32_t>()[row], *reinterpret_cast<const int32_t *>(field_data));
+        }
+      }
+    }
+    rows += chunk->GetRowCount();
+  }
+  ASSERT_EQ(rows, tbl->GetTableHeader().rec_num_);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, ArenaRecord)
+{
+  auto tbl_schema = GenTableSchema(11);
+  auto heap_rec   = GenRecordUnderSchema(*tbl_schema);
+  ASSERT_EQ(Arena::Current(), nullptr);
+  Arena arena;
+  {
+    ArenaScope scope(&arena);
+    ASSERT_EQ(Arena::Current(), &arena);
+    std::vector<Record> records;
+    for (int i = 0; i < 1000; ++i) {
+      records.emplace_back(*heap_rec);
+    }
+    ASSERT_GE(arena.GetAllocatedBytes(), 1000 * tbl_schema->GetRecordLength());
+    for (const auto &rec : records) {
+      ASSERT_TRUE(rec == *heap_rec);
+    }
+    // values are read back from arena memory as well
+    auto rec = Record(tbl_schema.get(), records.back());
+    for (size_t i = 0; i < tbl_schema->GetFieldCount(); ++i) {
+      ASSERT_EQ(rec.GetValueAt(i)->ToString(), heap_rec->GetValueAt(i)->ToString());
+      ASSERT_EQ(rec.GetScalarAt(i).ToString(), heap_rec->GetValueAt(i)->ToString());
+      ASSERT_TRUE(Scalar::Eval(OP_EQ, rec.GetScalarAt(i), Scalar::FromValue(*heap_rec->GetValueAt(i))));
+    }
+    ASSERT_EQ(Record::Compare(rec, *heap_rec), 0);
+    records.clear();
+  }
+  ASSERT_EQ(Arena::Current(), nullptr);
+  arena.Reset();
+  ASSERT_EQ(arena.GetAllocatedBytes(), 0);
+  Record copy(*heap_rec);
+  ASSERT_TRUE(copy == *heap_rec);
+}
+
+TEST(TableHandle, RecordComparator)
+{
+  auto tbl_schema = GenTableSchema(11);
+  // key on a float, a string and an int field, out of the record's order
+  auto n          = tbl_schema->GetFieldCount();
+  auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{
+      tbl_schema->GetFieldAt(n - 1), tbl_schema->GetFieldAt(n / 2), tbl_schema->GetFieldAt(0)});
+  RecordComparator cmp(key_schema.get(), tbl_schema.get());
+  RecordHasher     hasher(key_schema.get(), tbl_schema.get());
+  RecordComparator key_cmp(key_schema.get(), key_schema.get());
+  RecordHasher     key_hasher(key_schema.get(), key_schema.get());
+  std::vector<RecordUptr> records;
+  for (int i = 0; i < 100; ++i) {
+    records.push_back(GenRecordUnderSchema(*tbl_schema));
+  }
+  records.push_back(std::make_unique<Record>(*records.front()));
+  records.push_back(std::make_unique<Record>(tbl_schema.get()));
+  for (const auto &l : records) {
+    Record lkey(key_schema.get(), *l);
+    ASSERT_EQ(hasher(*l), key_hasher(lkey));
+    for (const auto &r : records) {
+      Record rkey(key_schema.get(), *r);
+      ASSERT_EQ(cmp.Compare(*l, *r), Record::Compare(lkey, rkey));
+      ASSERT_EQ(key_cmp.Compare(lkey, rkey), Record::Compare(lkey, rkey));
+      if (cmp.Equal(*l, *r)) {
+        ASSERT_EQ(hasher(*l), hasher(*r));
+      }
+    }
+  }
+}
+
+TEST(TableHandle, KeyNormalizer)
+{
+  auto tbl_schema = GenTableSchema(11);
+  auto n          = tbl_schema->GetFieldCount();
+  auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{
+      tbl_schema->GetFieldAt(n - 1), tbl_schema->GetFieldAt(n / 2), tbl_schema->GetFieldAt(0)});
+  RecordComparator cmp(key_schema.get(), tbl_schema.get());
+  KeyNormalizer    asc(key_schema.get(), tbl_schema.get());
+  KeyNormalizer    desc(key_schema.get(), tbl_schema.get(), true);
+  std::vector<RecordUptr> records;
+  for (int i = 0; i < 100; ++i) {
+    records.push_back(GenRecordUnderSchema(*tbl_schema));
+  }
+  records.push_back(std::make_unique<Record>(*records.front()));
+  records.push_back(std::make_unique<Record>(tbl_schema.get()));
+  auto sign = [](int v) { return (v > 0) - (v < 0); };
+  // NaN is neither smaller nor larger than anything in the comparator, which goes on with the next key field, while the
+  // normalized keys order it, so keys with a NaN are skipped
+  auto has_nan = [&](const Record &record) {
+    for (auto idx : {n - 1, n / 2, size_t{0}}) {
+      auto value = record.GetScalarAt(idx);
+      if (!value.IsNull() && value.GetType() == TYPE_FLOAT && std::isnan(value.GetFloat())) {
+        return true;
+      }
+    }
+    return false;
+  };
+  auto lkey = std::make_unique<char[]>(asc.GetKeySize());
+  auto rkey = std::make_unique<char[]>(asc.GetKeySize());
+  for (const auto &l : records) {
+    for (const auto &r : records) {
+      if (has_nan(*l) || has_nan(*r)) {
+        continue;
+      }
+      auto expected = cmp.Compare(*l, *r);
+      asc.Encode(*l, lkey.get());
+      asc.Encode(*r, rkey.get());
+      if (expected != 0 || asc.Compare(lkey.get(), rkey.get()) == 0) {
+        ASSERT_EQ(sign(asc.Compare(lkey.get(), rkey.get())), expected);
+        // prefixes never contradict the full key
+        if (asc.Prefix(lkey.get()) < asc.Prefix(rkey.get())) {
+          ASSERT_LT(expected, 0);
+        }
+      }
+      desc.Encode(*l, lkey.get());
+      desc.Encode(*r, rkey.get());
+      if (expected != 0 || desc.Compare(lkey.get(), rkey.get()) == 0) {
+        ASSERT_EQ(sign(desc.Compare(lkey.get(), rkey.get())), -expected);
+      }
+    }
+  }
+}
+
 TEST(TableHandle, MultiThread)
 {
   auto        disk_manager        = std::make_unique<DiskManager>();
@@ -116,6 +567,8 @@ TEST(TableHandle, MultiThread)
     std::filesystem::create_directory(TEST_DIR);
   if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
     std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
   auto tbl_schema = GenTableSchema(10);
   table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
   auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
@@ -199,6 +652,8 @@ TEST(TableHandle, PAX_MultiThread)
     std::filesystem::create_directory(TEST_DIR);
   if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
     std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, FSM_SUFFIX));
   auto tbl_schema = GenTableSchema(10);
   table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, PAX_MODEL);
   auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, PAX_MODEL);